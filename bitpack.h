@@ -0,0 +1,315 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_BITPACK_H_
+#define DIMSUM_BITPACK_H_
+
+#include <cstddef>
+#include <type_traits>
+
+#include "dimsum.h"
+#include "index_sequence.h"
+
+// Bit packing of blocks of 128 uint32 values at a fixed width of 0 to 32
+// bits, in the vertical layout of SIMD-BP128 (Lemire and Boytsov, "Decoding
+// billions of integers per second through vectorization").
+//
+// Value i of a block goes to uint32 lane i % 4, and each lane packs its 32
+// values one after the other, starting from the low bits of its first word:
+// lane words are interleaved, so that word j of lane l is out[4 * j + l]. A
+// block takes 4 * bits words. Packing and unpacking are one Simd128<uint32>
+// shift and mask per 4 values, with all shifts known at compile time; the
+// layout does not depend on the native SIMD width, so packed data can be
+// persisted.
+//
+// The _for variants store values minus a base (frame of reference). The
+// _delta variants store the difference of each value and the one 4 positions
+// earlier, so that decoding is a vertical add rather than a prefix sum; the 4
+// values before a block are passed in, and the last 4 are returned to chain
+// blocks.
+//
+// Unpacking either stores to a buffer, or passes each Simd128<uint32> of 4
+// consecutive values to a callback, which can evaluate predicates without a
+// round trip through memory.
+
+namespace dimsum {
+
+constexpr size_t kBitPackBlockSize = 128;
+
+// Returns the number of uint32 words of a block packed at bits.
+constexpr size_t bitpacked_words(int bits) { return 4 * bits; }
+
+namespace detail {
+
+using BitPackValues = Simd128<uint32>;
+
+struct BitPackIdentity {
+  BitPackValues Encode(BitPackValues v) { return v; }
+  BitPackValues Decode(BitPackValues v) { return v; }
+};
+
+struct BitPackOffset {
+  BitPackValues base;
+
+  BitPackValues Encode(BitPackValues v) { return v - base; }
+  BitPackValues Decode(BitPackValues v) { return v + base; }
+};
+
+struct BitPackDelta {
+  BitPackValues prev;
+
+  BitPackValues Encode(BitPackValues v) {
+    BitPackValues delta = v - prev;
+    prev = v;
+    return delta;
+  }
+  BitPackValues Decode(BitPackValues v) { return prev += v; }
+};
+
+constexpr uint32 BitPackMask(int bits) {
+  return bits == 32 ? ~uint32{0} : (uint32{1} << bits) - 1;
+}
+
+// Packs a block one step of 4 values at a time, filling the current word of
+// every lane in acc_ and storing it once it is full.
+template <int kBits, typename Transform>
+class BitPacker {
+ public:
+  BitPacker(const uint32* in, Transform* transform, uint32* out)
+      : in_(in), transform_(transform), out_(out) {}
+
+  template <size_t... indices>
+  void Run(dimsum::index_sequence<indices...>) {
+    int steps[] = {(Step<indices>(), 0)...};
+    (void)steps;
+  }
+
+ private:
+  template <size_t kIndex>
+  void Step() {
+    constexpr int kShift = kIndex * kBits % 32;
+    constexpr size_t kWord = kIndex * kBits / 32;
+    BitPackValues v = transform_->Encode(
+        LoadUnaligned<BitPackValues>(in_ + 4 * kIndex));
+    if (kBits == 0) return;
+    if (kBits < 32) v &= BitPackValues(BitPackMask(kBits));
+    acc_ = kShift == 0 ? v : acc_ | v << kShift;
+    if (kShift + kBits >= 32) {
+      StoreUnaligned(acc_, out_ + 4 * kWord);
+      // The part of v that did not fit starts the next word.
+      if (kShift + kBits > 32) acc_ = v >> (32 - kShift) % 32;
+    }
+  }
+
+  const uint32* in_;
+  Transform* transform_;
+  uint32* out_;
+  BitPackValues acc_;
+};
+
+// Unpacks a block one step of 4 values at a time. Each word is loaded once,
+// into word_, when the previous one is used up.
+template <int kBits, typename Transform, typename Visit>
+class BitUnpacker {
+ public:
+  BitUnpacker(const uint32* in, Transform* transform, Visit* visit)
+      : in_(in), transform_(transform), visit_(visit) {
+    if (kBits > 0) word_ = LoadUnaligned<BitPackValues>(in);
+  }
+
+  template <size_t... indices>
+  void Run(dimsum::index_sequence<indices...>) {
+    int steps[] = {(Step<indices>(), 0)...};
+    (void)steps;
+  }
+
+ private:
+  template <size_t kIndex>
+  void Step() {
+    constexpr int kShift = kIndex * kBits % 32;
+    constexpr size_t kWord = kIndex * kBits / 32;
+    BitPackValues v = kBits == 0 ? BitPackValues(0) : word_ >> kShift;
+    if (kShift + kBits >= 32 && kWord + 1 < kBits) {
+      word_ = LoadUnaligned<BitPackValues>(in_ + 4 * (kWord + 1));
+      if (kShift + kBits > 32) v |= word_ << (32 - kShift) % 32;
+    }
+    if (kBits < 32) v &= BitPackValues(BitPackMask(kBits));
+    (*visit_)(transform_->Decode(v));
+  }
+
+  const uint32* in_;
+  Transform* transform_;
+  Visit* visit_;
+  BitPackValues word_;
+};
+
+template <int kBits, typename Transform>
+void BitPackBlock(const uint32* in, Transform* transform, uint32* out) {
+  static_assert(0 <= kBits && kBits <= 32, "bits must be in [0, 32]");
+  BitPacker<kBits, Transform>(in, transform, out)
+      .Run(dimsum::make_index_sequence<kBitPackBlockSize / 4>());
+}
+
+template <int kBits, typename Transform, typename Visit>
+void BitUnpackBlock(const uint32* in, Transform* transform, Visit* visit) {
+  static_assert(0 <= kBits && kBits <= 32, "bits must be in [0, 32]");
+  BitUnpacker<kBits, Transform, Visit>(in, transform, visit)
+      .Run(dimsum::make_index_sequence<kBitPackBlockSize / 4>());
+}
+
+// Stores each step of an unpacked block to consecutive values of out_.
+struct BitUnpackStore {
+  void operator()(BitPackValues v) {
+    StoreUnaligned(v, out_);
+    out_ += 4;
+  }
+
+  uint32* out_;
+};
+
+// Enables the callback overloads of bitunpack, which would otherwise also
+// match a uint32* out.
+template <typename Visit>
+using EnableIfBitUnpackVisit = typename std::enable_if<
+    !std::is_pointer<typename std::decay<Visit>::type>::value>::type;
+
+// The bit widths [0, 32] as a template argument, for dispatching on a width
+// known only at run time.
+using BitPackWidths = dimsum::make_index_sequence<33>;
+
+}  // namespace detail
+
+// Packs kBitPackBlockSize values of in at kBits bits per value to
+// bitpacked_words(kBits) words of out. Bits of the values above kBits are
+// dropped.
+template <int kBits>
+void bitpack(const uint32* in, uint32* out) {
+  detail::BitPackIdentity transform;
+  detail::BitPackBlock<kBits>(in, &transform, out);
+}
+
+// Packs in[i] - base. All values must be at least base.
+template <int kBits>
+void bitpack_for(const uint32* in, uint32 base, uint32* out) {
+  detail::BitPackOffset transform{detail::BitPackValues(base)};
+  detail::BitPackBlock<kBits>(in, &transform, out);
+}
+
+// Packs in[i] - in[i - 4], where in[-4, 0) are the lanes of prev. Returns the
+// last 4 values of in, which are prev for the next block.
+template <int kBits>
+Simd128<uint32> bitpack_delta(const uint32* in, Simd128<uint32> prev,
+                              uint32* out) {
+  detail::BitPackDelta transform{prev};
+  detail::BitPackBlock<kBits>(in, &transform, out);
+  return transform.prev;
+}
+
+// Unpacks the kBitPackBlockSize values packed by bitpack<kBits> to out.
+template <int kBits>
+void bitunpack(const uint32* in, uint32* out) {
+  detail::BitPackIdentity transform;
+  detail::BitUnpackStore store{out};
+  detail::BitUnpackBlock<kBits>(in, &transform, &store);
+}
+
+// Calls visit(Simd128<uint32>) with values [4 * i, 4 * i + 4) of the block,
+// for i in [0, kBitPackBlockSize / 4) in order.
+template <int kBits, typename Visit,
+          typename = detail::EnableIfBitUnpackVisit<Visit>>
+void bitunpack(const uint32* in, Visit&& visit) {
+  detail::BitPackIdentity transform;
+  detail::BitUnpackBlock<kBits>(in, &transform, &visit);
+}
+
+template <int kBits>
+void bitunpack_for(const uint32* in, uint32 base, uint32* out) {
+  detail::BitPackOffset transform{detail::BitPackValues(base)};
+  detail::BitUnpackStore store{out};
+  detail::BitUnpackBlock<kBits>(in, &transform, &store);
+}
+
+template <int kBits, typename Visit,
+          typename = detail::EnableIfBitUnpackVisit<Visit>>
+void bitunpack_for(const uint32* in, uint32 base, Visit&& visit) {
+  detail::BitPackOffset transform{detail::BitPackValues(base)};
+  detail::BitUnpackBlock<kBits>(in, &transform, &visit);
+}
+
+// Returns the last 4 values, which are prev for the next block.
+template <int kBits>
+Simd128<uint32> bitunpack_delta(const uint32* in, Simd128<uint32> prev,
+                                uint32* out) {
+  detail::BitPackDelta transform{prev};
+  detail::BitUnpackStore store{out};
+  detail::BitUnpackBlock<kBits>(in, &transform, &store);
+  return transform.prev;
+}
+
+template <int kBits, typename Visit,
+          typename = detail::EnableIfBitUnpackVisit<Visit>>
+Simd128<uint32> bitunpack_delta(const uint32* in, Simd128<uint32> prev,
+                                Visit&& visit) {
+  detail::BitPackDelta transform{prev};
+  detail::BitUnpackBlock<kBits>(in, &transform, &visit);
+  return transform.prev;
+}
+
+// Returns the smallest width at which bitpack keeps all values of a block.
+inline int bitpack_width(const uint32* in) {
+  Simd128<uint32> bits(0);
+  for (size_t i = 0; i < kBitPackBlockSize; i += 4) {
+    bits |= detail::LoadUnaligned<Simd128<uint32>>(in + i);
+  }
+  const uint32 any = bits[0] | bits[1] | bits[2] | bits[3];
+  return any == 0 ? 0 : 32 - __builtin_clz(any);
+}
+
+namespace detail {
+
+template <size_t... kBits>
+void BitPackDispatch(int bits, const uint32* in, uint32 base, uint32* out,
+                     dimsum::index_sequence<kBits...>) {
+  using Pack = void (*)(const uint32*, uint32, uint32*);
+  static const Pack kPack[] = {&bitpack_for<kBits>...};
+  kPack[bits](in, base, out);
+}
+
+template <size_t... kBits>
+void BitUnpackDispatch(int bits, const uint32* in, uint32 base, uint32* out,
+                       dimsum::index_sequence<kBits...>) {
+  using Unpack = void (*)(const uint32*, uint32, uint32*);
+  static const Unpack kUnpack[] = {&bitunpack_for<kBits>...};
+  kUnpack[bits](in, base, out);
+}
+
+}  // namespace detail
+
+// The same as bitpack_for<bits> and bitunpack_for<bits>, for a width in
+// [0, 32] chosen at run time, e.g. by bitpack_width.
+inline void bitpack_for(int bits, const uint32* in, uint32 base,
+                        uint32* out) {
+  detail::BitPackDispatch(bits, in, base, out, detail::BitPackWidths());
+}
+
+inline void bitunpack_for(int bits, const uint32* in, uint32 base,
+                          uint32* out) {
+  detail::BitUnpackDispatch(bits, in, base, out, detail::BitPackWidths());
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_BITPACK_H_
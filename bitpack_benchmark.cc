@@ -0,0 +1,169 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "bitpack.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kNumBlocks = 256;
+constexpr size_t kNumValues = kNumBlocks * kBitPackBlockSize;
+
+std::vector<uint32> RandomValues(int bits) {
+  std::mt19937 gen(0);
+  std::vector<uint32> values(kNumValues);
+  for (uint32& value : values) value = gen() & detail::BitPackMask(bits);
+  return values;
+}
+
+template <int kBits>
+std::vector<uint32> Packed(const std::vector<uint32>& values) {
+  std::vector<uint32> packed(kNumBlocks * bitpacked_words(kBits));
+  for (size_t block = 0; block < kNumBlocks; block++) {
+    bitpack<kBits>(values.data() + block * kBitPackBlockSize,
+                   packed.data() + block * bitpacked_words(kBits));
+  }
+  return packed;
+}
+
+// The horizontal layout (value i at bit i * bits), unpacked one value at a
+// time.
+void ScalarUnpack(const uint32* in, int bits, size_t n, uint32* out) {
+  const uint64 mask = detail::BitPackMask(bits);
+  for (size_t i = 0; i < n; i++) {
+    const size_t bit = i * bits;
+    uint64 word;
+    memcpy(&word, reinterpret_cast<const char*>(in) + bit / 8, sizeof(word));
+    out[i] = word >> bit % 8 & mask;
+  }
+}
+
+template <int kBits>
+void BM_ScalarUnpack(benchmark::State& state) {
+  // ScalarUnpack reads up to 8 bytes at a time.
+  std::vector<uint32> packed(kNumValues * kBits / 32 + 2);
+  std::vector<uint32> out(kNumValues);
+  for (auto _ : state) {
+    ScalarUnpack(packed.data(), kBits, kNumValues, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_ScalarUnpack, 1);
+BENCHMARK_TEMPLATE(BM_ScalarUnpack, 7);
+BENCHMARK_TEMPLATE(BM_ScalarUnpack, 13);
+BENCHMARK_TEMPLATE(BM_ScalarUnpack, 24);
+
+template <int kBits>
+void BM_BitPack(benchmark::State& state) {
+  std::vector<uint32> values = RandomValues(kBits);
+  std::vector<uint32> packed(kNumBlocks * bitpacked_words(kBits));
+  for (auto _ : state) {
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      bitpack<kBits>(values.data() + block * kBitPackBlockSize,
+                     packed.data() + block * bitpacked_words(kBits));
+    }
+    benchmark::DoNotOptimize(packed.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_BitPack, 1);
+BENCHMARK_TEMPLATE(BM_BitPack, 7);
+BENCHMARK_TEMPLATE(BM_BitPack, 13);
+BENCHMARK_TEMPLATE(BM_BitPack, 24);
+
+template <int kBits>
+void BM_BitUnpack(benchmark::State& state) {
+  std::vector<uint32> packed = Packed<kBits>(RandomValues(kBits));
+  std::vector<uint32> out(kNumValues);
+  for (auto _ : state) {
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      bitunpack<kBits>(packed.data() + block * bitpacked_words(kBits),
+                       out.data() + block * kBitPackBlockSize);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_BitUnpack, 1);
+BENCHMARK_TEMPLATE(BM_BitUnpack, 7);
+BENCHMARK_TEMPLATE(BM_BitUnpack, 13);
+BENCHMARK_TEMPLATE(BM_BitUnpack, 24);
+
+template <int kBits>
+void BM_BitUnpackDelta(benchmark::State& state) {
+  std::vector<uint32> packed = Packed<kBits>(RandomValues(kBits));
+  std::vector<uint32> out(kNumValues);
+  for (auto _ : state) {
+    Simd128<uint32> prev(0);
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      prev = bitunpack_delta<kBits>(
+          packed.data() + block * bitpacked_words(kBits), prev,
+          out.data() + block * kBitPackBlockSize);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_BitUnpackDelta, 7);
+BENCHMARK_TEMPLATE(BM_BitUnpackDelta, 13);
+
+// Counts the values below a threshold: unpacked to a buffer first, or
+// compared in registers by a callback.
+template <int kBits>
+void BM_CountBelowBuffered(benchmark::State& state) {
+  std::vector<uint32> packed = Packed<kBits>(RandomValues(kBits));
+  const uint32 threshold = detail::BitPackMask(kBits) / 3;
+  uint32 buffer[kBitPackBlockSize];
+  for (auto _ : state) {
+    size_t count = 0;
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      bitunpack_for<kBits>(packed.data() + block * bitpacked_words(kBits),
+                           1000, buffer);
+      for (uint32 value : buffer) count += value < threshold + 1000;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_CountBelowBuffered, 7);
+BENCHMARK_TEMPLATE(BM_CountBelowBuffered, 13);
+
+template <int kBits>
+void BM_CountBelowVisit(benchmark::State& state) {
+  std::vector<uint32> packed = Packed<kBits>(RandomValues(kBits));
+  const Simd128<uint32> threshold(detail::BitPackMask(kBits) / 3 + 1000);
+  for (auto _ : state) {
+    // Each lane counts down by one per match.
+    Simd128<int32> counts(0);
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      bitunpack_for<kBits>(packed.data() + block * bitpacked_words(kBits),
+                           1000, [&](Simd128<uint32> v) {
+                             counts += bit_cast<int32>(cmp_lt(v, threshold));
+                           });
+    }
+    benchmark::DoNotOptimize(reduce_add(counts));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_CountBelowVisit, 7);
+BENCHMARK_TEMPLATE(BM_CountBelowVisit, 13);
+
+}  // namespace
+}  // namespace dimsum
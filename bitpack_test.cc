@@ -0,0 +1,187 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bitpack.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+std::vector<uint32> RandomBlock(int bits, std::mt19937* gen) {
+  std::vector<uint32> values(kBitPackBlockSize);
+  for (uint32& value : values) value = (*gen)() & detail::BitPackMask(bits);
+  return values;
+}
+
+// The layout of bitpack, one bit at a time.
+std::vector<uint32> ScalarBitPack(const std::vector<uint32>& values,
+                                  int bits) {
+  std::vector<uint32> out(bitpacked_words(bits));
+  for (size_t i = 0; i < values.size(); i++) {
+    const size_t lane = i % 4;
+    for (int b = 0; b < bits; b++) {
+      const size_t bit = i / 4 * bits + b;
+      if (values[i] >> b & 1) out[4 * (bit / 32) + lane] |= 1u << bit % 32;
+    }
+  }
+  return out;
+}
+
+std::vector<uint32> Stored(const Simd128<uint32>& v) {
+  uint32 lanes[4];
+  detail::StoreUnaligned(v, lanes);
+  return std::vector<uint32>(lanes, lanes + 4);
+}
+
+template <int kBits>
+void CheckRoundTrip(std::mt19937* gen) {
+  SCOPED_TRACE(kBits);
+  std::vector<uint32> values = RandomBlock(kBits, gen);
+  std::vector<uint32> packed(bitpacked_words(kBits) + 1, 0xdeadbeef);
+  bitpack<kBits>(values.data(), packed.data());
+  // Nothing is written past the packed block.
+  EXPECT_EQ(0xdeadbeef, packed.back());
+  packed.pop_back();
+  EXPECT_EQ(ScalarBitPack(values, kBits), packed);
+  EXPECT_LE(bitpack_width(values.data()), kBits);
+
+  std::vector<uint32> unpacked(kBitPackBlockSize);
+  bitunpack<kBits>(packed.data(), unpacked.data());
+  EXPECT_EQ(values, unpacked);
+
+  std::vector<uint32> visited;
+  bitunpack<kBits>(packed.data(), [&](Simd128<uint32> v) {
+    std::vector<uint32> lanes = Stored(v);
+    visited.insert(visited.end(), lanes.begin(), lanes.end());
+  });
+  EXPECT_EQ(values, visited);
+}
+
+template <size_t... kBits>
+void CheckAllRoundTrips(std::mt19937* gen, dimsum::index_sequence<kBits...>) {
+  int checks[] = {(CheckRoundTrip<kBits>(gen), 0)...};
+  (void)checks;
+}
+
+TEST(BitPackTest, RoundTrip) {
+  std::mt19937 gen(0);
+  for (int i = 0; i < 10; i++) {
+    CheckAllRoundTrips(&gen, detail::BitPackWidths());
+  }
+}
+
+TEST(BitPackTest, DropsHighBits) {
+  std::vector<uint32> values(kBitPackBlockSize);
+  for (size_t i = 0; i < values.size(); i++) values[i] = 0xfffffff0u | i % 16;
+  std::vector<uint32> packed(bitpacked_words(4));
+  bitpack<4>(values.data(), packed.data());
+  std::vector<uint32> unpacked(kBitPackBlockSize);
+  bitunpack<4>(packed.data(), unpacked.data());
+  for (size_t i = 0; i < values.size(); i++) {
+    EXPECT_EQ(i % 16, unpacked[i]) << i;
+  }
+}
+
+TEST(BitPackTest, Width) {
+  std::vector<uint32> values(kBitPackBlockSize, 0);
+  EXPECT_EQ(0, bitpack_width(values.data()));
+  values[77] = 1;
+  EXPECT_EQ(1, bitpack_width(values.data()));
+  values[3] = 1000;
+  EXPECT_EQ(10, bitpack_width(values.data()));
+  values[127] = 0x80000000u;
+  EXPECT_EQ(32, bitpack_width(values.data()));
+}
+
+TEST(BitPackTest, FrameOfReference) {
+  std::mt19937 gen(0);
+  const uint32 base = 1000000007;
+  std::vector<uint32> values = RandomBlock(11, &gen);
+  for (uint32& value : values) value += base;
+  std::vector<uint32> packed(bitpacked_words(11));
+  bitpack_for<11>(values.data(), base, packed.data());
+
+  std::vector<uint32> unpacked(kBitPackBlockSize);
+  bitunpack_for<11>(packed.data(), base, unpacked.data());
+  EXPECT_EQ(values, unpacked);
+
+  std::vector<uint32> visited;
+  bitunpack_for<11>(packed.data(), base, [&](Simd128<uint32> v) {
+    std::vector<uint32> lanes = Stored(v);
+    visited.insert(visited.end(), lanes.begin(), lanes.end());
+  });
+  EXPECT_EQ(values, visited);
+
+  // The same, with the width chosen at run time.
+  std::vector<uint32> offsets(values);
+  for (uint32& offset : offsets) offset -= base;
+  const int bits = bitpack_width(offsets.data());
+  EXPECT_LE(bits, 11);
+  std::vector<uint32> packed_dynamic(bitpacked_words(bits));
+  bitpack_for(bits, values.data(), base, packed_dynamic.data());
+  std::fill(unpacked.begin(), unpacked.end(), 0);
+  bitunpack_for(bits, packed_dynamic.data(), base, unpacked.data());
+  EXPECT_EQ(values, unpacked);
+
+  // A constant block packs to nothing.
+  std::vector<uint32> constant(kBitPackBlockSize, base);
+  bitpack_for(0, constant.data(), base, nullptr);
+  bitunpack_for(0, nullptr, base, unpacked.data());
+  EXPECT_EQ(constant, unpacked);
+}
+
+TEST(BitPackTest, Delta) {
+  std::mt19937 gen(0);
+  // Three blocks of increasing values, with gaps of less than 2^7.
+  std::vector<uint32> values(3 * kBitPackBlockSize);
+  uint32 value = 12345;
+  for (uint32& v : values) v = value += gen() % 32;
+
+  std::vector<uint32> packed(3 * bitpacked_words(7));
+  Simd128<uint32> prev(12345);
+  for (int block = 0; block < 3; block++) {
+    prev = bitpack_delta<7>(values.data() + block * kBitPackBlockSize, prev,
+                            packed.data() + block * bitpacked_words(7));
+  }
+  EXPECT_EQ(std::vector<uint32>(values.end() - 4, values.end()), Stored(prev));
+
+  std::vector<uint32> unpacked(values.size());
+  prev = Simd128<uint32>(12345);
+  for (int block = 0; block < 3; block++) {
+    prev = bitunpack_delta<7>(packed.data() + block * bitpacked_words(7),
+                              prev,
+                              unpacked.data() + block * kBitPackBlockSize);
+  }
+  EXPECT_EQ(values, unpacked);
+
+  std::vector<uint32> visited;
+  prev = Simd128<uint32>(12345);
+  for (int block = 0; block < 3; block++) {
+    prev = bitunpack_delta<7>(packed.data() + block * bitpacked_words(7),
+                              prev, [&](Simd128<uint32> v) {
+                                std::vector<uint32> lanes = Stored(v);
+                                visited.insert(visited.end(), lanes.begin(),
+                                               lanes.end());
+                              });
+  }
+  EXPECT_EQ(values, visited);
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -8746,4 +8746,64 @@ float hmax_8(TestedSimd<float> a) { return hmax(a); }
 // CHECK-AVX2-128-NEXT:    retq
 double hmax_9(TestedSimd<double> a) { return hmax(a); }
 
+// CHECK-SSE42-LABEL: bit_cast_0:
+// CHECK-SSE42:       # %bb.0:
+// CHECK-SSE42-NEXT:    retq
+//
+// CHECK-AVX2-LABEL: bit_cast_0:
+// CHECK-AVX2:       # %bb.0:
+// CHECK-AVX2-NEXT:    retq
+//
+// CHECK-AVX2-128-LABEL: bit_cast_0:
+// CHECK-AVX2-128:       # %bb.0:
+// CHECK-AVX2-128-NEXT:    retq
+TestedSimd<uint32> bit_cast_0(TestedSimd<float> a) {
+  return bit_cast<uint32>(a);
+}
+
+// CHECK-SSE42-LABEL: bit_cast_1:
+// CHECK-SSE42:       # %bb.0:
+// CHECK-SSE42-NEXT:    retq
+//
+// CHECK-AVX2-LABEL: bit_cast_1:
+// CHECK-AVX2:       # %bb.0:
+// CHECK-AVX2-NEXT:    retq
+//
+// CHECK-AVX2-128-LABEL: bit_cast_1:
+// CHECK-AVX2-128:       # %bb.0:
+// CHECK-AVX2-128-NEXT:    retq
+TestedSimd<uint8> bit_cast_1(TestedSimd<double> a) {
+  return bit_cast<uint8>(a);
+}
+
+// CHECK-SSE42-LABEL: bit_cast_2:
+// CHECK-SSE42:       # %bb.0:
+// CHECK-SSE42-NEXT:    retq
+//
+// CHECK-AVX2-LABEL: bit_cast_2:
+// CHECK-AVX2:       # %bb.0:
+// CHECK-AVX2-NEXT:    retq
+//
+// CHECK-AVX2-128-LABEL: bit_cast_2:
+// CHECK-AVX2-128:       # %bb.0:
+// CHECK-AVX2-128-NEXT:    retq
+TestedSimd<float> bit_cast_2(TestedSimd<int64> a) {
+  return bit_cast<float>(a);
+}
+
+// CHECK-SSE42-LABEL: bit_cast_3:
+// CHECK-SSE42:       # %bb.0:
+// CHECK-SSE42-NEXT:    retq
+//
+// CHECK-AVX2-LABEL: bit_cast_3:
+// CHECK-AVX2:       # %bb.0:
+// CHECK-AVX2-NEXT:    retq
+//
+// CHECK-AVX2-128-LABEL: bit_cast_3:
+// CHECK-AVX2-128:       # %bb.0:
+// CHECK-AVX2-128-NEXT:    retq
+TestedSimd<double> bit_cast_3(TestedSimd<uint8> a) {
+  return bit_cast<double>(a);
+}
+
 }
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_CRC32C_H_
+#define DIMSUM_CRC32C_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_2__)
+# include <nmmintrin.h>
+#endif
+
+// CRC-32C (Castagnoli), as used by iSCSI, ext4 and many storage formats.
+//
+// Long inputs are folded with x86::clmul: four streams of 128-bit (or 256-bit
+// with VPCLMULQDQ) blocks are multiplied forward by x^D mod P and XORed into
+// the blocks D bits later, until 16 bytes remain. Those, short inputs and
+// tails are processed 8 bytes at a time with the SSE4.2 crc32 instruction, or
+// slice-by-8 tables when it is not available.
+//
+// Bytes are in the reflected bit order of the CRC: bit 0 of byte 0 is the
+// highest degree coefficient of the message polynomial.
+
+namespace dimsum {
+namespace detail {
+
+// The CRC-32C polynomial, without the x^32 term.
+constexpr uint32 kCrc32cPoly = 0x1edc6f41;
+
+// Returns x^n mod P, with bit i holding the coefficient of x^i.
+inline uint32 Crc32cXPowMod(int n) {
+  uint64 r = 1;
+  for (int i = 0; i < n; i++) {
+    r <<= 1;
+    if (r >> 32) r ^= uint64{1} << 32 | kCrc32cPoly;
+  }
+  return static_cast<uint32>(r);
+}
+
+inline uint32 ReverseBits32(uint32 x) {
+  x = (x >> 1 & 0x55555555) | (x & 0x55555555) << 1;
+  x = (x >> 2 & 0x33333333) | (x & 0x33333333) << 2;
+  x = (x >> 4 & 0x0f0f0f0f) | (x & 0x0f0f0f0f) << 4;
+  return __builtin_bswap32(x);
+}
+
+#if defined(DIMSUM_HAS_NATIVE_CLMUL) && defined(__VPCLMULQDQ__) && \
+    defined(__AVX2__)
+using Crc32cBlock = Simd256<uint64>;
+#else
+using Crc32cBlock = Simd128<uint64>;
+#endif
+
+constexpr size_t kCrc32cStreams = 4;
+constexpr size_t kCrc32cChunk = kCrc32cStreams * sizeof(Crc32cBlock);
+
+// Folding constants for a distance of bits: lane 0 is multiplied with the low
+// (first) 64 bits of a 128-bit segment, lane 1 with the high 64 bits.
+//
+// As reflected 64-bit values, clmul(a, k) is x * a(x) * k(x). Folding the
+// segment a_lo * x^64 + a_hi forward by D bits multiplies it by x^D, so
+// k_lo = x^(D + 63) mod P and k_hi = x^(D - 1) mod P, bit-reflected into the
+// top 32 bits of the lane.
+inline Crc32cBlock Crc32cFoldConstants(int bits) {
+  uint64 lo = uint64{ReverseBits32(Crc32cXPowMod(bits + 63))} << 32;
+  uint64 hi = uint64{ReverseBits32(Crc32cXPowMod(bits - 1))} << 32;
+  return Crc32cBlock([lo, hi](int i) { return i % 2 ? hi : lo; });
+}
+
+// Returns the 128-bit segment of block that starts at lane i.
+inline Simd128<uint64> Crc32cSegment(Crc32cBlock block, size_t i) {
+  return Simd128<uint64>([&block, i](int j) -> uint64 { return block[i + j]; });
+}
+
+struct Crc32cTables {
+  // Slice-by-8 tables: table[k][b] is the CRC of byte b followed by k zero
+  // bytes.
+  uint32 table[8][256];
+  // Folds by kCrc32cChunk and by one Crc32cBlock.
+  Crc32cBlock fold_chunk;
+  Crc32cBlock fold_block;
+  // Folds by 128 bits, on the low segment.
+  Simd128<uint64> fold_128;
+};
+
+inline const Crc32cTables& GetCrc32cTables() {
+  static const Crc32cTables tables = [] {
+    Crc32cTables t;
+    const uint32 reflected_poly = ReverseBits32(kCrc32cPoly);
+    for (int b = 0; b < 256; b++) {
+      uint32 crc = b;
+      for (int i = 0; i < 8; i++) {
+        crc = crc >> 1 ^ (crc & 1 ? reflected_poly : 0);
+      }
+      t.table[0][b] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+      for (int b = 0; b < 256; b++) {
+        uint32 prev = t.table[k - 1][b];
+        t.table[k][b] = prev >> 8 ^ t.table[0][prev & 0xff];
+      }
+    }
+    t.fold_chunk = Crc32cFoldConstants(kCrc32cChunk * 8);
+    t.fold_block = Crc32cFoldConstants(sizeof(Crc32cBlock) * 8);
+    t.fold_128 = Crc32cSegment(Crc32cFoldConstants(128), 0);
+    return t;
+  }();
+  return tables;
+}
+
+inline uint64 LoadWord(const char* p) {
+  uint64 word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+// Returns the CRC of the little-endian word, continuing from crc. No
+// inversions are applied.
+inline uint32 Crc32cWord(uint32 crc, uint64 word) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_2__)
+  return _mm_crc32_u64(crc, word);
+#else
+  const auto& t = GetCrc32cTables().table;
+  word ^= crc;
+  return t[7][word & 0xff] ^ t[6][word >> 8 & 0xff] ^
+         t[5][word >> 16 & 0xff] ^ t[4][word >> 24 & 0xff] ^
+         t[3][word >> 32 & 0xff] ^ t[2][word >> 40 & 0xff] ^
+         t[1][word >> 48 & 0xff] ^ t[0][word >> 56];
+#endif
+}
+
+inline uint32 Crc32cByte(uint32 crc, uint8 byte) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_2__)
+  return _mm_crc32_u8(crc, byte);
+#else
+  return crc >> 8 ^ GetCrc32cTables().table[0][(crc ^ byte) & 0xff];
+#endif
+}
+
+// Returns the CRC of [data, data + size), continuing from crc, 8 bytes at a
+// time. No inversions are applied.
+inline uint32 Crc32cSerial(uint32 crc, const char* data, size_t size) {
+  const char* end = data + size;
+  for (; end - data >= 8; data += 8) crc = Crc32cWord(crc, LoadWord(data));
+  for (; data < end; data++) crc = Crc32cByte(crc, *data);
+  return crc;
+}
+
+inline Crc32cBlock Crc32cFold(Crc32cBlock x, Crc32cBlock constants) {
+  return x86::clmul<0, 0>(x, constants) ^ x86::clmul<1, 1>(x, constants);
+}
+
+// Folding only pays off for inputs of a few chunks.
+constexpr size_t kCrc32cFoldThreshold = 4 * kCrc32cChunk;
+
+// Same as Crc32cSerial, for size >= kCrc32cFoldThreshold.
+inline uint32 Crc32cFolded(uint32 crc, const char* data, size_t size) {
+  const Crc32cTables& tables = GetCrc32cTables();
+  const char* end = data + size;
+  constexpr size_t kBlock = sizeof(Crc32cBlock);
+  static_assert(kCrc32cStreams == 4, "The streams are unrolled below");
+  // The streams are separate variables: GCC keeps an array of them in memory.
+  Crc32cBlock x0 = LoadUnaligned<Crc32cBlock>(data);
+  Crc32cBlock x1 = LoadUnaligned<Crc32cBlock>(data + kBlock);
+  Crc32cBlock x2 = LoadUnaligned<Crc32cBlock>(data + 2 * kBlock);
+  Crc32cBlock x3 = LoadUnaligned<Crc32cBlock>(data + 3 * kBlock);
+  // The incoming CRC is XORed into the first 32 bits of the message.
+  x0 ^= Crc32cBlock([crc](int i) { return i == 0 ? uint64{crc} : 0; });
+  data += kCrc32cChunk;
+  for (; end - data >= static_cast<ptrdiff_t>(kCrc32cChunk);
+       data += kCrc32cChunk) {
+    x0 = Crc32cFold(x0, tables.fold_chunk) ^ LoadUnaligned<Crc32cBlock>(data);
+    x1 = Crc32cFold(x1, tables.fold_chunk) ^
+         LoadUnaligned<Crc32cBlock>(data + kBlock);
+    x2 = Crc32cFold(x2, tables.fold_chunk) ^
+         LoadUnaligned<Crc32cBlock>(data + 2 * kBlock);
+    x3 = Crc32cFold(x3, tables.fold_chunk) ^
+         LoadUnaligned<Crc32cBlock>(data + 3 * kBlock);
+  }
+  Crc32cBlock folded = Crc32cFold(x0, tables.fold_block) ^ x1;
+  folded = Crc32cFold(folded, tables.fold_block) ^ x2;
+  folded = Crc32cFold(folded, tables.fold_block) ^ x3;
+  for (; end - data >= static_cast<ptrdiff_t>(kBlock); data += kBlock) {
+    folded = Crc32cFold(folded, tables.fold_block) ^
+             LoadUnaligned<Crc32cBlock>(data);
+  }
+  // Fold the 128-bit segments of the block into the last one.
+  Simd128<uint64> last = Crc32cSegment(folded, 0);
+  for (size_t i = 2; i < Crc32cBlock::size(); i += 2) {
+    last = x86::clmul<0, 0>(last, tables.fold_128) ^
+           x86::clmul<1, 1>(last, tables.fold_128) ^ Crc32cSegment(folded, i);
+  }
+  // The message is now equivalent to the 16 bytes of last, followed by the
+  // tail.
+  crc = Crc32cWord(Crc32cWord(0, last[0]), last[1]);
+  return Crc32cSerial(crc, data, end - data);
+}
+
+// Returns the CRC of [data, data + size), continuing from crc. No inversions
+// are applied.
+inline uint32 Crc32cRaw(uint32 crc, const char* data, size_t size) {
+#ifdef DIMSUM_HAS_NATIVE_CLMUL
+  if (size >= kCrc32cFoldThreshold) return Crc32cFolded(crc, data, size);
+#endif
+  return Crc32cSerial(crc, data, size);
+}
+
+}  // namespace detail
+
+// Returns the CRC-32C of [data, data + size) appended to data whose CRC-32C
+// is crc. crc32c_extend(crc32c(a), b) == crc32c(a + b).
+inline uint32 crc32c_extend(uint32 crc, const char* data, size_t size) {
+  return ~detail::Crc32cRaw(~crc, data, size);
+}
+
+// Returns the CRC-32C of [data, data + size).
+inline uint32 crc32c(const char* data, size_t size) {
+  return crc32c_extend(0, data, size);
+}
+
+// Computes crcs[i] = crc32c(data[i], sizes[i]) for num_buffers independent
+// buffers.
+//
+// A single CRC is a serial dependency chain, so short buffers cannot keep the
+// crc32 instruction busy on their own. Here buffers are processed in groups of
+// four whose words are interleaved, which hides the latency of each step.
+// Buffers long enough to be folded with clmul are processed one at a time.
+inline void crc32c_multi_buffer(const char* const* data, const size_t* sizes,
+                                size_t num_buffers, uint32* crcs) {
+  constexpr size_t kGroup = 4;
+  size_t i = 0;
+  for (; i + kGroup <= num_buffers; i += kGroup) {
+    size_t common = sizes[i];
+    for (size_t j = 1; j < kGroup; j++) {
+      common = sizes[i + j] < common ? sizes[i + j] : common;
+    }
+#ifdef DIMSUM_HAS_NATIVE_CLMUL
+    if (common >= detail::kCrc32cFoldThreshold) {
+      for (size_t j = 0; j < kGroup; j++) {
+        crcs[i + j] = crc32c(data[i + j], sizes[i + j]);
+      }
+      continue;
+    }
+#endif
+    common &= ~size_t{7};
+    uint32 c0 = ~0u, c1 = ~0u, c2 = ~0u, c3 = ~0u;
+    const char *p0 = data[i], *p1 = data[i + 1], *p2 = data[i + 2],
+               *p3 = data[i + 3];
+    for (size_t k = 0; k < common; k += 8) {
+      c0 = detail::Crc32cWord(c0, detail::LoadWord(p0 + k));
+      c1 = detail::Crc32cWord(c1, detail::LoadWord(p1 + k));
+      c2 = detail::Crc32cWord(c2, detail::LoadWord(p2 + k));
+      c3 = detail::Crc32cWord(c3, detail::LoadWord(p3 + k));
+    }
+    const uint32 partial[kGroup] = {c0, c1, c2, c3};
+    for (size_t j = 0; j < kGroup; j++) {
+      crcs[i + j] = ~detail::Crc32cRaw(partial[j], data[i + j] + common,
+                                       sizes[i + j] - common);
+    }
+  }
+  for (; i < num_buffers; i++) crcs[i] = crc32c(data[i], sizes[i]);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_CRC32C_H_
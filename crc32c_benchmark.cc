@@ -0,0 +1,104 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "crc32c.h"
+
+namespace dimsum {
+namespace {
+
+std::string RandomBytes(size_t size) {
+  std::mt19937 rng(0);
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = rng();
+  return bytes;
+}
+
+uint32 TableCrc32c(const char* data, size_t size) {
+  const auto& table = detail::GetCrc32cTables().table[0];
+  uint32 crc = ~0u;
+  for (size_t i = 0; i < size; i++) {
+    crc = crc >> 8 ^ table[(crc ^ static_cast<uint8>(data[i])) & 0xff];
+  }
+  return ~crc;
+}
+
+void BM_TableCrc32c(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TableCrc32c(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_TableCrc32c)->Range(64, 1 << 20);
+
+// The crc32 instruction (or slice-by-8) alone, without folding.
+void BM_SerialCrc32c(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ~detail::Crc32cSerial(~0u, data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_SerialCrc32c)->Range(64, 1 << 20);
+
+void BM_Crc32c(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crc32c(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32c)->Range(64, 1 << 20);
+
+// 64 buffers of state.range(0) bytes, one at a time and all at once.
+constexpr int kNumBuffers = 64;
+
+void BM_Crc32cBuffers(benchmark::State& state) {
+  std::string data = RandomBytes(kNumBuffers * state.range(0));
+  std::vector<uint32> crcs(kNumBuffers);
+  for (auto _ : state) {
+    for (int i = 0; i < kNumBuffers; i++) {
+      crcs[i] = crc32c(data.data() + i * state.range(0), state.range(0));
+    }
+    benchmark::DoNotOptimize(crcs.data());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32cBuffers)->Range(64, 1 << 14);
+
+void BM_Crc32cMultiBuffer(benchmark::State& state) {
+  std::string data = RandomBytes(kNumBuffers * state.range(0));
+  std::vector<const char*> buffers;
+  std::vector<size_t> sizes(kNumBuffers, state.range(0));
+  for (int i = 0; i < kNumBuffers; i++) {
+    buffers.push_back(data.data() + i * state.range(0));
+  }
+  std::vector<uint32> crcs(kNumBuffers);
+  for (auto _ : state) {
+    crc32c_multi_buffer(buffers.data(), sizes.data(), kNumBuffers,
+                        crcs.data());
+    benchmark::DoNotOptimize(crcs.data());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32cMultiBuffer)->Range(64, 1 << 14);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,104 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "crc32c.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Bit at a time reference.
+uint32 ReferenceCrc32c(const std::string& data) {
+  uint32 crc = ~0u;
+  for (char c : data) {
+    crc ^= static_cast<uint8>(c);
+    for (int i = 0; i < 8; i++) crc = crc >> 1 ^ (crc & 1 ? 0x82f63b78 : 0);
+  }
+  return ~crc;
+}
+
+uint32 Crc32c(const std::string& data) {
+  return crc32c(data.data(), data.size());
+}
+
+std::string RandomBytes(size_t size, std::mt19937* rng) {
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = (*rng)();
+  return bytes;
+}
+
+TEST(Crc32cTest, KnownAnswers) {
+  EXPECT_EQ(0u, Crc32c(""));
+  EXPECT_EQ(0xe3069283u, Crc32c("123456789"));
+  // RFC 3720, B.4.
+  EXPECT_EQ(0x8a9136aau, Crc32c(std::string(32, '\0')));
+  EXPECT_EQ(0x62a8ab43u, Crc32c(std::string(32, '\xff')));
+  std::string ascending, descending;
+  for (int i = 0; i < 32; i++) {
+    ascending += static_cast<char>(i);
+    descending += static_cast<char>(31 - i);
+  }
+  EXPECT_EQ(0x46dd794eu, Crc32c(ascending));
+  EXPECT_EQ(0x113fdb5cu, Crc32c(descending));
+}
+
+TEST(Crc32cTest, MatchesReference) {
+  std::mt19937 rng(0);
+  // Sizes around every threshold of the folded path.
+  for (size_t size = 0; size < 2100; size += 1 + size / 16) {
+    std::string data = RandomBytes(size, &rng);
+    EXPECT_EQ(ReferenceCrc32c(data), Crc32c(data)) << size;
+  }
+  std::string large = RandomBytes(1 << 20, &rng);
+  EXPECT_EQ(ReferenceCrc32c(large), Crc32c(large));
+}
+
+TEST(Crc32cTest, Extend) {
+  std::mt19937 rng(0);
+  std::string data = RandomBytes(5000, &rng);
+  for (size_t split : {0, 1, 7, 100, 1000, 4999, 5000}) {
+    uint32 crc = crc32c(data.data(), split);
+    EXPECT_EQ(Crc32c(data),
+              crc32c_extend(crc, data.data() + split, data.size() - split))
+        << split;
+  }
+}
+
+TEST(Crc32cTest, MultiBuffer) {
+  std::mt19937 rng(0);
+  std::vector<std::string> buffers;
+  for (size_t size : {0, 1, 8, 13, 64, 64, 64, 64, 100, 512, 3000, 5000, 4096,
+                      4096, 4096, 4096, 4097, 77}) {
+    buffers.push_back(RandomBytes(size, &rng));
+  }
+  std::vector<const char*> data;
+  std::vector<size_t> sizes;
+  for (const std::string& buffer : buffers) {
+    data.push_back(buffer.data());
+    sizes.push_back(buffer.size());
+  }
+  std::vector<uint32> crcs(buffers.size());
+  crc32c_multi_buffer(data.data(), sizes.data(), buffers.size(), crcs.data());
+  for (size_t i = 0; i < buffers.size(); i++) {
+    EXPECT_EQ(Crc32c(buffers[i]), crcs[i]) << i;
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DECIMAL_H_
+#define DIMSUM_DECIMAL_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include <limits>
+#include <type_traits>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+#include "search.h"
+
+// Decimal integer parsing and formatting.
+//
+// Up to 16 digits are parsed at once: the digits are right-aligned in a
+// Simd128<uint8> with lookup(), then pairs, quads and octets of digits are
+// combined with x86::maddubs and mul_sum<int32>, which multiply-add by 10,
+// 100 and 10000. Formatting goes the other way, with the divisions by 100 and
+// 10 done as multiplications by reciprocals.
+
+namespace dimsum {
+namespace detail {
+
+constexpr uint8 kDigitZero = '0';
+
+// The 16 bytes at kAlignTable + n are a lookup() pattern that moves the first
+// n bytes to the end and zeroes the others. The 16 bytes at
+// kAlignTable + 16 + n move the last 16 - n bytes to the front.
+alignas(16) static constexpr uint8 kAlignTable[48] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0,    1,    2,    3,    4,    5,    6,    7,
+    8,    9,    10,   11,   12,   13,   14,   15,   0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+// Loads 16 bytes at p. Bytes at or after end read as 0.
+inline Simd128<uint8> LoadUpTo16(const char* p, const char* end) {
+  if (end - p >= 16) return LoadUnaligned<Simd128<uint8>>(p);
+  uint8 buffer[16] = {};
+  memcpy(buffer, p, end - p);
+  return LoadUnaligned<Simd128<uint8>>(buffer);
+}
+
+// Returns the number of leading decimal digits in chars.
+inline int CountLeadingDigits(Simd128<uint8> chars) {
+  Simd128<uint8> values = chars - Simd128<uint8>(kDigitZero);
+  uint32 digits = x86::movemask(
+      cmp_eq(sub_saturated(values, Simd128<uint8>(9)), Simd128<uint8>(0)));
+  return CountTrailingZeros(~digits);
+}
+
+// Returns the value of the 16 digits in values, each in [0, 9], most
+// significant first.
+inline uint64 ParseDigits16(Simd128<uint8> values) {
+  // {10 * d0 + d1, ...} as int16, then {100 * p0 + p1, ...} as int32.
+  auto pairs = x86::maddubs(values, bit_cast<int8>(Simd128<int16>(0x010a)));
+  auto quads =
+      mul_sum<int32>(pairs, bit_cast<int16>(Simd128<int32>(0x00010064)));
+  // quads fit in int16, so pack them and do {10000 * q0 + q1, ...}.
+  static const uint8 kPack[16] = {0, 1, 4, 5, 8, 9, 12, 13,
+                                  0, 1, 4, 5, 8, 9, 12, 13};
+  auto packed = bit_cast<int16>(
+      lookup(bit_cast<uint8>(quads), LoadUnaligned<Simd128<uint8>>(kPack)));
+  auto octets =
+      mul_sum<int32>(packed, bit_cast<int16>(Simd128<int32>(0x00012710)));
+  return static_cast<uint64>(octets[0]) * 100000000 + octets[1];
+}
+
+// Parses [begin, begin + num_digits) one digit at a time, with overflow
+// checks. Used for long inputs with leading zeros or out of range values.
+template <typename T>
+bool ParseUintSlow(const char* begin, int num_digits, T* value) {
+  T result = 0;
+  for (int i = 0; i < num_digits; i++) {
+    if (__builtin_mul_overflow(result, T{10}, &result) ||
+        __builtin_add_overflow(result, T(begin[i] - '0'), &result)) {
+      return false;
+    }
+  }
+  *value = result;
+  return true;
+}
+
+// Returns the 16 digits of value < 10^16 as ASCII, with leading zeros.
+inline Simd128<uint8> FormatDigits16(uint64 value) {
+  uint32 high = value / 100000000;
+  uint32 low = value % 100000000;
+  const uint32 quads[4] = {high / 10000, high % 10000, low / 10000,
+                           low % 10000};
+  auto x = LoadUnaligned<Simd128<uint32>>(quads);
+  // x / 100 for x < 43699.
+  auto hundreds = (x * Simd128<uint32>(5243)) >> 19;
+  auto pairs = bit_cast<uint16>(
+      hundreds | (x - hundreds * Simd128<uint32>(100)) << 16);
+  // x / 10 for x < 1029.
+  auto tens = (pairs * Simd128<uint16>(103)) >> 10;
+  auto digits = tens | (pairs - tens * Simd128<uint16>(10)) << 8;
+  return bit_cast<uint8>(digits) + Simd128<uint8>(kDigitZero);
+}
+
+}  // namespace detail
+
+// Parses the longest run of decimal digits at the start of [begin, end) as an
+// unsigned integer of type T. Returns a pointer past the last digit, or nullptr
+// if there are no digits or the value doesn't fit in T, like std::from_chars.
+// Signs and whitespace are not accepted.
+template <typename T>
+const char* parse_uint(const char* begin, const char* end, T* value) {
+  static_assert(std::is_unsigned<T>::value, "T must be unsigned");
+  static_assert(sizeof(T) <= 8, "T must be at most 64-bit");
+  constexpr int kMaxFastDigits = std::numeric_limits<T>::digits10 < 16
+                                     ? std::numeric_limits<T>::digits10 + 1
+                                     : 16;
+  Simd128<uint8> chars = detail::LoadUpTo16(begin, end);
+  int num_digits = detail::CountLeadingDigits(chars);
+  if (num_digits == 0) return nullptr;
+  if (num_digits == 16) {
+    while (begin + num_digits < end && begin[num_digits] >= '0' &&
+           begin[num_digits] <= '9') {
+      num_digits++;
+    }
+  }
+  uint64 result;
+  if (num_digits > 16) {
+    // The last 16 digits are parsed at once, the ones before one at a time.
+    const char* last16 = begin + num_digits - 16;
+    uint64 high;
+    if (!detail::ParseUintSlow(begin, num_digits - 16, &high) ||
+        __builtin_mul_overflow(high, 10000000000000000ull, &result) ||
+        __builtin_add_overflow(
+            result,
+            detail::ParseDigits16(
+                detail::LoadUnaligned<Simd128<uint8>>(last16) -
+                Simd128<uint8>(detail::kDigitZero)),
+            &result)) {
+      return nullptr;
+    }
+  } else if (num_digits > kMaxFastDigits) {
+    return detail::ParseUintSlow(begin, num_digits, value)
+               ? begin + num_digits
+               : nullptr;
+  } else {
+    result = detail::ParseDigits16(
+        lookup(chars - Simd128<uint8>(detail::kDigitZero),
+               detail::LoadUnaligned<Simd128<uint8>>(detail::kAlignTable +
+                                                     num_digits)));
+  }
+  if (result > std::numeric_limits<T>::max()) return nullptr;
+  *value = static_cast<T>(result);
+  return begin + num_digits;
+}
+
+// Same as parse_uint, for a signed T. An optional '-' may precede the digits.
+template <typename T>
+const char* parse_int(const char* begin, const char* end, T* value) {
+  static_assert(std::is_signed<T>::value && std::is_integral<T>::value,
+                "T must be a signed integer");
+  using Unsigned = typename std::make_unsigned<T>::type;
+  bool negative = begin < end && *begin == '-';
+  Unsigned magnitude;
+  const char* p = parse_uint(begin + negative, end, &magnitude);
+  if (p == nullptr) return nullptr;
+  Unsigned limit = static_cast<Unsigned>(std::numeric_limits<T>::max());
+  if (magnitude > limit + negative) return nullptr;
+  *value = negative ? static_cast<T>(Unsigned{0} - magnitude)
+                    : static_cast<T>(magnitude);
+  return p;
+}
+
+// Parses the separator-terminated decimal fields of [data, data + size), for
+// example "12\n7\n300\n" with separator '\n', into values. The separator after
+// the last field is optional. values must have room for
+// count_byte(data, size, separator) + 1 values. Returns the number of values
+// parsed, or -1 if a field is empty, is not all digits, or overflows uint64.
+inline ptrdiff_t parse_uint_column(const char* data, size_t size,
+                                   char separator, uint64* values) {
+  const SearchBlock needle(static_cast<uint8>(separator));
+  const char* field = data;
+  uint64* out = values;
+  bool ok = true;
+  auto parse_field = [&](const char* field_end) {
+    // Parsing stops at the first non-digit, which must be the separator.
+    const char* p = parse_uint(field, data + size, out);
+    if (p != field_end) return false;
+    out++;
+    field = field_end + 1;
+    return true;
+  };
+  detail::ScanBlocks(data, size,
+                     [needle](SearchBlock block) -> uint32 {
+                       return x86::movemask(cmp_eq(block, needle));
+                     },
+                     [&](const char* block, uint32 mask) {
+                       for (int i : BitmaskIterator<uint32>(mask)) {
+                         if (!parse_field(block + i)) return ok = false;
+                       }
+                       return true;
+                     });
+  if (!ok) return -1;
+  if (field < data + size && !parse_field(data + size)) return -1;
+  return out - values;
+}
+
+// Writes the decimal digits of value to out, which must have room for 20
+// characters, even if fewer are needed. Returns a pointer past the last digit.
+// No terminating null character is written.
+inline char* format_uint(uint64 value, char* out) {
+  constexpr uint64 k1e16 = 10000000000000000ull;
+  uint64 low = value;
+  uint32 keep_zeros = 0;
+  if (value >= k1e16) {
+    // At most 4 leading digits, then 16 digits with leading zeros.
+    uint32 top = value / k1e16;
+    char buffer[4];
+    int n = 0;
+    do {
+      buffer[n++] = '0' + top % 10;
+      top /= 10;
+    } while (top != 0);
+    while (n > 0) *out++ = buffer[--n];
+    low = value % k1e16;
+    keep_zeros = 1;
+  }
+  Simd128<uint8> digits = detail::FormatDigits16(low);
+  // Leading zeros are dropped. Bit 15 is set so that 0 is formatted as "0".
+  uint32 zeros =
+      x86::movemask(cmp_eq(digits, Simd128<uint8>(detail::kDigitZero)));
+  int num_zeros =
+      detail::CountTrailingZeros((~zeros & 0xffff) | keep_zeros | 0x8000);
+  detail::StoreUnaligned(
+      lookup(digits,
+             detail::LoadUnaligned<Simd128<uint8>>(detail::kAlignTable + 16 +
+                                                   num_zeros)),
+      out);
+  return out + 16 - num_zeros;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DECIMAL_H_
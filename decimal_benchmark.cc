@@ -0,0 +1,170 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "decimal.h"
+
+namespace dimsum {
+namespace {
+
+constexpr int kNumValues = 4096;
+
+// kNumValues random values with state.range(0) digits, or with a uniformly
+// random number of digits in [1, 20] if state.range(0) is 0.
+std::vector<uint64> RandomValues(int num_digits) {
+  std::mt19937_64 rng(0);
+  std::vector<uint64> values(kNumValues);
+  for (uint64& value : values) {
+    int n = num_digits ? num_digits : 1 + rng() % 20;
+    uint64 low = 1;
+    for (int i = 1; i < n; i++) low *= 10;
+    if (n == 1) low = 0;
+    value = n == 20 ? low + rng() % (~0ull - low) : low + rng() % (9 * low + 9);
+  }
+  return values;
+}
+
+std::string Column(const std::vector<uint64>& values) {
+  std::string column;
+  for (uint64 value : values) column += std::to_string(value) + "\n";
+  return column;
+}
+
+uint64 ScalarParseUint(const char** p, const char* end) {
+  uint64 value = 0;
+  const char* q = *p;
+  while (q < end && *q >= '0' && *q <= '9') value = value * 10 + (*q++ - '0');
+  *p = q;
+  return value;
+}
+
+char* ScalarFormatUint(uint64 value, char* out) {
+  char buffer[20];
+  int n = 0;
+  do {
+    buffer[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  while (n > 0) *out++ = buffer[--n];
+  return out;
+}
+
+void BM_Strtoull(benchmark::State& state) {
+  std::string column = Column(RandomValues(state.range(0)));
+  for (auto _ : state) {
+    const char* p = column.c_str();
+    const char* end = p + column.size();
+    uint64 sum = 0;
+    while (p < end) {
+      char* q;
+      sum += strtoull(p, &q, 10);
+      p = q + 1;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_Strtoull)->DenseRange(0, 20, 4);
+
+void BM_ScalarParseUint(benchmark::State& state) {
+  std::string column = Column(RandomValues(state.range(0)));
+  for (auto _ : state) {
+    const char* p = column.data();
+    const char* end = p + column.size();
+    uint64 sum = 0;
+    while (p < end) {
+      sum += ScalarParseUint(&p, end);
+      p++;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_ScalarParseUint)->DenseRange(0, 20, 4);
+
+void BM_ParseUint(benchmark::State& state) {
+  std::string column = Column(RandomValues(state.range(0)));
+  for (auto _ : state) {
+    const char* p = column.data();
+    const char* end = p + column.size();
+    uint64 sum = 0;
+    while (p < end) {
+      uint64 value;
+      p = parse_uint(p, end, &value) + 1;
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_ParseUint)->DenseRange(0, 20, 4);
+
+void BM_ParseUintColumn(benchmark::State& state) {
+  std::string column = Column(RandomValues(state.range(0)));
+  std::vector<uint64> values(kNumValues + 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parse_uint_column(column.data(), column.size(),
+                                               '\n', values.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+  state.SetBytesProcessed(state.iterations() * column.size());
+}
+BENCHMARK(BM_ParseUintColumn)->DenseRange(0, 20, 4);
+
+void BM_Snprintf(benchmark::State& state) {
+  std::vector<uint64> values = RandomValues(state.range(0));
+  char buffer[32];
+  for (auto _ : state) {
+    for (uint64 value : values) {
+      benchmark::DoNotOptimize(
+          snprintf(buffer, sizeof(buffer), "%llu",
+                   static_cast<unsigned long long>(value)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_Snprintf)->DenseRange(0, 20, 4);
+
+void BM_ScalarFormatUint(benchmark::State& state) {
+  std::vector<uint64> values = RandomValues(state.range(0));
+  std::string out(kNumValues * 20, '\0');
+  for (auto _ : state) {
+    char* p = &out[0];
+    for (uint64 value : values) p = ScalarFormatUint(value, p);
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_ScalarFormatUint)->DenseRange(0, 20, 4);
+
+void BM_FormatUint(benchmark::State& state) {
+  std::vector<uint64> values = RandomValues(state.range(0));
+  std::string out(kNumValues * 20 + 20, '\0');
+  for (auto _ : state) {
+    char* p = &out[0];
+    for (uint64 value : values) p = format_uint(value, p);
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_FormatUint)->DenseRange(0, 20, 4);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,184 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "decimal.h"
+
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Parses all of s, or returns false.
+template <typename T>
+bool ParseUint(const std::string& s, T* value) {
+  const char* end = s.data() + s.size();
+  return parse_uint(s.data(), end, value) == end;
+}
+
+template <typename T>
+bool ParseInt(const std::string& s, T* value) {
+  const char* end = s.data() + s.size();
+  return parse_int(s.data(), end, value) == end;
+}
+
+std::string FormatUint(uint64 value) {
+  char buffer[20];
+  return std::string(buffer, format_uint(value, buffer));
+}
+
+TEST(DecimalTest, ParseUint) {
+  uint64 value = 1;
+  EXPECT_TRUE(ParseUint("0", &value));
+  EXPECT_EQ(0u, value);
+  EXPECT_TRUE(ParseUint("42", &value));
+  EXPECT_EQ(42u, value);
+  EXPECT_TRUE(ParseUint("1234567890123456", &value));
+  EXPECT_EQ(1234567890123456u, value);
+  EXPECT_TRUE(ParseUint("12345678901234567", &value));
+  EXPECT_EQ(12345678901234567u, value);
+  EXPECT_TRUE(ParseUint("18446744073709551615", &value));
+  EXPECT_EQ(std::numeric_limits<uint64>::max(), value);
+  EXPECT_TRUE(ParseUint("000000000000000000000000000000007", &value));
+  EXPECT_EQ(7u, value);
+  EXPECT_FALSE(ParseUint("18446744073709551616", &value));
+  EXPECT_FALSE(ParseUint("", &value));
+  EXPECT_FALSE(ParseUint("-1", &value));
+  EXPECT_FALSE(ParseUint("+1", &value));
+  EXPECT_FALSE(ParseUint(" 1", &value));
+
+  uint32 value32;
+  EXPECT_TRUE(ParseUint("4294967295", &value32));
+  EXPECT_EQ(std::numeric_limits<uint32>::max(), value32);
+  EXPECT_FALSE(ParseUint("4294967296", &value32));
+  EXPECT_FALSE(ParseUint("99999999999", &value32));
+  uint8 value8;
+  EXPECT_TRUE(ParseUint("255", &value8));
+  EXPECT_EQ(255, value8);
+  EXPECT_FALSE(ParseUint("256", &value8));
+  EXPECT_FALSE(ParseUint("1000", &value8));
+}
+
+TEST(DecimalTest, ParseUintStopsAtNonDigit) {
+  const std::string s = "123abc";
+  uint64 value;
+  EXPECT_EQ(s.data() + 3, parse_uint(s.data(), s.data() + s.size(), &value));
+  EXPECT_EQ(123u, value);
+  // end is respected even when more digits follow.
+  EXPECT_EQ(s.data() + 2, parse_uint(s.data(), s.data() + 2, &value));
+  EXPECT_EQ(12u, value);
+  for (char c : std::string("/:\x80 \n.")) {
+    std::string t = "98" + std::string(1, c) + "7";
+    EXPECT_EQ(t.data() + 2, parse_uint(t.data(), t.data() + t.size(), &value));
+    EXPECT_EQ(98u, value);
+  }
+}
+
+TEST(DecimalTest, ParseInt) {
+  int64 value;
+  EXPECT_TRUE(ParseInt("-42", &value));
+  EXPECT_EQ(-42, value);
+  EXPECT_TRUE(ParseInt("9223372036854775807", &value));
+  EXPECT_EQ(std::numeric_limits<int64>::max(), value);
+  EXPECT_TRUE(ParseInt("-9223372036854775808", &value));
+  EXPECT_EQ(std::numeric_limits<int64>::min(), value);
+  EXPECT_FALSE(ParseInt("9223372036854775808", &value));
+  EXPECT_FALSE(ParseInt("-9223372036854775809", &value));
+  EXPECT_FALSE(ParseInt("-", &value));
+  EXPECT_FALSE(ParseInt("--1", &value));
+
+  int32 value32;
+  EXPECT_TRUE(ParseInt("-2147483648", &value32));
+  EXPECT_EQ(std::numeric_limits<int32>::min(), value32);
+  EXPECT_FALSE(ParseInt("2147483648", &value32));
+}
+
+TEST(DecimalTest, MatchesStdOnRandomInput) {
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 100000; i++) {
+    // Spread the values over all digit counts.
+    uint64 value = rng() >> (rng() % 64);
+    std::string s = std::to_string(value);
+    EXPECT_EQ(s, FormatUint(value));
+    uint64 parsed;
+    EXPECT_TRUE(ParseUint(s, &parsed)) << s;
+    EXPECT_EQ(value, parsed);
+    uint32 parsed32;
+    EXPECT_EQ(value <= std::numeric_limits<uint32>::max(),
+              ParseUint(s, &parsed32))
+        << s;
+  }
+}
+
+TEST(DecimalTest, FormatUint) {
+  EXPECT_EQ("0", FormatUint(0));
+  EXPECT_EQ("7", FormatUint(7));
+  EXPECT_EQ("10", FormatUint(10));
+  EXPECT_EQ("1000000", FormatUint(1000000));
+  EXPECT_EQ("9999999999999999", FormatUint(9999999999999999u));
+  EXPECT_EQ("10000000000000000", FormatUint(10000000000000000u));
+  EXPECT_EQ("10000000000000001", FormatUint(10000000000000001u));
+  EXPECT_EQ("18446744073709551615",
+            FormatUint(std::numeric_limits<uint64>::max()));
+  uint64 power = 1;
+  for (int i = 0; i < 20; i++, power *= 10) {
+    EXPECT_EQ(std::to_string(power), FormatUint(power));
+    EXPECT_EQ(std::to_string(power - 1), FormatUint(power - 1));
+  }
+}
+
+TEST(DecimalTest, ParseUintColumn) {
+  std::mt19937_64 rng(0);
+  std::vector<uint64> expected(1000);
+  std::string column;
+  for (uint64& value : expected) {
+    value = rng() >> (rng() % 64);
+    column += std::to_string(value) + "\n";
+  }
+  std::vector<uint64> values(expected.size() + 1);
+  EXPECT_EQ(static_cast<ptrdiff_t>(expected.size()),
+            parse_uint_column(column.data(), column.size(), '\n',
+                              values.data()));
+  values.pop_back();
+  EXPECT_EQ(expected, values);
+
+  // The last separator is optional.
+  column.pop_back();
+  EXPECT_EQ(static_cast<ptrdiff_t>(expected.size()),
+            parse_uint_column(column.data(), column.size(), '\n',
+                              values.data()));
+  EXPECT_EQ(expected, values);
+
+  const std::string kSmall = "1,22,333";
+  EXPECT_EQ(3, parse_uint_column(kSmall.data(), kSmall.size(), ',',
+                                 values.data()));
+  EXPECT_EQ(333u, values[2]);
+  EXPECT_EQ(0, parse_uint_column("", 0, ',', values.data()));
+}
+
+TEST(DecimalTest, ParseUintColumnRejectsInvalidInput) {
+  uint64 values[8];
+  for (const std::string s :
+       {"1,,2", ",1", "1,2a,3", "1, 2", "-1", "1,18446744073709551616,2",
+        "1,2,x"}) {
+    EXPECT_EQ(-1, parse_uint_column(s.data(), s.size(), ',', values)) << s;
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,393 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of dimsum operations, for each element type on 128-bit and
+// 256-bit Simd objects. Benchmarks are named
+//   <op>/<type>/<bits>/<throughput|latency>/<dimsum|simulated>
+// where:
+//  - throughput applies the operation to kChains independent values per
+//    iteration, and latency to one value kChains times in a dependent chain;
+//  - dimsum calls dimsum::<op>, i.e. the native specialization when the
+//    target has one and the generic implementation in operations.h otherwise;
+//    simulated calls the dimsum::simulated::<op> loop.
+//
+// Build for each target of test.sh (-msse4.1, -mavx2, -DDIMSUM_USE_SIMULATED)
+// to compare the native, generic and simulated implementations; with
+// DIMSUM_USE_SIMULATED, dimsum::<op> is always the generic implementation.
+// The target is recorded as "dimsum_target" in the context of the output, and
+// --benchmark_out_format=json writes results for regression tracking.
+//
+// Operands are chosen so that chains stay bounded and normal: adding zero,
+// multiplying by one, shifting by zero. The compiler can't see their values,
+// and the integer timings don't depend on them. Operations that return
+// another type (masks, reductions, conversions) are converted back to the
+// chained type in the same way for both implementations.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kChains = 8;
+
+// The operands of an operation besides the chained value.
+template <typename S>
+struct Operands {
+  S zero;
+  S one;
+  int zero_count;
+};
+
+template <typename S>
+Operands<S> MakeOperands() {
+  Operands<S> operands = {S(0), S(1), 0};
+  benchmark::DoNotOptimize(operands);
+  return operands;
+}
+
+// Returns {seed + 1, seed + 2, ...}.
+template <typename S>
+S MakeInput(int seed) {
+  using T = typename S::value_type;
+  T values[S::size()];
+  for (size_t i = 0; i < S::size(); i++) values[i] = T(seed + i + 1);
+  return S(values, flags::element_aligned);
+}
+
+// Hides a value from the compiler, so that a chain of operations is neither
+// folded nor hoisted. Unlike benchmark::DoNotOptimize, the value stays in a
+// register when it fits in one, and no store or load is added to the chain.
+template <size_t kBytes>
+struct Barrier {
+  template <typename Raw>
+  static void Apply(Raw* raw) {
+    benchmark::DoNotOptimize(*raw);
+  }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+template <>
+struct Barrier<16> {
+  template <typename Raw>
+  static void Apply(Raw* raw) {
+    asm volatile("" : "+x"(*raw));
+  }
+};
+#ifdef __AVX__
+template <>
+struct Barrier<32> {
+  template <typename Raw>
+  static void Apply(Raw* raw) {
+    asm volatile("" : "+x"(*raw));
+  }
+};
+#endif
+#elif defined(__aarch64__)
+template <>
+struct Barrier<16> {
+  template <typename Raw>
+  static void Apply(Raw* raw) {
+    asm volatile("" : "+w"(*raw));
+  }
+};
+#elif defined(__VSX__)
+template <>
+struct Barrier<16> {
+  template <typename Raw>
+  static void Apply(Raw* raw) {
+    asm volatile("" : "+v"(*raw));
+  }
+};
+#endif
+
+template <typename S>
+void Opaque(S* simd) {
+  typename S::__native_type raw = to_raw(*simd);
+  Barrier<sizeof(raw)>::Apply(&raw);
+  *simd = raw;
+}
+
+// Defines Op, which applies dimsum_expr or simulated_expr to the value x of
+// type S and the Operands o, and returns an S. T is the element type.
+#define DIMSUM_BENCHMARK_OP(Op, dimsum_expr, simulated_expr)      \
+  struct Op {                                                     \
+    template <typename S, typename T = typename S::value_type>    \
+    static S Dimsum(S x, const Operands<S>& o) {                  \
+      (void)o;                                                    \
+      return dimsum_expr;                                         \
+    }                                                             \
+    template <typename S, typename T = typename S::value_type>    \
+    static S Simulated(S x, const Operands<S>& o) {               \
+      (void)o;                                                    \
+      return simulated_expr;                                      \
+    }                                                             \
+  }
+
+DIMSUM_BENCHMARK_OP(Add, x + o.zero, simulated::add(x, o.zero));
+DIMSUM_BENCHMARK_OP(Sub, x - o.zero, simulated::sub(x, o.zero));
+DIMSUM_BENCHMARK_OP(Mul, x * o.one, simulated::mul(x, o.one));
+DIMSUM_BENCHMARK_OP(Min, min(x, o.one), simulated::min(x, o.one));
+DIMSUM_BENCHMARK_OP(Max, max(x, o.one), simulated::max(x, o.one));
+DIMSUM_BENCHMARK_OP(CmpEq, bit_cast<T>(cmp_eq(x, o.zero)),
+                    bit_cast<T>(simulated::cmp_eq(x, o.zero)));
+DIMSUM_BENCHMARK_OP(CmpLt, bit_cast<T>(cmp_lt(x, o.zero)),
+                    bit_cast<T>(simulated::cmp_lt(x, o.zero)));
+DIMSUM_BENCHMARK_OP(Hmin, S(hmin(x)), S(simulated::hmin(x)));
+DIMSUM_BENCHMARK_OP(Hmax, S(hmax(x)), S(simulated::hmax(x)));
+DIMSUM_BENCHMARK_OP(Movemask, S(T(x86::movemask(x))),
+                    S(T(simulated::movemask(x))));
+DIMSUM_BENCHMARK_OP(BitAnd, x & o.one, simulated::bit_and(x, o.one));
+DIMSUM_BENCHMARK_OP(BitOr, x | o.zero, simulated::bit_or(x, o.zero));
+DIMSUM_BENCHMARK_OP(BitXor, x ^ o.zero, simulated::bit_xor(x, o.zero));
+DIMSUM_BENCHMARK_OP(BitNot, ~x, simulated::bit_not(x));
+DIMSUM_BENCHMARK_OP(Shl, x << o.zero_count, simulated::shl(x, o.zero_count));
+DIMSUM_BENCHMARK_OP(Shr, x >> o.zero_count, simulated::shr(x, o.zero_count));
+DIMSUM_BENCHMARK_OP(ShlSimd, x << o.zero, simulated::shl_simd(x, o.zero));
+DIMSUM_BENCHMARK_OP(ShrSimd, x >> o.zero, simulated::shr_simd(x, o.zero));
+DIMSUM_BENCHMARK_OP(ReduceAdd, S(reduce_add(x)[0]),
+                    S(simulated::reduce_add(x)[0]));
+DIMSUM_BENCHMARK_OP(Abs, abs(x), simulated::abs(x));
+DIMSUM_BENCHMARK_OP(Negate, -x, simulated::negate(x));
+DIMSUM_BENCHMARK_OP(AddSaturated, add_saturated(x, o.zero),
+                    simulated::add_saturated(x, o.zero));
+DIMSUM_BENCHMARK_OP(SubSaturated, sub_saturated(x, o.zero),
+                    simulated::sub_saturated(x, o.zero));
+DIMSUM_BENCHMARK_OP(Sqrt, sqrt(x), simulated::sqrt(x));
+DIMSUM_BENCHMARK_OP(ReciprocalEstimate, reciprocal_estimate(x),
+                    simulated::reciprocal_estimate(x));
+DIMSUM_BENCHMARK_OP(ReciprocalSqrtEstimate, reciprocal_sqrt_estimate(x),
+                    simulated::reciprocal_sqrt_estimate(x));
+DIMSUM_BENCHMARK_OP(Round, round(x), simulated::round(x));
+DIMSUM_BENCHMARK_OP(Fma, fma(x, o.one, o.zero),
+                    simulated::fma(x, o.one, o.zero));
+DIMSUM_BENCHMARK_OP(RoundToInteger,
+                    static_simd_cast<T>(round_to_integer<int32>(x)),
+                    static_simd_cast<T>(simulated::round_to_integer<int32>(x)));
+DIMSUM_BENCHMARK_OP(Lookup, lookup(x, o.zero), simulated::lookup(x, o.zero));
+DIMSUM_BENCHMARK_OP(MulSum,
+                    mul_sum<int32>(bit_cast<int16>(x), bit_cast<int16>(o.zero),
+                                   x),
+                    simulated::mul_sum<int32>(bit_cast<int16>(x),
+                                              bit_cast<int16>(o.zero), x));
+DIMSUM_BENCHMARK_OP(Maddubs,
+                    x86::maddubs(bit_cast<uint8>(x), bit_cast<int8>(o.zero)),
+                    simulated::maddubs(bit_cast<uint8>(x),
+                                       bit_cast<int8>(o.zero)));
+DIMSUM_BENCHMARK_OP(Clmul, (x86::clmul<0, 0>(x, o.one)),
+                    (simulated::clmul<0, 0>(x, o.one)));
+
+#undef DIMSUM_BENCHMARK_OP
+
+// Reverses the elements.
+struct Shuffle {
+  template <typename S, size_t... indices>
+  static S DimsumImpl(S x, dimsum::index_sequence<indices...>) {
+    return shuffle<(S::size() - 1 - indices)...>(x);
+  }
+  template <typename S, size_t... indices>
+  static S SimulatedImpl(S x, dimsum::index_sequence<indices...>) {
+    return simulated::shuffle<(S::size() - 1 - indices)...>(x);
+  }
+  template <typename S>
+  static S Dimsum(S x, const Operands<S>&) {
+    return DimsumImpl(x, dimsum::make_index_sequence<S::size()>{});
+  }
+  template <typename S>
+  static S Simulated(S x, const Operands<S>&) {
+    return SimulatedImpl(x, dimsum::make_index_sequence<S::size()>{});
+  }
+};
+
+struct DimsumImpl {
+  static constexpr const char* kName = "dimsum";
+  template <typename Op, typename S>
+  static S Apply(S x, const Operands<S>& o) {
+    return Op::Dimsum(x, o);
+  }
+};
+
+struct SimulatedImpl {
+  static constexpr const char* kName = "simulated";
+  template <typename Op, typename S>
+  static S Apply(S x, const Operands<S>& o) {
+    return Op::Simulated(x, o);
+  }
+};
+
+// Applies Op to each of x[indices...], which are independent of each other.
+// The expansion unrolls the loop, so that x stays in registers.
+template <typename Op, typename Impl, typename S, size_t... indices>
+void ApplyIndependent(S* x, const Operands<S>& o,
+                      dimsum::index_sequence<indices...>) {
+  int unused[] = {(x[indices] = Impl::template Apply<Op>(x[indices], o),
+                   Opaque(&x[indices]), 0)...};
+  (void)unused;
+}
+
+// Applies Op to x once for each of indices..., each on the previous result.
+template <typename Op, typename Impl, typename S, size_t... indices>
+void ApplyDependent(S* x, const Operands<S>& o,
+                    dimsum::index_sequence<indices...>) {
+  int unused[] = {
+      (*x = Impl::template Apply<Op>(*x, o), Opaque(x), int(indices))...};
+  (void)unused;
+}
+
+template <typename Op, typename Impl, typename S>
+void BM_Throughput(benchmark::State& state) {
+  const Operands<S> o = MakeOperands<S>();
+  S x[kChains];
+  for (size_t i = 0; i < kChains; i++) x[i] = MakeInput<S>(i);
+  for (auto _ : state) {
+    ApplyIndependent<Op, Impl>(x, o, dimsum::make_index_sequence<kChains>{});
+  }
+  benchmark::DoNotOptimize(x);
+  state.SetItemsProcessed(state.iterations() * kChains);
+}
+
+template <typename Op, typename Impl, typename S>
+void BM_Latency(benchmark::State& state) {
+  const Operands<S> o = MakeOperands<S>();
+  S x = MakeInput<S>(0);
+  for (auto _ : state) {
+    ApplyDependent<Op, Impl>(&x, o, dimsum::make_index_sequence<kChains>{});
+  }
+  benchmark::DoNotOptimize(x);
+  state.SetItemsProcessed(state.iterations() * kChains);
+}
+
+template <typename T>
+const char* TypeName();
+
+#define DIMSUM_BENCHMARK_TYPE_NAME(T) \
+  template <>                         \
+  const char* TypeName<T>() {         \
+    return #T;                        \
+  }
+
+DIMSUM_BENCHMARK_TYPE_NAME(int8)
+DIMSUM_BENCHMARK_TYPE_NAME(uint8)
+DIMSUM_BENCHMARK_TYPE_NAME(int16)
+DIMSUM_BENCHMARK_TYPE_NAME(uint16)
+DIMSUM_BENCHMARK_TYPE_NAME(int32)
+DIMSUM_BENCHMARK_TYPE_NAME(uint32)
+DIMSUM_BENCHMARK_TYPE_NAME(int64)
+DIMSUM_BENCHMARK_TYPE_NAME(uint64)
+DIMSUM_BENCHMARK_TYPE_NAME(float)
+DIMSUM_BENCHMARK_TYPE_NAME(double)
+
+#undef DIMSUM_BENCHMARK_TYPE_NAME
+
+template <typename Op, typename Impl, typename S>
+void RegisterImpl(const std::string& prefix) {
+  benchmark::RegisterBenchmark(
+      (prefix + "/throughput/" + Impl::kName).c_str(),
+      &BM_Throughput<Op, Impl, S>);
+  benchmark::RegisterBenchmark((prefix + "/latency/" + Impl::kName).c_str(),
+                               &BM_Latency<Op, Impl, S>);
+}
+
+template <typename Op, typename S>
+void RegisterSimd(const std::string& op_name) {
+  const std::string prefix = op_name + "/" +
+                             TypeName<typename S::value_type>() + "/" +
+                             std::to_string(8 * sizeof(S));
+  RegisterImpl<Op, DimsumImpl, S>(prefix);
+  RegisterImpl<Op, SimulatedImpl, S>(prefix);
+}
+
+template <typename... Ts>
+struct Types {};
+
+using AllTypes = Types<int8, uint8, int16, uint16, int32, uint32, int64,
+                       uint64, float, double>;
+using IntegerTypes =
+    Types<int8, uint8, int16, uint16, int32, uint32, int64, uint64>;
+using SignedTypes = Types<int8, int16, int32, int64, float, double>;
+using SaturatedTypes = Types<int8, uint8, int16, uint16>;
+using FloatTypes = Types<float, double>;
+
+template <typename Op, typename... Ts>
+void RegisterOp(const char* op_name, Types<Ts...>) {
+  int unused[] = {(RegisterSimd<Op, Simd128<Ts>>(op_name),
+                   RegisterSimd<Op, Simd256<Ts>>(op_name), 0)...};
+  (void)unused;
+}
+
+const char* TargetName() {
+#if defined(DIMSUM_USE_SIMULATED)
+  return "simulated";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE4_1__)
+  return "sse4.1";
+#elif defined(__SSE3__)
+  return "sse3";
+#elif defined(__aarch64__)
+  return "neon";
+#elif defined(__VSX__)
+  return "vsx";
+#else
+  return "unknown";
+#endif
+}
+
+bool RegisterAll() {
+  benchmark::AddCustomContext("dimsum_target", TargetName());
+  RegisterOp<Add>("add", AllTypes{});
+  RegisterOp<Sub>("sub", AllTypes{});
+  RegisterOp<Mul>("mul", AllTypes{});
+  RegisterOp<Min>("min", AllTypes{});
+  RegisterOp<Max>("max", AllTypes{});
+  RegisterOp<CmpEq>("cmp_eq", AllTypes{});
+  RegisterOp<CmpLt>("cmp_lt", AllTypes{});
+  RegisterOp<Hmin>("hmin", AllTypes{});
+  RegisterOp<Hmax>("hmax", AllTypes{});
+  RegisterOp<Movemask>("movemask", AllTypes{});
+  RegisterOp<Shuffle>("shuffle", AllTypes{});
+  RegisterOp<BitAnd>("bit_and", IntegerTypes{});
+  RegisterOp<BitOr>("bit_or", IntegerTypes{});
+  RegisterOp<BitXor>("bit_xor", IntegerTypes{});
+  RegisterOp<BitNot>("bit_not", IntegerTypes{});
+  RegisterOp<Shl>("shl", IntegerTypes{});
+  RegisterOp<Shr>("shr", IntegerTypes{});
+  RegisterOp<ShlSimd>("shl_simd", IntegerTypes{});
+  RegisterOp<ShrSimd>("shr_simd", IntegerTypes{});
+  RegisterOp<ReduceAdd>("reduce_add", IntegerTypes{});
+  RegisterOp<Abs>("abs", SignedTypes{});
+  RegisterOp<Negate>("negate", SignedTypes{});
+  RegisterOp<AddSaturated>("add_saturated", SaturatedTypes{});
+  RegisterOp<SubSaturated>("sub_saturated", SaturatedTypes{});
+  RegisterOp<Sqrt>("sqrt", FloatTypes{});
+  RegisterOp<ReciprocalEstimate>("reciprocal_estimate", FloatTypes{});
+  RegisterOp<ReciprocalSqrtEstimate>("reciprocal_sqrt_estimate",
+                                     FloatTypes{});
+  RegisterOp<Round>("round", FloatTypes{});
+  RegisterOp<Fma>("fma", FloatTypes{});
+  RegisterOp<RoundToInteger>("round_to_integer", Types<float>{});
+  RegisterOp<Lookup>("lookup", Types<uint8>{});
+  RegisterOp<MulSum>("mul_sum", Types<int32>{});
+  RegisterOp<Maddubs>("maddubs", Types<int16>{});
+  RegisterOp<Clmul>("clmul", Types<uint64>{});
+  return true;
+}
+
+const bool kRegistered = RegisterAll();
+
+}  // namespace
+}  // namespace dimsum
@@ -14,9 +14,12 @@
 
 #include "dimsum.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 #include "simulated.h"
 #include "gtest/gtest.h"
@@ -256,6 +259,19 @@ TEST(DimsumTest, Cast) {
       SimdList<Simd128<uint32>>(0x00020001, 0x00040003, 0x00060005,
                                 0x00080007) ==
       bit_cast<uint32>(SimdList<Simd128<uint16>>(1, 2, 3, 4, 5, 6, 7, 8))));
+
+  // Other widths, and arrays.
+  EXPECT_TRUE(all_of(SimdList<Simd64<uint32>>(0x00020001, 0x00040003) ==
+                     bit_cast<uint32>(SimdList<Simd64<uint16>>(1, 2, 3, 4))));
+  EXPECT_TRUE(all_of(
+      SimdList<Simd256<uint16>>(1, 0, 2, 0, 3, 0, 4, 0, 5, 0, 6, 0, 7, 0, 8,
+                                0) ==
+      bit_cast<uint16>(SimdList<Simd256<uint32>>(1, 2, 3, 4, 5, 6, 7, 8))));
+  using FixedSize = std::experimental::simd_abi::fixed_size<4>;
+  auto fixed = bit_cast<uint32>(SimdList<Simd<uint16, FixedSize>>(1, 2, 3, 4));
+  EXPECT_EQ(2, fixed.size());
+  EXPECT_EQ(0x00020001, fixed[0]);
+  EXPECT_EQ(0x00040003, fixed[1]);
 #endif
 }
 
@@ -295,6 +311,151 @@ TEST(DimsumTest, CopyTo) {
   }
 }
 
+template <typename SimdType, typename Src>
+void TestLoadConverted() {
+  using T = typename SimdType::value_type;
+  Src src[SimdType::size()];
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    // Wraps around in narrow types, which covers negative values too.
+    src[i] = static_cast<Src>(static_cast<int>(i) * 37 - 100);
+  }
+  SimdType simd = load_converted<SimdType>(src);
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    EXPECT_EQ(static_cast<T>(src[i]), simd[i]) << i;
+  }
+}
+
+template <template <typename> class SimdTemplate>
+void TestLoadConvertedWidth() {
+  TestLoadConverted<SimdTemplate<float>, int8>();
+  TestLoadConverted<SimdTemplate<float>, uint8>();
+  TestLoadConverted<SimdTemplate<float>, int16>();
+  TestLoadConverted<SimdTemplate<float>, uint16>();
+  TestLoadConverted<SimdTemplate<float>, int32>();
+  TestLoadConverted<SimdTemplate<float>, float>();
+  TestLoadConverted<SimdTemplate<int32>, int8>();
+  TestLoadConverted<SimdTemplate<int32>, uint8>();
+  TestLoadConverted<SimdTemplate<int32>, int16>();
+  TestLoadConverted<SimdTemplate<int32>, uint16>();
+  TestLoadConverted<SimdTemplate<int16>, int8>();
+  TestLoadConverted<SimdTemplate<int16>, uint8>();
+  TestLoadConverted<SimdTemplate<uint16>, uint8>();
+  TestLoadConverted<SimdTemplate<double>, float>();
+  TestLoadConverted<SimdTemplate<int64>, int32>();
+}
+
+TEST(DimsumTest, LoadConverted) {
+  TestLoadConvertedWidth<Simd64>();
+  TestLoadConvertedWidth<Simd128>();
+  TestLoadConvertedWidth<Simd256>();
+  TestLoadConverted<Simd<float, std::experimental::simd_abi::fixed_size<3>>,
+                    uint8>();
+}
+
+template <typename Dest, typename SimdType>
+void TestStoreConverted() {
+  using T = typename SimdType::value_type;
+  SimdType simd;
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    // Truncated towards zero, and in the range of Dest.
+    const int base = std::is_signed<Dest>::value ? -50 : 0;
+    simd[i] = static_cast<T>(base + static_cast<int>(i) * 3) +
+              static_cast<T>(std::is_floating_point<T>::value ? 0.75 : 0);
+  }
+  Dest dest[SimdType::size()];
+  store_converted(simd, dest);
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    EXPECT_EQ(static_cast<Dest>(simd[i]), dest[i]) << i;
+  }
+}
+
+template <template <typename> class SimdTemplate>
+void TestStoreConvertedWidth() {
+  TestStoreConverted<int32, SimdTemplate<float>>();
+  TestStoreConverted<int16, SimdTemplate<float>>();
+  TestStoreConverted<uint16, SimdTemplate<float>>();
+  TestStoreConverted<int8, SimdTemplate<float>>();
+  TestStoreConverted<uint8, SimdTemplate<float>>();
+  TestStoreConverted<float, SimdTemplate<float>>();
+  TestStoreConverted<int16, SimdTemplate<int32>>();
+  TestStoreConverted<uint8, SimdTemplate<int16>>();
+  TestStoreConverted<float, SimdTemplate<double>>();
+}
+
+TEST(DimsumTest, StoreConverted) {
+  TestStoreConvertedWidth<Simd64>();
+  TestStoreConvertedWidth<Simd128>();
+  TestStoreConvertedWidth<Simd256>();
+}
+
+// The values of T to saturate.
+template <typename T>
+std::vector<T> SaturatedValues() {
+  const double kValues[] = {-1e10,  -2147483648., -70000, -32769, -32768,
+                            -129.5, -129,         -128,   -1.5,   -1,
+                            -0.5,   0,            0.5,    1,      127,
+                            127.5,  128,          255,    255.9,  256,
+                            32767,  32768,        65535,  65536,  70000,
+                            2147483647.,          1e10};
+  std::vector<T> values;
+  for (double value : kValues) {
+    if (value >= double(std::numeric_limits<T>::lowest()) &&
+        value <= double(std::numeric_limits<T>::max()) &&
+        (std::is_floating_point<T>::value || value == std::trunc(value))) {
+      values.push_back(static_cast<T>(value));
+    }
+  }
+  return values;
+}
+
+template <typename Dest, typename SimdType>
+void TestStoreSaturated() {
+  using T = typename SimdType::value_type;
+  const std::vector<T> values = SaturatedValues<T>();
+  for (size_t offset = 0; offset < values.size(); offset++) {
+    SimdType simd;
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      simd[i] = values[(offset + i) % values.size()];
+    }
+    Dest dest[SimdType::size()];
+    store_saturated(simd, dest);
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      const double value = static_cast<T>(simd[i]);
+      const double expected = std::min<double>(
+          std::max<double>(std::trunc(value), std::numeric_limits<Dest>::min()),
+          std::numeric_limits<Dest>::max());
+      EXPECT_EQ(static_cast<Dest>(expected), dest[i]) << value;
+    }
+  }
+}
+
+template <template <typename> class SimdTemplate>
+void TestStoreSaturatedWidth() {
+  TestStoreSaturated<int16, SimdTemplate<int32>>();
+  TestStoreSaturated<uint16, SimdTemplate<int32>>();
+  TestStoreSaturated<int8, SimdTemplate<int32>>();
+  TestStoreSaturated<uint8, SimdTemplate<int32>>();
+  TestStoreSaturated<int8, SimdTemplate<int16>>();
+  TestStoreSaturated<uint8, SimdTemplate<int16>>();
+  TestStoreSaturated<int16, SimdTemplate<float>>();
+  TestStoreSaturated<uint16, SimdTemplate<float>>();
+  TestStoreSaturated<int8, SimdTemplate<float>>();
+  TestStoreSaturated<uint8, SimdTemplate<float>>();
+  TestStoreSaturated<int32, SimdTemplate<float>>();
+  TestStoreSaturated<int32, SimdTemplate<int32>>();
+  TestStoreSaturated<uint32, SimdTemplate<int32>>();
+  TestStoreSaturated<int32, SimdTemplate<uint32>>();
+  TestStoreSaturated<uint8, SimdTemplate<uint16>>();
+  TestStoreSaturated<int16, SimdTemplate<double>>();
+  TestStoreSaturated<int64, SimdTemplate<int32>>();
+}
+
+TEST(DimsumTest, StoreSaturated) {
+  TestStoreSaturatedWidth<Simd64>();
+  TestStoreSaturatedWidth<Simd128>();
+  TestStoreSaturatedWidth<Simd256>();
+}
+
 TEST(DimsumTest, Negate) {
   SIMD_UNARY_OP_TEST(int32, negate, -, boring_unary_op_test);
   SIMD_UNARY_OP_TEST(float, negate, -, boring_unary_op_test_float);
@@ -533,6 +694,72 @@ TEST(DimsumTest, CmpGe) {
   SIMD_BINARY_FREE_FUNC_TEST(float, cmp_ge, boring_binary_op_test_float);
 }
 
+// Pairs every value with every other one, including values that differ only in
+// the sign bit, which signed comparisons would order the other way.
+template <typename SimdType>
+void TestUnsignedCompares() {
+  using T = typename SimdType::value_type;
+  constexpr T kMax = std::numeric_limits<T>::max();
+  const T values[] = {0, 1, kMax / 2, kMax / 2 + 1, kMax - 1, kMax};
+  constexpr size_t kNumValues = sizeof(values) / sizeof(values[0]);
+  for (size_t shift = 0; shift < kNumValues; shift++) {
+    SimdType lhs, rhs;
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      lhs[i] = values[i % kNumValues];
+      rhs[i] = values[(i + shift) % kNumValues];
+    }
+    const SimdType lt = cmp_lt(lhs, rhs), le = cmp_le(lhs, rhs),
+                   gt = cmp_gt(lhs, rhs), ge = cmp_ge(lhs, rhs);
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      EXPECT_EQ(lhs[i] < rhs[i] ? kMax : 0, lt[i]) << lhs[i] << " < " << rhs[i];
+      EXPECT_EQ(lhs[i] <= rhs[i] ? kMax : 0, le[i])
+          << lhs[i] << " <= " << rhs[i];
+      EXPECT_EQ(lhs[i] > rhs[i] ? kMax : 0, gt[i]) << lhs[i] << " > " << rhs[i];
+      EXPECT_EQ(lhs[i] >= rhs[i] ? kMax : 0, ge[i])
+          << lhs[i] << " >= " << rhs[i];
+    }
+  }
+}
+
+// Compares NaN with itself, a number and infinity, in both orders.
+template <typename SimdType>
+void TestNaNCompares() {
+  using T = typename SimdType::value_type;
+  const T kNaN = std::numeric_limits<T>::quiet_NaN();
+  const T kInf = std::numeric_limits<T>::infinity();
+  const T others[] = {kNaN, 1, kInf};
+  for (T other : others) {
+    for (bool nan_first : {false, true}) {
+      const SimdType lhs(nan_first ? kNaN : other);
+      const SimdType rhs(nan_first ? other : kNaN);
+      EXPECT_FALSE(any_of(cmp_eq(lhs, rhs) != 0)) << other;
+      EXPECT_TRUE(all_of(cmp_ne(lhs, rhs) != 0)) << other;
+      EXPECT_FALSE(any_of(cmp_lt(lhs, rhs) != 0)) << other;
+      EXPECT_FALSE(any_of(cmp_le(lhs, rhs) != 0)) << other;
+      EXPECT_FALSE(any_of(cmp_gt(lhs, rhs) != 0)) << other;
+      EXPECT_FALSE(any_of(cmp_ge(lhs, rhs) != 0)) << other;
+    }
+  }
+}
+
+TEST(DimsumTest, NaNCompares) {
+  TestNaNCompares<Simd128<float>>();
+  TestNaNCompares<Simd128<double>>();
+  TestNaNCompares<Simd256<float>>();
+  TestNaNCompares<Simd256<double>>();
+}
+
+TEST(DimsumTest, UnsignedCompares) {
+  TestUnsignedCompares<Simd128<uint8>>();
+  TestUnsignedCompares<Simd128<uint16>>();
+  TestUnsignedCompares<Simd128<uint32>>();
+  TestUnsignedCompares<Simd128<uint64>>();
+  TestUnsignedCompares<Simd256<uint8>>();
+  TestUnsignedCompares<Simd256<uint16>>();
+  TestUnsignedCompares<Simd256<uint32>>();
+  TestUnsignedCompares<Simd256<uint64>>();
+}
+
 TEST(DimsumTest, Shuffle) {
   {
     auto lhs = SimdList<Simd128<int32>>(1, 2, 3, 4);
@@ -587,6 +814,25 @@ TEST(DimsumTest, Shuffle) {
   }
 }
 
+TEST(DimsumTest, Lookup) {
+  auto table = NativeSimd<uint8>([](int i) { return 100 + i; });
+  {
+    auto indices = NativeSimd<uint8>([](int i) { return 15 - i % 16; });
+    EXPECT_TRUE(all_of(simulated::lookup(table, indices) ==
+                       lookup(table, indices)));
+    EXPECT_EQ(115, lookup(table, indices)[0]);
+    EXPECT_EQ(100, lookup(table, indices)[15]);
+  }
+  {
+    auto indices =
+        NativeSimd<uint8>([](int i) { return i % 3 ? i % 16 : 0x80; });
+    EXPECT_TRUE(all_of(simulated::lookup(table, indices) ==
+                       lookup(table, indices)));
+    EXPECT_EQ(0, lookup(table, indices)[0]);
+    EXPECT_EQ(101, lookup(table, indices)[1]);
+  }
+}
+
 TEST(DimsumTest, MulSum) {
   EXPECT_TRUE(all_of((SimdList<Simd128<int32>>(1, 14, 43, 88)) ==
                      (mul_sum(SimdList<Simd128<int16>>(0, 1, 2, 3, 4, 5, 6, 7),
@@ -606,6 +852,59 @@ TEST(DimsumTest, Min) {
                          SimdList<Simd128<int32>>(0, 1, 5, 3))));
 }
 
+// The values have equal high or equal low halves in many combinations, which
+// emulations of int64 comparisons with 32-bit ones need to get right.
+// The elements alternate between (a, b) and (b, a), so that each half of a
+// Simd256 object sees both orders.
+template <typename SimdType>
+void TestInt64CompareMinMax() {
+  using MaskType = NativeSimd<uint64, SimdType::size()>;
+  const int64 values[] = {0,
+                          1,
+                          -1,
+                          0x7fffffff,
+                          0x80000000,
+                          0xffffffff,
+                          0x100000000,
+                          0x180000000,
+                          -0x80000000ll,
+                          -0x100000000ll,
+                          std::numeric_limits<int64>::min(),
+                          std::numeric_limits<int64>::max()};
+  const uint64 all = ~uint64{0};
+  for (int64 a : values) {
+    for (int64 b : values) {
+      SimdType lhs, rhs, mins, maxs;
+      MaskType lt, le, gt, ge;
+      for (size_t i = 0; i < SimdType::size(); i++) {
+        const int64 x = i % 2 == 0 ? a : b;
+        const int64 y = i % 2 == 0 ? b : a;
+        lhs[i] = x;
+        rhs[i] = y;
+        lt[i] = x < y ? all : 0;
+        le[i] = x <= y ? all : 0;
+        gt[i] = x > y ? all : 0;
+        ge[i] = x >= y ? all : 0;
+        mins[i] = std::min(a, b);
+        maxs[i] = std::max(a, b);
+      }
+      EXPECT_TRUE(all_of(lt == cmp_lt(lhs, rhs))) << a << " < " << b;
+      EXPECT_TRUE(all_of(le == cmp_le(lhs, rhs))) << a << " <= " << b;
+      EXPECT_TRUE(all_of(gt == cmp_gt(lhs, rhs))) << a << " > " << b;
+      EXPECT_TRUE(all_of(ge == cmp_ge(lhs, rhs))) << a << " >= " << b;
+      EXPECT_TRUE(all_of(mins == min(lhs, rhs)))
+          << "min(" << a << ", " << b << ")";
+      EXPECT_TRUE(all_of(maxs == max(lhs, rhs)))
+          << "max(" << a << ", " << b << ")";
+    }
+  }
+}
+
+TEST(DimsumTest, Int64CompareMinMax) {
+  TestInt64CompareMinMax<Simd128<int64>>();
+  TestInt64CompareMinMax<Simd256<int64>>();
+}
+
 TEST(DimsumTest, HorizontalSum) {
   EXPECT_TRUE(
       all_of((SimdList<Simd128<int64>>(3, 7)) ==
@@ -657,6 +956,38 @@ TEST(DimsumTest, RoundEvenToInteger) {
                      round_to_integer<int32>(NativeSimd<float>(1.51f))));
 }
 
+// Checks the generic implementations on widths without specializations, which
+// go through 16-byte pieces or vector lanes.
+template <typename FloatSimd>
+void TestGenericWidth() {
+  using T = typename FloatSimd::value_type;
+  using IntSimd = NativeSimd<int32, FloatSimd::size()>;
+  FloatSimd simd, squares;
+  for (size_t i = 0; i < simd.size(); i++) {
+    simd[i] = T(i) + T(0.5);
+    squares[i] = T(i * i);
+  }
+  FloatSimd sqrts = sqrt(squares);
+  FloatSimd rounded = round(simd);
+  IntSimd integers = round_to_integer<int32>(simd);
+  FloatSimd fmas = fma(simd, simd, FloatSimd(1));
+  for (size_t i = 0; i < simd.size(); i++) {
+    EXPECT_EQ(T(i), sqrts[i]) << i;
+    EXPECT_EQ(std::nearbyint(simd[i]), rounded[i]) << i;
+    EXPECT_EQ(int32(std::nearbyint(simd[i])), integers[i]) << i;
+    EXPECT_EQ(std::fma(simd[i], simd[i], T(1)), fmas[i]) << i;
+  }
+  EXPECT_TRUE(WithinFraction(reciprocal_estimate(simd), FloatSimd(1) / simd));
+  EXPECT_TRUE(WithinFraction(reciprocal_sqrt_estimate(squares + 1),
+                             FloatSimd(1) / sqrt(squares + 1)));
+}
+
+TEST(DimsumTest, GenericWidths) {
+  TestGenericWidth<Simd64<float>>();
+  TestGenericWidth<Simd256<float>>();
+  TestGenericWidth<NativeSimd<float, 16>>();
+}
+
 template <typename IntSimd, typename FloatSimd>
 void TestIntFloatStaticSimdCast() {
   using IntType = typename IntSimd::value_type;
@@ -752,6 +1083,117 @@ TEST(DimsumTest, StaticSimdCast) {
   TestSignStaticSimdCast<NativeSimd<uint64>, NativeSimd<int64>>();
 }
 
+// Returns simd[i] = values[(i + offset) % values.size()].
+template <typename SimdType>
+SimdType CycleValues(const std::vector<typename SimdType::value_type>& values,
+                     size_t offset) {
+  SimdType simd;
+  for (size_t i = 0; i < simd.size(); i++) {
+    simd[i] = values[(i + offset) % values.size()];
+  }
+  return simd;
+}
+
+// Checks static_simd_cast<Dest> against static_cast of each element, with
+// each of values in each lane.
+template <typename Dest, typename SimdType>
+void TestSimdCastOfValues(
+    const std::vector<typename SimdType::value_type>& values) {
+  using T = typename SimdType::value_type;
+  for (size_t offset = 0; offset < values.size(); offset++) {
+    const SimdType simd = CycleValues<SimdType>(values, offset);
+    const auto converted = static_simd_cast<Dest>(simd);
+    for (size_t i = 0; i < simd.size(); i++) {
+      const T value = simd[i];
+      EXPECT_EQ(static_cast<Dest>(value), static_cast<Dest>(converted[i]))
+          << "lane " << i << " of " << simd.size();
+    }
+  }
+}
+
+// Integers at the ends of the range of T, with alternating bit patterns, and
+// which round when converted to float or double.
+template <typename T>
+std::vector<T> SimdCastIntegers() {
+  using Limits = std::numeric_limits<T>;
+  return {0,
+          1,
+          Limits::min(),
+          Limits::max(),
+          static_cast<T>(-1),
+          static_cast<T>(Limits::max() / 3),
+          static_cast<T>(0x0123456789abcdefull),
+          static_cast<T>(0xfedcba9876543210ull),
+          static_cast<T>(16777217),
+          static_cast<T>(0x80000001u),
+          static_cast<T>(9007199254740993ull),
+          static_cast<T>(-9007199254740993ll)};
+}
+
+// Converts each of Simd64 and Simd128, or Simd128 and Simd256, whichever of
+// T and Dest is wider.
+template <typename Dest, typename T>
+void TestSimdCastWidths(const std::vector<T>& values) {
+  constexpr int kSize =
+      16 / (sizeof(T) > sizeof(Dest) ? sizeof(T) : sizeof(Dest));
+  TestSimdCastOfValues<Dest, NativeSimd<T, kSize / 2>>(values);
+  TestSimdCastOfValues<Dest, NativeSimd<T, kSize>>(values);
+  TestSimdCastOfValues<Dest, NativeSimd<T, kSize * 2>>(values);
+}
+
+template <typename Dest, typename T>
+void TestIntegerSimdCast() {
+  TestSimdCastWidths<Dest>(SimdCastIntegers<T>());
+}
+
+TEST(DimsumTest, SimdCastWidths) {
+  // Widening.
+  TestIntegerSimdCast<int16, int8>();
+  TestIntegerSimdCast<uint16, uint8>();
+  TestIntegerSimdCast<int16, uint8>();
+  TestIntegerSimdCast<uint16, int8>();
+  TestIntegerSimdCast<int32, int16>();
+  TestIntegerSimdCast<uint32, uint16>();
+  TestIntegerSimdCast<int32, uint16>();
+  TestIntegerSimdCast<uint32, int16>();
+  TestIntegerSimdCast<int64, int32>();
+  TestIntegerSimdCast<uint64, uint32>();
+  TestIntegerSimdCast<int64, uint32>();
+  TestIntegerSimdCast<uint64, int32>();
+  TestIntegerSimdCast<int32, int8>();
+  TestIntegerSimdCast<uint64, uint16>();
+
+  // Narrowing.
+  TestIntegerSimdCast<int8, int16>();
+  TestIntegerSimdCast<uint8, uint16>();
+  TestIntegerSimdCast<uint8, int16>();
+  TestIntegerSimdCast<int16, int32>();
+  TestIntegerSimdCast<uint16, uint32>();
+  TestIntegerSimdCast<int16, uint32>();
+  TestIntegerSimdCast<int32, int64>();
+  TestIntegerSimdCast<uint32, uint64>();
+  TestIntegerSimdCast<uint32, int64>();
+  TestIntegerSimdCast<int8, int32>();
+
+  // Same width.
+  TestIntegerSimdCast<uint32, int32>();
+  TestIntegerSimdCast<int8, uint8>();
+
+  // Integers to floating point.
+  TestIntegerSimdCast<float, int32>();
+  TestIntegerSimdCast<float, uint32>();
+  TestIntegerSimdCast<double, int64>();
+  TestIntegerSimdCast<double, uint64>();
+
+  // Floating point to integers, in range.
+  TestSimdCastWidths<int32, float>(
+      {0.f, -0.f, 1.5f, -1.5f, 2.5f, -2.5f, 12345.678f, -9.99e8f,
+       2147483520.f, -2147483648.f});
+  TestSimdCastWidths<int64, double>(
+      {0., -0., 1.5, -1.5, 2.5, -2.5, 1e15 + 0.5, -4.5e18,
+       9223372036854774784., -9223372036854775808.});
+}
+
 template <typename SimdType, size_t num_elements>
 struct TestZipImpl {
   static void Apply() {}
@@ -878,6 +1320,10 @@ TEST(DimsumTest, MulWidened) {
   TestMulWidened<NativeSimd<uint8>>();
   TestMulWidened<NativeSimd<uint16>>();
   TestMulWidened<NativeSimd<uint32>>();
+  TestMulWidened<Simd64<int32>>();
+  TestMulWidened<Simd64<uint32>>();
+  TestMulWidened<Simd128<int32>>();
+  TestMulWidened<Simd128<uint32>>();
 }
 
 template <typename SimdType>
@@ -47,6 +47,16 @@
 # include <altivec.h>
 #endif
 
+#ifdef __PCLMUL__
+# include <wmmintrin.h>
+#endif
+
+// Defined iff x86::clmul on Simd128<uint64> maps to an instruction. Code with a
+// cheaper alternative to the bit-at-a-time simulation can test it.
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__PCLMUL__)
+# define DIMSUM_HAS_NATIVE_CLMUL 1
+#endif
+
 namespace dimsum {
 
 namespace x86 {
@@ -72,9 +82,12 @@ inline Simd256<int16> maddubs(Simd256<uint8> lhs, Simd256<int8> rhs) {
 #endif  // __SSE4_1__
 #endif  // DIMSUM_USE_SIMULATED
 
-// TODO(maskray) {int,uint}{8,32,64} specializations are provided.
-// Provide float/double specializations if there are use cases to check sign
-// bits
+// Returns a bitmask whose bit i is the most significant (sign) bit of simd[i].
+// This is the bridge from cmp_* results to scalar branches.
+//
+// Native specializations are provided for all 128-bit types on x86 (and all
+// 256-bit types on AVX2). 16-bit lanes are narrowed with a saturating pack
+// first.
 template <typename T, typename Abi>
 int movemask(Simd<T, Abi> simd) {
   return simulated::movemask(simd);
@@ -93,6 +106,17 @@ inline int movemask(Simd128<uint8> simd) {
   return _mm_movemask_epi8(to_raw(simd));
 }
 
+// packs saturates, so the sign of each int16 is preserved in the int8.
+template <>
+inline int movemask(Simd128<int16> simd) {
+  return _mm_movemask_epi8(_mm_packs_epi16(to_raw(simd), _mm_setzero_si128()));
+}
+
+template <>
+inline int movemask(Simd128<uint16> simd) {
+  return _mm_movemask_epi8(_mm_packs_epi16(to_raw(simd), _mm_setzero_si128()));
+}
+
 template <>
 inline int movemask(Simd128<int32> simd) {
   return _mm_movemask_ps(to_raw(bit_cast<float>(simd)));
@@ -113,6 +137,16 @@ inline int movemask(Simd128<uint64> simd) {
   return _mm_movemask_pd(to_raw(bit_cast<double>(simd)));
 }
 
+template <>
+inline int movemask(Simd128<float> simd) {
+  return _mm_movemask_ps(to_raw(simd));
+}
+
+template <>
+inline int movemask(Simd128<double> simd) {
+  return _mm_movemask_pd(to_raw(simd));
+}
+
 # ifdef __AVX2__
 template <>
 inline int movemask(Simd256<int8> simd) {
@@ -124,6 +158,20 @@ inline int movemask(Simd256<uint8> simd) {
   return _mm256_movemask_epi8(to_raw(simd));
 }
 
+// _mm256_packs_epi16 packs within 128-bit lanes, so pack the two halves with
+// the 128-bit version instead to keep the lanes in order.
+template <>
+inline int movemask(Simd256<int16> simd) {
+  __m256i raw = to_raw(simd);
+  return _mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(raw),
+                                           _mm256_extracti128_si256(raw, 1)));
+}
+
+template <>
+inline int movemask(Simd256<uint16> simd) {
+  return movemask(bit_cast<int16>(simd));
+}
+
 template <>
 inline int movemask(Simd256<int32> simd) {
   return _mm256_movemask_ps(to_raw(bit_cast<float>(simd)));
@@ -143,6 +191,16 @@ template <>
 inline int movemask(Simd256<uint64> simd) {
   return _mm256_movemask_pd(to_raw(bit_cast<double>(simd)));
 }
+
+template <>
+inline int movemask(Simd256<float> simd) {
+  return _mm256_movemask_ps(to_raw(simd));
+}
+
+template <>
+inline int movemask(Simd256<double> simd) {
+  return _mm256_movemask_pd(to_raw(simd));
+}
 #endif  // __AVX2__
 #endif  // __SSE4_1__
 
@@ -186,8 +244,78 @@ inline int movemask(Simd128<int8> simd) {
 #endif  // __VSX__
 #endif  // DIMSUM_USE_SIMULATED
 
+// Returns the carry-less (GF(2) polynomial) products of lhs[2k + kLhsLane] and
+// rhs[2k + kRhsLane] for each 128-bit segment k, as 128-bit values whose low
+// and high halves are lanes 2k and 2k + 1. kLhsLane and kRhsLane are 0 or 1.
+//
+// This maps to pclmulqdq (vpclmulqdq for 256-bit types) on x86. Without them,
+// the products are computed one bit at a time, which is much slower than the
+// instructions.
+template <int kLhsLane, int kRhsLane, typename Abi>
+Simd<uint64, Abi> clmul(Simd<uint64, Abi> lhs, Simd<uint64, Abi> rhs) {
+  static_assert((kLhsLane == 0 || kLhsLane == 1) &&
+                    (kRhsLane == 0 || kRhsLane == 1),
+                "Lanes must be 0 or 1");
+  return simulated::clmul<kLhsLane, kRhsLane>(lhs, rhs);
+}
+
+#ifndef DIMSUM_USE_SIMULATED
+#if defined(__PCLMUL__)
+template <int kLhsLane, int kRhsLane>
+Simd128<uint64> clmul(Simd128<uint64> lhs, Simd128<uint64> rhs) {
+  return _mm_clmulepi64_si128(to_raw(lhs), to_raw(rhs),
+                              kLhsLane | kRhsLane << 4);
+}
+
+#if defined(__VPCLMULQDQ__) && defined(__AVX2__)
+template <int kLhsLane, int kRhsLane>
+Simd256<uint64> clmul(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return _mm256_clmulepi64_epi128(to_raw(lhs), to_raw(rhs),
+                                  kLhsLane | kRhsLane << 4);
+}
+#endif  // defined(__VPCLMULQDQ__) && defined(__AVX2__)
+#endif  // defined(__PCLMUL__)
+#endif  // DIMSUM_USE_SIMULATED
+
 }  // namespace x86
 
+namespace detail {
+
+// Masks wider than a native register are split in halves until the halves
+// have a native movemask.
+template <typename T, typename Abi>
+using NeedsSplit = std::integral_constant<
+    bool, (Simd<T, Abi>::size() > 32 ||
+           Simd<T, Abi>::size() > NativeSimd<T>::size())>;
+
+template <typename T, typename Abi>
+typename std::enable_if<!NeedsSplit<T, Abi>::value, uint64>::type ToBitmask(
+    Simd<T, Abi> simd) {
+  return static_cast<uint32>(x86::movemask(simd));
+}
+
+template <typename T, typename Abi>
+typename std::enable_if<NeedsSplit<T, Abi>::value, uint64>::type ToBitmask(
+    Simd<T, Abi> simd) {
+  constexpr size_t kSize = Simd<T, Abi>::size();
+  static_assert(kSize <= 64, "Too many lanes for a bitmask");
+  auto halves = split_by<2>(simd);
+  return ToBitmask(halves[0]) | ToBitmask(halves[1]) << kSize / 2;
+}
+
+}  // namespace detail
+
+// Returns a bitmask whose bit i is set iff mask[i] is true. Masks of up to 64
+// lanes are supported.
+//
+// This is the portable way to turn the result of a comparison into an integer
+// for branching or iterating, e.g.
+//   uint64 bits = to_bitmask(block == NativeSimd<uint8>('"'));
+template <typename T, typename Abi>
+uint64 to_bitmask(SimdMask<T, Abi> mask) {
+  return detail::ToBitmask(Simd<detail::ToUnsigned<T>, Abi>(to_raw(mask)));
+}
+
 }  // namespace dimsum
 
 #endif  // DIMSUM_DIMSUM_X86_H_
@@ -14,6 +14,7 @@
 
 #include "dimsum_x86.h"
 #include <numeric>
+#include <random>
 #include "simulated.h"
 #include "gtest/gtest.h"
 
@@ -92,6 +93,79 @@ TEST(DimsumX86Test, Movemask) {
     EXPECT_EQ((1 << a.size()) - 1, simulated::movemask(a));
     EXPECT_EQ((1 << a.size()) - 1, x86::movemask(a));
   }
+  {
+    auto a =
+        NativeSimd<uint16>([](int i) { return i % 3 ? 0x8000 : 0x7fff; });
+    EXPECT_EQ(simulated::movemask(a), x86::movemask(a));
+    EXPECT_EQ(6, x86::movemask(a) & 7);
+    auto b = NativeSimd<int16>([](int i) { return i % 3 ? -1 : 1; });
+    EXPECT_EQ(simulated::movemask(b), x86::movemask(b));
+  }
+  {
+    auto a = NativeSimd<float>([](int i) { return i % 2 ? -0.f : 1.f; });
+    EXPECT_EQ(simulated::movemask(a), x86::movemask(a));
+    EXPECT_EQ(2, x86::movemask(a) & 3);
+  }
+  {
+    auto a = NativeSimd<double>([](int i) { return i % 2 ? 1. : -2.; });
+    EXPECT_EQ(simulated::movemask(a), x86::movemask(a));
+    EXPECT_EQ(1, x86::movemask(a) & 3);
+  }
+}
+
+template <typename SimdType>
+void TestClmul() {
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 100; i++) {
+    auto a = SimdType([&rng](int) { return rng(); });
+    auto b = SimdType([&rng](int) { return rng(); });
+    EXPECT_TRUE(all_of(simulated::clmul<0, 0>(a, b) == x86::clmul<0, 0>(a, b)));
+    EXPECT_TRUE(all_of(simulated::clmul<0, 1>(a, b) == x86::clmul<0, 1>(a, b)));
+    EXPECT_TRUE(all_of(simulated::clmul<1, 0>(a, b) == x86::clmul<1, 0>(a, b)));
+    EXPECT_TRUE(all_of(simulated::clmul<1, 1>(a, b) == x86::clmul<1, 1>(a, b)));
+  }
+}
+
+TEST(DimsumX86Test, Clmul) {
+  auto a = Simd128<uint64>([](int i) { return i ? 0x8000000000000001 : 3; });
+  auto b = Simd128<uint64>([](int i) { return i ? ~0ull : 3; });
+  // (x + 1)^2 = x^2 + 1.
+  auto r = x86::clmul<0, 0>(a, b);
+  EXPECT_EQ(5u, r[0]);
+  EXPECT_EQ(0u, r[1]);
+  // x^63 * (x + 1) = x^64 + x^63.
+  r = simulated::clmul<1, 0>(a, b);
+  EXPECT_EQ(0x8000000000000003u, r[0]);
+  EXPECT_EQ(1u, r[1]);
+  r = x86::clmul<1, 0>(a, b);
+  EXPECT_EQ(0x8000000000000003u, r[0]);
+  EXPECT_EQ(1u, r[1]);
+  TestClmul<Simd128<uint64>>();
+  TestClmul<NativeSimd<uint64>>();
+}
+
+TEST(DimsumX86Test, ToBitmask) {
+  {
+    auto a = NativeSimd<uint8>([](int i) { return i; });
+    EXPECT_EQ(1u << 5, to_bitmask(a == NativeSimd<uint8>(5)));
+    EXPECT_EQ((1ull << a.size()) - 1, to_bitmask(a == a));
+    EXPECT_EQ(0u, to_bitmask(a != a));
+  }
+  {
+    auto a = NativeSimd<float>([](int i) { return i; });
+    EXPECT_EQ(3u, to_bitmask(a < NativeSimd<float>(2)));
+  }
+  {
+    auto a = NativeSimd<int64>([](int i) { return -i; });
+    EXPECT_EQ((1ull << a.size()) - 2, to_bitmask(a < NativeSimd<int64>(0)));
+  }
+  {
+    using Simd512 =
+        ResizeBy<NativeSimd<uint8>, 64 / NativeSimd<uint8>::size()>;
+    auto a = Simd512([](int i) { return i; });
+    EXPECT_EQ(1ull << 63, to_bitmask(a == Simd512(63)));
+    EXPECT_EQ(~0ull, to_bitmask(a == a));
+  }
 }
 
 }  // namespace
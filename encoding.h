@@ -0,0 +1,434 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_ENCODING_H_
+#define DIMSUM_ENCODING_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Base64 (RFC 4648) and hex encoding and decoding.
+//
+// Both work on 16-byte segments of a NativeSimd<uint8> block, so that byte
+// shuffles within a segment are a single lookup(). Base64 encoding follows
+// Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2
+// Instructions": 12 input bytes are spread over 16 bytes, split into 6-bit
+// indices with shifts, and mapped to the alphabet with a 16-entry offset
+// table. Decoding validates characters with two nibble-indexed tables and
+// packs 6-bit values with maddubs() and mul_sum().
+//
+// Blocks are processed while a full block can be loaded; the remaining bytes
+// go through a scalar loop.
+
+namespace dimsum {
+
+enum class Base64Alphabet {
+  // A-Z, a-z, 0-9, '+', '/'. Encoded output is padded with '='.
+  kStandard,
+  // A-Z, a-z, 0-9, '-', '_'. Encoded output is not padded.
+  kUrlSafe,
+};
+
+namespace detail {
+
+using CodecBlock = NativeSimd<uint8>;
+
+constexpr size_t SpreadIndex(size_t i, size_t bytes) {
+  return i / 16 * bytes + (i % 16 < bytes ? i % 16 : 0);
+}
+
+constexpr size_t CompactIndex(size_t i, size_t bytes, size_t size) {
+  return i / bytes * 16 + i % bytes < size ? i / bytes * 16 + i % bytes : 0;
+}
+
+template <size_t kBytes, size_t... indices>
+CodecBlock SpreadSegmentsImpl(CodecBlock block,
+                              dimsum::index_sequence<indices...>) {
+  return shuffle<SpreadIndex(indices, kBytes)...>(block);
+}
+
+template <size_t kBytes, size_t... indices>
+CodecBlock CompactSegmentsImpl(CodecBlock block,
+                               dimsum::index_sequence<indices...>) {
+  return shuffle<CompactIndex(indices, kBytes, CodecBlock::size())...>(block);
+}
+
+// Moves bytes [kBytes * k, kBytes * (k + 1)) of block to the front of its
+// 16-byte segment k. kBytes is a multiple of 4.
+template <size_t kBytes>
+CodecBlock SpreadSegments(CodecBlock block) {
+  static_assert(kBytes % 4 == 0 && kBytes <= 16, "");
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__AVX2__)
+  constexpr int n = kBytes / 4;
+  return _mm256_permutevar8x32_epi32(
+      to_raw(block),
+      _mm256_setr_epi32(0, 1 < n ? 1 : n - 1, 2 < n ? 2 : n - 1,
+                        3 < n ? 3 : n - 1, n, n + (1 < n ? 1 : n - 1),
+                        n + (2 < n ? 2 : n - 1), n + (3 < n ? 3 : n - 1)));
+#else
+  if (CodecBlock::size() == 16) return block;
+  return SpreadSegmentsImpl<kBytes>(
+      block, dimsum::make_index_sequence<CodecBlock::size()>{});
+#endif
+}
+
+// The inverse of SpreadSegments: moves the first kBytes bytes of every 16-byte
+// segment together at the front of the block.
+template <size_t kBytes>
+CodecBlock CompactSegments(CodecBlock block) {
+  static_assert(kBytes % 4 == 0 && kBytes <= 16, "");
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__AVX2__)
+  constexpr int n = kBytes / 4;
+  return _mm256_permutevar8x32_epi32(
+      to_raw(block),
+      _mm256_setr_epi32(0, 1 < n ? 1 : 4 + 1 - n, 2 < n ? 2 : 4 + 2 - n,
+                        3 < n ? 3 : 4 + 3 - n, 4 + 4 - n, 4 + 5 - n, 7, 7));
+#else
+  if (CodecBlock::size() == 16) return block;
+  return CompactSegmentsImpl<kBytes>(
+      block, dimsum::make_index_sequence<CodecBlock::size()>{});
+#endif
+}
+
+struct Base64Tables {
+  explicit Base64Tables(const char* chars) {
+    memcpy(alphabet, chars, 64);
+    memset(values, 0xff, sizeof(values));
+    for (int i = 0; i < 64; i++) values[static_cast<uint8>(chars[i])] = i;
+    char62 = chars[62];
+    char63 = chars[63];
+
+    // Encoding: after reducing, 13 selects A-Z, 0 selects a-z, 1-10 select
+    // 0-9, and 11 and 12 select indices 62 and 63.
+    uint8 shift[16] = {};
+    shift[0] = 'a' - 26;
+    for (int i = 1; i <= 10; i++) shift[i] = '0' - 52;
+    shift[11] = char62 - 62;
+    shift[12] = char63 - 63;
+    shift[13] = 'A';
+    encode_shift = BroadcastNibbleTable(shift);
+    // Every 3-byte group b0 b1 b2 is spread to the 4-byte lane b1 b0 b2 b1,
+    // so that every index is a shift of the lane away.
+    static const uint8 kSpread[16] = {1, 0, 2,  1,  4,  3,  5,  4,
+                                      7, 6, 8,  7,  10, 9,  11, 10};
+    encode_spread = BroadcastNibbleTable(kSpread);
+
+    // Decoding: high nibbles with the same set of valid low nibbles share a
+    // bit in decode_hi. decode_lo has the bits of the high nibbles it is not
+    // valid with, so lo & hi is non-zero iff the character is invalid.
+    uint16 valid_lo[16] = {};
+    for (int i = 0; i < 64; i++) {
+      uint8 c = chars[i];
+      valid_lo[c >> 4] |= 1 << (c & 0xf);
+    }
+    uint8 lo[16] = {}, hi[16] = {};
+    int num_groups = 0;
+    for (int h = 0; h < 16; h++) {
+      for (int g = 0; g < h && hi[h] == 0; g++) {
+        if (valid_lo[g] == valid_lo[h]) hi[h] = hi[g];
+      }
+      if (hi[h] == 0) hi[h] = 1 << num_groups++;
+      for (int l = 0; l < 16; l++) {
+        if (!(valid_lo[h] >> l & 1)) lo[l] |= hi[h];
+      }
+    }
+    decode_lo = BroadcastNibbleTable(lo);
+    decode_hi = BroadcastNibbleTable(hi);
+
+    // Letters and digits map to their values by adding an offset that only
+    // depends on the high nibble. char62 and char63 are patched separately.
+    uint8 roll[16] = {};
+    for (int i = 0; i < 62; i++) {
+      roll[static_cast<uint8>(chars[i]) >> 4] =
+          static_cast<uint8>(i - static_cast<uint8>(chars[i]));
+    }
+    decode_roll = BroadcastNibbleTable(roll);
+    decode_62 = char62;
+    decode_63 = char63;
+    // Every 24-bit lane has its bytes in reverse order.
+    static const uint8 kPack[16] = {2,  1,  0,  6,  5,  4,    10,   9,
+                                    8,  14, 13, 12, 0x80, 0x80, 0x80, 0x80};
+    decode_pack = BroadcastNibbleTable(kPack);
+  }
+
+  char alphabet[64];
+  // The value of every character, or 0xff if it is not in the alphabet.
+  uint8 values[256];
+  uint8 char62;
+  uint8 char63;
+  CodecBlock encode_shift;
+  CodecBlock encode_spread;
+  CodecBlock decode_lo;
+  CodecBlock decode_hi;
+  CodecBlock decode_roll;
+  CodecBlock decode_pack;
+  CodecBlock decode_62;
+  CodecBlock decode_63;
+};
+
+inline const Base64Tables& GetBase64Tables(Base64Alphabet alphabet) {
+  static const Base64Tables standard(
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+  static const Base64Tables url_safe(
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
+  return alphabet == Base64Alphabet::kStandard ? standard : url_safe;
+}
+
+// Maps every 6-bit index in block to its character.
+inline CodecBlock Base64EncodeBlock(const Base64Tables& tables,
+                                    CodecBlock block) {
+  auto lanes = bit_cast<uint32>(lookup(block, tables.encode_spread));
+  auto indices = bit_cast<uint8>(
+      ((lanes >> 10) & NativeSimd<uint32>(0x0000003f)) |
+      ((lanes << 4) & NativeSimd<uint32>(0x00003f00)) |
+      ((lanes >> 6) & NativeSimd<uint32>(0x003f0000)) |
+      ((lanes << 8) & NativeSimd<uint32>(0x3f000000)));
+  CodecBlock reduced = sub_saturated(indices, CodecBlock(51));
+  reduced |= cmp_gt(NativeSimd<int8>(26), bit_cast<int8>(indices)) &
+             CodecBlock(13);
+  return indices + lookup(tables.encode_shift, reduced);
+}
+
+// Maps every character in block to its 6-bit value, and ORs non-zero bytes
+// into *error for invalid characters.
+inline CodecBlock Base64DecodeBlock(const Base64Tables& tables,
+                                    CodecBlock block, CodecBlock* error) {
+  CodecBlock hi = HighNibbles(block);
+  *error |= lookup(tables.decode_lo, block & CodecBlock(0x0f)) &
+            lookup(tables.decode_hi, hi);
+  CodecBlock values = block + lookup(tables.decode_roll, hi);
+  CodecBlock is_62 = cmp_eq(block, tables.decode_62);
+  CodecBlock is_63 = cmp_eq(block, tables.decode_63);
+  values ^= is_62 & (values ^ CodecBlock(62));
+  values ^= is_63 & (values ^ CodecBlock(63));
+  return values;
+}
+
+// Packs every 4 6-bit values into 3 bytes, at the front of each segment.
+inline CodecBlock Base64PackBlock(const Base64Tables& tables,
+                                  CodecBlock values) {
+  auto pairs = x86::maddubs(values, bit_cast<int8>(NativeSimd<int16>(0x0140)));
+  auto quads =
+      mul_sum<int32>(pairs, bit_cast<int16>(NativeSimd<int32>(0x00011000)));
+  return lookup(bit_cast<uint8>(quads), tables.decode_pack);
+}
+
+static constexpr char kHexDigits[] = "0123456789abcdef";
+
+}  // namespace detail
+
+// Returns the number of characters base64_encode() writes for size bytes.
+inline size_t base64_encoded_size(size_t size, Base64Alphabet alphabet) {
+  if (alphabet == Base64Alphabet::kStandard) return (size + 2) / 3 * 4;
+  return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+}
+
+// Encodes [data, data + size) to out, which must have room for
+// base64_encoded_size(size, alphabet) characters. Returns the number of
+// characters written.
+inline size_t base64_encode(
+    const char* data, size_t size, char* out,
+    Base64Alphabet alphabet = Base64Alphabet::kStandard) {
+  using detail::CodecBlock;
+  constexpr size_t kBlock = CodecBlock::size();
+  constexpr size_t kInput = kBlock / 4 * 3;
+  const detail::Base64Tables& tables = detail::GetBase64Tables(alphabet);
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  const uint8* end = p + size;
+  char* o = out;
+  for (; static_cast<size_t>(end - p) >= kBlock; p += kInput, o += kBlock) {
+    CodecBlock block = detail::SpreadSegments<12>(
+        detail::LoadUnaligned<CodecBlock>(p));
+    detail::StoreUnaligned(detail::Base64EncodeBlock(tables, block), o);
+  }
+  for (; end - p >= 3; p += 3) {
+    uint32 group = p[0] << 16 | p[1] << 8 | p[2];
+    *o++ = tables.alphabet[group >> 18];
+    *o++ = tables.alphabet[group >> 12 & 0x3f];
+    *o++ = tables.alphabet[group >> 6 & 0x3f];
+    *o++ = tables.alphabet[group & 0x3f];
+  }
+  if (p < end) {
+    uint32 group = p[0] << 16 | (end - p == 2 ? p[1] << 8 : 0);
+    *o++ = tables.alphabet[group >> 18];
+    *o++ = tables.alphabet[group >> 12 & 0x3f];
+    if (end - p == 2) *o++ = tables.alphabet[group >> 6 & 0x3f];
+    if (alphabet == Base64Alphabet::kStandard) {
+      if (end - p == 1) *o++ = '=';
+      *o++ = '=';
+    }
+  }
+  return o - out;
+}
+
+// Decodes [data, data + size) to out, which must have room for size / 4 * 3 + 2
+// bytes, and sets *decoded_size to the number of bytes written. Padding is
+// optional for both alphabets. Returns false if the input has characters
+// outside of the alphabet, misplaced padding, a truncated group, or non-zero
+// unused bits in the last group.
+inline bool base64_decode(const char* data, size_t size, char* out,
+                          size_t* decoded_size,
+                          Base64Alphabet alphabet = Base64Alphabet::kStandard) {
+  using detail::CodecBlock;
+  constexpr size_t kBlock = CodecBlock::size();
+  const detail::Base64Tables& tables = detail::GetBase64Tables(alphabet);
+  if (size % 4 == 0 && size > 0 && data[size - 1] == '=') {
+    size -= data[size - 2] == '=' ? 2 : 1;
+  }
+  if (size % 4 == 1) return false;
+
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  const uint8* end = p + size;
+  uint8* o = reinterpret_cast<uint8*>(out);
+  CodecBlock error = 0;
+  // A block decodes to kBlock / 4 * 3 bytes but is stored whole, so at least
+  // kBlock / 2 more characters (decoding to kBlock / 4 or more bytes) must
+  // follow.
+  for (; static_cast<size_t>(end - p) >= kBlock + kBlock / 2; p += kBlock) {
+    CodecBlock values = detail::Base64DecodeBlock(
+        tables, detail::LoadUnaligned<CodecBlock>(p), &error);
+    detail::StoreUnaligned(
+        detail::CompactSegments<12>(detail::Base64PackBlock(tables, values)),
+        o);
+    o += kBlock / 4 * 3;
+  }
+  if (x86::movemask(cmp_ne(error, CodecBlock(0))) != 0) return false;
+
+  uint32 group = 0;
+  int num_values = 0;
+  for (; p < end; p++) {
+    uint8 value = tables.values[*p];
+    if (value == 0xff) return false;
+    group = group << 6 | value;
+    if (++num_values == 4) {
+      *o++ = group >> 16;
+      *o++ = group >> 8;
+      *o++ = group;
+      group = 0;
+      num_values = 0;
+    }
+  }
+  if (num_values == 2) {
+    if (group & 0xf) return false;
+    *o++ = group >> 4;
+  } else if (num_values == 3) {
+    if (group & 0x3) return false;
+    *o++ = group >> 10;
+    *o++ = group >> 2;
+  }
+  *decoded_size = o - reinterpret_cast<uint8*>(out);
+  return true;
+}
+
+// Encodes [data, data + size) as lowercase hex to out, which must have room
+// for 2 * size characters.
+inline void hex_encode(const char* data, size_t size, char* out) {
+  using detail::CodecBlock;
+  constexpr size_t kBlock = CodecBlock::size();
+  static const uint8 kDuplicate[16] = {0, 0, 1, 1, 2, 2, 3, 3,
+                                       4, 4, 5, 5, 6, 6, 7, 7};
+  const CodecBlock duplicate = detail::BroadcastNibbleTable(kDuplicate);
+  uint8 digit_table[16];
+  memcpy(digit_table, detail::kHexDigits, 16);
+  const CodecBlock digits = detail::BroadcastNibbleTable(digit_table);
+  size_t i = 0;
+  for (; i + kBlock <= size; i += kBlock / 2) {
+    CodecBlock block = detail::SpreadSegments<8>(
+        detail::LoadUnaligned<CodecBlock>(data + i));
+    // Every byte b becomes the uint16 b << 8 | b, whose low byte must be the
+    // high nibble.
+    auto pairs = bit_cast<uint16>(lookup(block, duplicate));
+    auto nibbles = ((pairs >> 4) & NativeSimd<uint16>(0x000f)) |
+                   (pairs & NativeSimd<uint16>(0x0f00));
+    detail::StoreUnaligned(lookup(digits, bit_cast<uint8>(nibbles)),
+                           out + 2 * i);
+  }
+  for (; i < size; i++) {
+    uint8 b = data[i];
+    out[2 * i] = detail::kHexDigits[b >> 4];
+    out[2 * i + 1] = detail::kHexDigits[b & 0xf];
+  }
+}
+
+// Decodes the hex digits [data, data + size) to out, which must have room for
+// size / 2 bytes. Both cases are accepted. Returns false if size is odd or if
+// there are non-hex characters.
+inline bool hex_decode(const char* data, size_t size, char* out) {
+  using detail::CodecBlock;
+  constexpr size_t kBlock = CodecBlock::size();
+  if (size % 2 != 0) return false;
+
+  // High nibble 3 is a digit if the low nibble is at most 9, and high nibbles
+  // 4 and 6 are letters if the low nibble is between 1 and 6.
+  static const uint8 kInvalidLo[16] = {6, 4, 4, 4, 4, 4, 4, 6,
+                                       6, 6, 7, 7, 7, 7, 7, 7};
+  static const uint8 kGroupHi[16] = {4, 4, 4, 1, 2, 4, 2, 4,
+                                     4, 4, 4, 4, 4, 4, 4, 4};
+  static const uint8 kRoll[16] = {0, 0, 0, 0, 9, 0, 9, 0,
+                                  0, 0, 0, 0, 0, 0, 0, 0};
+  const CodecBlock invalid_lo = detail::BroadcastNibbleTable(kInvalidLo);
+  const CodecBlock group_hi = detail::BroadcastNibbleTable(kGroupHi);
+  const CodecBlock roll = detail::BroadcastNibbleTable(kRoll);
+  static const uint8 kPack[16] = {0,    2,    4,    6,    8,    10,
+                                  12,   14,   0x80, 0x80, 0x80, 0x80,
+                                  0x80, 0x80, 0x80, 0x80};
+  const CodecBlock pack = detail::BroadcastNibbleTable(kPack);
+
+  CodecBlock error = 0;
+  size_t i = 0;
+  // A block decodes to kBlock / 2 bytes but is stored whole, so another block
+  // must follow.
+  for (; i + 2 * kBlock <= size; i += kBlock) {
+    CodecBlock block = detail::LoadUnaligned<CodecBlock>(data + i);
+    CodecBlock lo = block & CodecBlock(0x0f);
+    CodecBlock hi = detail::HighNibbles(block);
+    error |= lookup(invalid_lo, lo) & lookup(group_hi, hi);
+    CodecBlock values = lo + lookup(roll, hi);
+    auto bytes =
+        x86::maddubs(values, bit_cast<int8>(NativeSimd<int16>(0x0110)));
+    detail::StoreUnaligned(
+        detail::CompactSegments<8>(lookup(bit_cast<uint8>(bytes), pack)),
+        out + i / 2);
+  }
+  if (x86::movemask(cmp_ne(error, CodecBlock(0))) != 0) return false;
+
+  for (; i < size; i += 2) {
+    int value = 0;
+    for (int j = 0; j < 2; j++) {
+      char c = data[i + j];
+      int nibble;
+      if (c >= '0' && c <= '9') {
+        nibble = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        nibble = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        nibble = c - 'A' + 10;
+      } else {
+        return false;
+      }
+      value = value << 4 | nibble;
+    }
+    out[i / 2] = value;
+  }
+  return true;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_ENCODING_H_
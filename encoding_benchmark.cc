@@ -0,0 +1,193 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "encoding.h"
+
+namespace dimsum {
+namespace {
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string RandomBytes(size_t size) {
+  std::mt19937 rng(0);
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = rng();
+  return bytes;
+}
+
+// Scalar references.
+
+size_t ScalarBase64Encode(const char* data, size_t size, char* out) {
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  char* o = out;
+  for (size_t i = 0; i + 3 <= size; i += 3) {
+    uint32 group = p[i] << 16 | p[i + 1] << 8 | p[i + 2];
+    *o++ = kAlphabet[group >> 18];
+    *o++ = kAlphabet[group >> 12 & 0x3f];
+    *o++ = kAlphabet[group >> 6 & 0x3f];
+    *o++ = kAlphabet[group & 0x3f];
+  }
+  return o - out;
+}
+
+bool ScalarBase64Decode(const char* data, size_t size, char* out) {
+  static const auto* kValues = [] {
+    static uint8 values[256];
+    memset(values, 0xff, sizeof(values));
+    for (int i = 0; i < 64; i++) values[static_cast<uint8>(kAlphabet[i])] = i;
+    return values;
+  }();
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  uint8 error = 0;
+  for (size_t i = 0; i + 4 <= size; i += 4) {
+    uint8 a = kValues[p[i]], b = kValues[p[i + 1]];
+    uint8 c = kValues[p[i + 2]], d = kValues[p[i + 3]];
+    error |= a | b | c | d;
+    uint32 group = a << 18 | b << 12 | c << 6 | d;
+    *out++ = group >> 16;
+    *out++ = group >> 8;
+    *out++ = group;
+  }
+  return !(error & 0x80);
+}
+
+void ScalarHexEncode(const char* data, size_t size, char* out) {
+  for (size_t i = 0; i < size; i++) {
+    uint8 b = data[i];
+    out[2 * i] = "0123456789abcdef"[b >> 4];
+    out[2 * i + 1] = "0123456789abcdef"[b & 0xf];
+  }
+}
+
+bool ScalarHexDecode(const char* data, size_t size, char* out) {
+  static const auto* kValues = [] {
+    static uint8 values[256];
+    memset(values, 0xff, sizeof(values));
+    for (int i = 0; i < 10; i++) values['0' + i] = i;
+    for (int i = 0; i < 6; i++) values['a' + i] = values['A' + i] = 10 + i;
+    return values;
+  }();
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  uint8 error = 0;
+  for (size_t i = 0; i < size; i += 2) {
+    uint8 hi = kValues[p[i]], lo = kValues[p[i + 1]];
+    error |= hi | lo;
+    out[i / 2] = hi << 4 | lo;
+  }
+  return !(error & 0x80);
+}
+
+// All benchmarks report the throughput of the binary side, with
+// state.range(0) binary bytes.
+
+void BM_ScalarBase64Encode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string out(data.size() * 4 / 3 + 4, '\0');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ScalarBase64Encode(data.data(), data.size(), &out[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ScalarBase64Encode)->Range(64, 1 << 20);
+
+void BM_Base64Encode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string out(data.size() * 4 / 3 + 4, '\0');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(base64_encode(data.data(), data.size(), &out[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Base64Encode)->Range(64, 1 << 20);
+
+void BM_ScalarBase64Decode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0) / 3 * 3);
+  std::string encoded(data.size() * 4 / 3, '\0');
+  base64_encode(data.data(), data.size(), &encoded[0]);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ScalarBase64Decode(encoded.data(), encoded.size(), &data[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ScalarBase64Decode)->Range(64, 1 << 20);
+
+void BM_Base64Decode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0) / 3 * 3);
+  std::string encoded(data.size() * 4 / 3, '\0');
+  base64_encode(data.data(), data.size(), &encoded[0]);
+  std::string out(data.size() + 2, '\0');
+  size_t size;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        base64_decode(encoded.data(), encoded.size(), &out[0], &size));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Base64Decode)->Range(64, 1 << 20);
+
+void BM_ScalarHexEncode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string out(2 * data.size(), '\0');
+  for (auto _ : state) {
+    ScalarHexEncode(data.data(), data.size(), &out[0]);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ScalarHexEncode)->Range(64, 1 << 20);
+
+void BM_HexEncode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string out(2 * data.size(), '\0');
+  for (auto _ : state) {
+    hex_encode(data.data(), data.size(), &out[0]);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_HexEncode)->Range(64, 1 << 20);
+
+void BM_ScalarHexDecode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string encoded(2 * data.size(), '\0');
+  hex_encode(data.data(), data.size(), &encoded[0]);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ScalarHexDecode(encoded.data(), encoded.size(), &data[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ScalarHexDecode)->Range(64, 1 << 20);
+
+void BM_HexDecode(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::string encoded(2 * data.size(), '\0');
+  hex_encode(data.data(), data.size(), &encoded[0]);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        hex_decode(encoded.data(), encoded.size(), &data[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_HexDecode)->Range(64, 1 << 20);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,158 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "encoding.h"
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+std::string Base64Encode(const std::string& data, Base64Alphabet alphabet) {
+  std::string out(base64_encoded_size(data.size(), alphabet), '\0');
+  EXPECT_EQ(out.size(),
+            base64_encode(data.data(), data.size(), &out[0], alphabet));
+  return out;
+}
+
+bool Base64Decode(const std::string& data, std::string* out,
+                  Base64Alphabet alphabet) {
+  out->assign(data.size() / 4 * 3 + 2, '\0');
+  size_t size = 0;
+  if (!base64_decode(data.data(), data.size(), &(*out)[0], &size, alphabet)) {
+    return false;
+  }
+  out->resize(size);
+  return true;
+}
+
+std::string RandomBytes(std::mt19937* rng, size_t size) {
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = (*rng)();
+  return bytes;
+}
+
+TEST(EncodingTest, Base64KnownAnswers) {
+  // RFC 4648, section 10.
+  const char* kVectors[][2] = {
+      {"", ""},
+      {"f", "Zg=="},
+      {"fo", "Zm8="},
+      {"foo", "Zm9v"},
+      {"foob", "Zm9vYg=="},
+      {"fooba", "Zm9vYmE="},
+      {"foobar", "Zm9vYmFy"},
+  };
+  for (const auto& vector : kVectors) {
+    EXPECT_EQ(vector[1], Base64Encode(vector[0], Base64Alphabet::kStandard));
+    std::string decoded;
+    EXPECT_TRUE(Base64Decode(vector[1], &decoded, Base64Alphabet::kStandard));
+    EXPECT_EQ(vector[0], decoded);
+  }
+  std::string all(256, '\0');
+  for (int i = 0; i < 256; i++) all[i] = i;
+  std::string encoded = Base64Encode(all, Base64Alphabet::kStandard);
+  EXPECT_EQ("AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwdHh8gISIjJCUmJygpKiss",
+            encoded.substr(0, 60));
+  EXPECT_EQ("8/T19vf4+fr7/P3+/w==", encoded.substr(encoded.size() - 20));
+  std::string url = Base64Encode(all, Base64Alphabet::kUrlSafe);
+  EXPECT_EQ("8_T19vf4-fr7_P3-_w", url.substr(url.size() - 18));
+}
+
+TEST(EncodingTest, Base64RoundTrip) {
+  std::mt19937 rng(0);
+  for (Base64Alphabet alphabet :
+       {Base64Alphabet::kStandard, Base64Alphabet::kUrlSafe}) {
+    for (size_t size = 0; size < 300; size++) {
+      std::string data = RandomBytes(&rng, size);
+      std::string encoded = Base64Encode(data, alphabet);
+      std::string decoded;
+      ASSERT_TRUE(Base64Decode(encoded, &decoded, alphabet)) << size;
+      EXPECT_EQ(data, decoded) << size;
+    }
+  }
+}
+
+TEST(EncodingTest, Base64RejectsInvalidInput) {
+  std::mt19937 rng(1);
+  std::string data = RandomBytes(&rng, 150);
+  std::string encoded = Base64Encode(data, Base64Alphabet::kStandard);
+  std::string decoded;
+  for (size_t i = 0; i < encoded.size() - 2; i++) {
+    for (char c : {'-', '_', '=', ' ', '\n', '\0', '\x80', '@', '[', '{'}) {
+      std::string corrupted = encoded;
+      corrupted[i] = c;
+      EXPECT_FALSE(
+          Base64Decode(corrupted, &decoded, Base64Alphabet::kStandard))
+          << i << " " << static_cast<int>(c);
+    }
+  }
+  std::string url_encoded = Base64Encode(data, Base64Alphabet::kUrlSafe);
+  for (size_t i = 0; i < url_encoded.size(); i++) {
+    for (char c : {'+', '/'}) {
+      std::string corrupted = url_encoded;
+      corrupted[i] = c;
+      EXPECT_FALSE(Base64Decode(corrupted, &decoded, Base64Alphabet::kUrlSafe));
+    }
+  }
+  // Truncated groups, padding and unused bits.
+  for (const char* invalid : {"A", "AAAAA", "A===", "Zg=", "Zh==", "Zm9=",
+                              "====", "Zg==Zg=="}) {
+    EXPECT_FALSE(Base64Decode(invalid, &decoded, Base64Alphabet::kStandard))
+        << invalid;
+  }
+  // Padding is optional.
+  EXPECT_TRUE(Base64Decode("Zm8", &decoded, Base64Alphabet::kStandard));
+  EXPECT_EQ("fo", decoded);
+}
+
+TEST(EncodingTest, Hex) {
+  std::mt19937 rng(2);
+  for (size_t size = 0; size < 200; size++) {
+    std::string data = RandomBytes(&rng, size);
+    std::string encoded(2 * size, '\0');
+    hex_encode(data.data(), size, &encoded[0]);
+    std::string expected;
+    for (char c : data) {
+      expected += "0123456789abcdef"[static_cast<uint8>(c) >> 4];
+      expected += "0123456789abcdef"[c & 0xf];
+    }
+    EXPECT_EQ(expected, encoded);
+
+    std::string decoded(size, '\0');
+    ASSERT_TRUE(hex_decode(encoded.data(), encoded.size(), &decoded[0]));
+    EXPECT_EQ(data, decoded);
+  }
+
+  std::string upper = "0123456789ABCDEFabcdef0123456789ABCDEFabcdef0123456789";
+  std::string decoded(upper.size() / 2, '\0');
+  ASSERT_TRUE(hex_decode(upper.data(), upper.size(), &decoded[0]));
+  EXPECT_EQ("\x01\x23\x45\x67\x89\xab\xcd\xef", decoded.substr(0, 8));
+
+  EXPECT_FALSE(hex_decode("abc", 3, &decoded[0]));
+  for (size_t i = 0; i < upper.size(); i++) {
+    for (char c : {'g', 'G', '/', ':', '@', '`', ' ', '\x80', '\xb0'}) {
+      std::string corrupted = upper;
+      corrupted[i] = c;
+      EXPECT_FALSE(hex_decode(corrupted.data(), corrupted.size(), &decoded[0]))
+          << i << " " << c;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
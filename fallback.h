@@ -0,0 +1,189 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_FALLBACK_H_
+#define DIMSUM_FALLBACK_H_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "port.h"
+#include "types.h"
+
+// Instrumentation of the generic implementations in operations.h, which are
+// used when no specialization for the element type and ABI exists. Some
+// compute one lane at a time; the others use the 16-byte specializations or
+// whatever vector code the compiler finds. Each generic implementation calls
+// detail::NoteFallback<Op, T, Abi>(), which does nothing unless one of the
+// following is defined (in every translation unit):
+//
+// DIMSUM_WARN_ON_FALLBACK: instantiating a generic implementation emits a
+//   deprecation warning. The warning names the operation tag (e.g.
+//   detail::fallback::sqrt), the element type and the ABI.
+// DIMSUM_REQUIRE_NATIVE: instantiating a generic implementation fails to
+//   compile. The instantiation context names the operation, element type and
+//   ABI.
+// DIMSUM_COUNT_FALLBACKS: each call of a generic implementation increments a
+//   counter, which fallback_counts() reports. This finds the fallbacks that
+//   are hot, as opposed to merely instantiated.
+
+namespace dimsum {
+
+// The number of calls of the generic implementation of op for Simd objects of
+// size elements of type element.
+struct FallbackCount {
+  const char* op;
+  const char* element;
+  size_t size;
+  // Whether the ABI is the native one of NativeSimd<element, size>.
+  bool native;
+  uint64 count;
+};
+
+namespace detail {
+
+// Tags of the operations with generic implementations.
+namespace fallback {
+
+#define DIMSUM_FALLBACK_OP(op_name)                \
+  struct op_name {                                 \
+    static const char* Name() { return #op_name; } \
+  };
+
+DIMSUM_FALLBACK_OP(lookup)
+DIMSUM_FALLBACK_OP(add_saturated)
+DIMSUM_FALLBACK_OP(sub_saturated)
+DIMSUM_FALLBACK_OP(reciprocal_estimate)
+DIMSUM_FALLBACK_OP(sqrt)
+DIMSUM_FALLBACK_OP(reciprocal_sqrt_estimate)
+DIMSUM_FALLBACK_OP(round)
+DIMSUM_FALLBACK_OP(bit_cast)
+DIMSUM_FALLBACK_OP(simd_cast)
+DIMSUM_FALLBACK_OP(cmp_eq)
+DIMSUM_FALLBACK_OP(cmp_ne)
+DIMSUM_FALLBACK_OP(cmp_lt)
+DIMSUM_FALLBACK_OP(cmp_le)
+DIMSUM_FALLBACK_OP(cmp_gt)
+DIMSUM_FALLBACK_OP(cmp_ge)
+DIMSUM_FALLBACK_OP(round_to_integer)
+DIMSUM_FALLBACK_OP(fma)
+DIMSUM_FALLBACK_OP(load_converted)
+DIMSUM_FALLBACK_OP(store_converted)
+DIMSUM_FALLBACK_OP(store_saturated)
+
+#undef DIMSUM_FALLBACK_OP
+
+}  // namespace fallback
+
+template <typename T>
+const char* ElementName() {
+  static const char* const kIntegerNames[2][4] = {
+      {"uint8", "uint16", "uint32", "uint64"},
+      {"int8", "int16", "int32", "int64"},
+  };
+  if (std::is_floating_point<T>::value) {
+    return sizeof(T) == 4 ? "float" : "double";
+  }
+  const int log_size = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1
+                                          : sizeof(T) == 4 ? 2 : 3;
+  return kIntegerNames[std::is_signed<T>::value][log_size];
+}
+
+struct FallbackCounter {
+  FallbackCount info;
+  std::atomic<uint64> count;
+};
+
+struct FallbackRegistry {
+  std::mutex mutex;
+  std::vector<FallbackCounter*> counters;
+};
+
+// Never destroyed, so that fallbacks called during static destruction still
+// find it.
+inline FallbackRegistry& GetFallbackRegistry() {
+  static FallbackRegistry* registry = new FallbackRegistry;
+  return *registry;
+}
+
+inline FallbackCounter* RegisterFallback(const char* op, const char* element,
+                                         size_t size, bool native) {
+  FallbackCounter* counter = new FallbackCounter;
+  counter->info = FallbackCount{op, element, size, native, 0};
+  counter->count.store(0, std::memory_order_relaxed);
+  FallbackRegistry& registry = GetFallbackRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.counters.push_back(counter);
+  return counter;
+}
+
+template <typename...>
+struct DependentFalse : std::false_type {};
+
+template <typename Op, typename T, typename Abi>
+#ifdef DIMSUM_WARN_ON_FALLBACK
+__attribute__((deprecated(
+    "instantiates the generic per-lane implementation of a dimsum operation; "
+    "see fallback.h")))
+#endif
+inline void NoteFallback() {
+#ifdef DIMSUM_REQUIRE_NATIVE
+  static_assert(DependentFalse<Op, T, Abi>::value,
+                "DIMSUM_REQUIRE_NATIVE: the generic per-lane implementation "
+                "of a dimsum operation is instantiated; the instantiation "
+                "context names the operation, element type and ABI");
+#endif
+#ifdef DIMSUM_COUNT_FALLBACKS
+  using SimdType = Simd<T, Abi>;
+  static FallbackCounter* const counter = RegisterFallback(
+      Op::Name(), ElementName<T>(), SimdType::size(),
+      std::is_same<SimdType, NativeSimd<T, SimdType::size()>>::value);
+  counter->count.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+}  // namespace detail
+
+// Returns the number of calls of each generic implementation called since
+// the start of the program or the last reset_fallback_counts(), in the order
+// of their first calls. Always empty unless DIMSUM_COUNT_FALLBACKS is
+// defined.
+inline std::vector<FallbackCount> fallback_counts() {
+  detail::FallbackRegistry& registry = detail::GetFallbackRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<FallbackCount> counts;
+  for (const detail::FallbackCounter* counter : registry.counters) {
+    counts.push_back(counter->info);
+    counts.back().count = counter->count.load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+// Sets the counts reported by fallback_counts() to 0.
+inline void reset_fallback_counts() {
+  detail::FallbackRegistry& registry = detail::GetFallbackRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (detail::FallbackCounter* counter : registry.counters) {
+    counter->count.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_FALLBACK_H_
@@ -0,0 +1,99 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The only translation unit of the test, so the mode is consistent.
+#define DIMSUM_COUNT_FALLBACKS
+
+#include "fallback.h"
+
+#include <cstring>
+#include <vector>
+
+#include "dimsum.h"
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Returns the count of op on size elements of type element, or -1 if op was
+// never called.
+int64 CountOf(const char* op, const char* element, size_t size) {
+  for (const FallbackCount& count : fallback_counts()) {
+    if (strcmp(count.op, op) == 0 && strcmp(count.element, element) == 0 &&
+        count.size == size) {
+      return count.count;
+    }
+  }
+  return -1;
+}
+
+TEST(FallbackTest, CountsCalls) {
+  reset_fallback_counts();
+  // There are no specializations for 64-bit vectors.
+  Simd64<float> simd(4.f);
+  for (int i = 0; i < 3; i++) {
+    simd = sqrt(simd);
+  }
+  EXPECT_EQ(3, CountOf("sqrt", "float", 2));
+  for (const FallbackCount& count : fallback_counts()) {
+    if (strcmp(count.op, "sqrt") == 0) {
+      EXPECT_TRUE(count.native);
+    }
+  }
+
+  // Comparisons of NativeSimd objects use the vector extensions, not a loop.
+  Simd64<int16> lhs(1), rhs(2);
+  cmp_eq(lhs, rhs);
+  EXPECT_EQ(-1, CountOf("cmp_eq", "int16", 4));
+  add_saturated(lhs, rhs);
+  EXPECT_EQ(1, CountOf("add_saturated", "int16", 4));
+
+  // Converting loads are, but loads and stores of the same type are not.
+  const uint8 bytes[2] = {1, 2};
+  float floats[2];
+  store_converted(load_converted<Simd64<float>>(bytes), floats);
+  store_converted(load_converted<Simd64<float>>(floats), floats);
+  EXPECT_EQ(1, CountOf("load_converted", "float", 2));
+  EXPECT_EQ(-1, CountOf("store_converted", "float", 2));
+}
+
+TEST(FallbackTest, Reset) {
+  sqrt(Simd64<float>(1.f));
+  EXPECT_LT(0, CountOf("sqrt", "float", 2));
+  reset_fallback_counts();
+  EXPECT_EQ(0, CountOf("sqrt", "float", 2));
+}
+
+#ifndef DIMSUM_USE_SIMULATED
+TEST(FallbackTest, NativeIsNotCounted) {
+  reset_fallback_counts();
+  sqrt(Simd128<float>(4.f));
+  EXPECT_EQ(-1, CountOf("sqrt", "float", 4));
+  // Casts of vector registers, at any width.
+  bit_cast<uint32>(Simd64<float>(1.f));
+  bit_cast<uint8>(Simd256<double>(1.));
+  EXPECT_EQ(-1, CountOf("bit_cast", "float", 2));
+  EXPECT_EQ(-1, CountOf("bit_cast", "double", 4));
+  // Widening, narrowing and integer-float conversions.
+  simd_cast<int32>(Simd64<int16>(1));
+  static_simd_cast<uint8>(Simd128<int16>(1));
+  static_simd_cast<float>(Simd128<int32>(1));
+  EXPECT_EQ(-1, CountOf("simd_cast", "int16", 4));
+  EXPECT_EQ(-1, CountOf("simd_cast", "uint16", 8));
+  EXPECT_EQ(-1, CountOf("simd_cast", "int32", 4));
+}
+#endif
+
+}  // namespace
+}  // namespace dimsum
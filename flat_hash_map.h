@@ -0,0 +1,321 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_FLAT_HASH_MAP_H_
+#define DIMSUM_FLAT_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+#include "hash.h"
+#include "search.h"
+
+// An open addressing hash map in the style of SwissTable.
+//
+// Each slot has a control byte: kControlEmpty, kControlDeleted (a tombstone),
+// or the low 7 bits of the hash of its key (H2) when it is full. Slots are
+// probed a group at a time, with one cmp_eq + movemask of the group's control
+// bytes against H2. A group is NativeSimd<uint8>: 16 slots on SSE and NEON,
+// and 32 on AVX2. The probe sequence visits groups in triangular steps from
+// the one chosen by the rest of the hash (H1), and ends at the first group
+// with an empty slot.
+
+namespace dimsum {
+
+constexpr uint8 kControlEmpty = 0x80;
+constexpr uint8 kControlDeleted = 0xfe;
+
+// The control bytes of one group of slots. Full slots hold values in
+// [0, 0x80), so the special values are exactly those with the sign bit set.
+class GroupProbe {
+ public:
+  using Block = NativeSimd<uint8>;
+
+  static_assert(Block::size() <= 32, "Group masks must fit in uint32");
+
+  static constexpr size_t size() { return Block::size(); }
+
+  // Loads size() control bytes from control, which needs no alignment.
+  explicit GroupProbe(const uint8* control)
+      : control_(detail::LoadUnaligned<Block>(control)) {}
+
+  // Returns the mask of slots whose control byte is h2.
+  uint32 match(uint8 h2) const {
+    return x86::movemask(cmp_eq(control_, Splat(h2)));
+  }
+
+  uint32 match_empty() const {
+    return x86::movemask(cmp_eq(control_, Splat(kControlEmpty)));
+  }
+
+  uint32 match_empty_or_deleted() const { return x86::movemask(control_); }
+
+ private:
+  // Same as Block(c). GCC builds a 32-byte broadcast of uint8 from two 16-byte
+  // stores and one load, which cannot be forwarded; the load then waits for
+  // the probes of earlier keys to retire, and their cache misses no longer
+  // overlap. A broadcast of uint64 stays in registers.
+  static Block Splat(uint8 c) {
+    constexpr int kWords = Block::size() / 8;
+    return bit_cast<uint8>(
+        NativeSimd<uint64, kWords>(c * 0x0101010101010101ull));
+  }
+
+  Block control_;
+};
+
+// The default hash of FlatHashMap. Integral keys are hashed like hash_keys,
+// strings with hash64, and other types with std::hash, followed by a mix to
+// spread identity hashes over all bits.
+template <typename K, typename Enable = void>
+struct FlatHash {
+  uint64 operator()(const K& key) const {
+    return detail::HashAvalanche(static_cast<uint64>(std::hash<K>()(key)));
+  }
+};
+
+template <typename K>
+struct FlatHash<K, typename std::enable_if<std::is_integral<K>::value>::type> {
+  uint64 operator()(K key) const {
+    return detail::HashUpTo8(static_cast<uint64>(key), 8);
+  }
+};
+
+template <>
+struct FlatHash<std::string> {
+  uint64 operator()(const std::string& key) const {
+    return hash64(key.data(), key.size());
+  }
+};
+
+// A hash map from K to V. K and V must be default constructible and
+// assignable; slots that are not full hold default constructed objects.
+// Pointers to values are invalidated by insertions that grow the table.
+template <typename K, typename V, typename Hash = FlatHash<K>>
+class FlatHashMap {
+ public:
+  FlatHashMap() { Resize(1); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return control_.size(); }
+
+  // Returns the value of key, or nullptr if key is absent.
+  V* find(const K& key) { return Find(key, hash_(key)); }
+  const V* find(const K& key) const {
+    const size_t index = FindIndex(key, hash_(key));
+    return index == kNotFound ? nullptr : &slots_[index].value;
+  }
+
+  // Sets values[i] to find(keys[i]) for i in [0, n). The lookups are done in
+  // batches, and the control bytes and slots of the keys in a batch are
+  // prefetched in two rounds before they are probed, so that the cache misses
+  // of different keys overlap.
+  void find_many(const K* keys, size_t n, V** values) {
+    constexpr size_t kBatch = 16;
+    uint64 hashes[kBatch];
+    for (size_t begin = 0; begin < n; begin += kBatch) {
+      const size_t batch = std::min(kBatch, n - begin);
+      for (size_t i = 0; i < batch; i++) {
+        hashes[i] = hash_(keys[begin + i]);
+        __builtin_prefetch(&control_[FirstGroup(hashes[i])]);
+      }
+      for (size_t i = 0; i < batch; i++) {
+        const size_t group = FirstGroup(hashes[i]);
+        uint32 mask = GroupProbe(&control_[group]).match(H2(hashes[i]));
+        if (mask != 0) {
+          __builtin_prefetch(&slots_[group + detail::CountTrailingZeros(mask)]);
+        }
+      }
+      for (size_t i = 0; i < batch; i++) {
+        values[begin + i] = Find(keys[begin + i], hashes[i]);
+      }
+    }
+  }
+
+  // Inserts key with value if key is absent. Returns the value of key, and
+  // whether it was inserted.
+  std::pair<V*, bool> insert(const K& key, const V& value) {
+    const uint64 hash = hash_(key);
+    if (V* found = Find(key, hash)) return {found, false};
+    Slot& slot = slots_[Claim(hash)];
+    slot.key = key;
+    slot.value = value;
+    return {&slot.value, true};
+  }
+
+  V& operator[](const K& key) { return *insert(key, V()).first; }
+
+  // Removes key. Returns whether it was present.
+  bool erase(const K& key) {
+    const uint64 hash = hash_(key);
+    const size_t index = FindIndex(key, hash);
+    if (index == kNotFound) return false;
+    // A probe only continues past a group without empty slots, so if the
+    // group has one, no probe can depend on this slot and it becomes empty
+    // rather than a tombstone.
+    const size_t group = index & ~(GroupProbe::size() - 1);
+    if (GroupProbe(&control_[group]).match_empty() != 0) {
+      control_[index] = kControlEmpty;
+      growth_left_++;
+    } else {
+      control_[index] = kControlDeleted;
+    }
+    slots_[index] = Slot();
+    size_--;
+    return true;
+  }
+
+  void clear() {
+    size_ = 0;
+    Resize(1);
+  }
+
+  // Makes room for n elements without growing.
+  void reserve(size_t n) {
+    size_t num_groups = 1;
+    while (MaxSize(num_groups * GroupProbe::size()) < n) num_groups *= 2;
+    if (num_groups * GroupProbe::size() > capacity()) Rehash(num_groups);
+  }
+
+  // Calls visit(key, value) on every element, in no particular order.
+  template <typename Visit>
+  void for_each(Visit&& visit) {
+    for (size_t i = 0; i < capacity(); i++) {
+      if (control_[i] < kControlEmpty) visit(slots_[i].key, slots_[i].value);
+    }
+  }
+
+ private:
+  struct Slot {
+    K key = K();
+    V value = V();
+  };
+
+  static constexpr size_t kNotFound = ~size_t{0};
+
+  // At most 7/8 of the slots are full or deleted.
+  static size_t MaxSize(size_t capacity) { return capacity - capacity / 8; }
+
+  static uint8 H2(uint64 hash) { return hash & 0x7f; }
+
+  size_t FirstGroup(uint64 hash) const {
+    return ProbeSequence(hash, group_mask_).offset();
+  }
+
+  // The groups visited for a hash, as offsets of their first slot.
+  class ProbeSequence {
+   public:
+    ProbeSequence(uint64 hash, size_t group_mask)
+        : group_(hash >> 7 & group_mask), group_mask_(group_mask) {}
+
+    size_t offset() const { return group_ * GroupProbe::size(); }
+
+    // Triangular steps visit every group when their number is a power of 2.
+    void next() { group_ = (group_ + ++step_) & group_mask_; }
+
+   private:
+    size_t group_;
+    size_t group_mask_;
+    size_t step_ = 0;
+  };
+
+  size_t FindIndex(const K& key, uint64 hash) const {
+    const uint8 h2 = H2(hash);
+    for (ProbeSequence seq(hash, group_mask_);; seq.next()) {
+      const size_t group = seq.offset();
+      GroupProbe probe(&control_[group]);
+      for (int i : BitmaskIterator<uint32>(probe.match(h2))) {
+        if (slots_[group + i].key == key) return group + i;
+      }
+      if (probe.match_empty() != 0) return kNotFound;
+    }
+  }
+
+  V* Find(const K& key, uint64 hash) {
+    size_t index = FindIndex(key, hash);
+    return index == kNotFound ? nullptr : &slots_[index].value;
+  }
+
+  // Returns the first empty or deleted slot in the probe sequence of hash.
+  size_t FindFree(uint64 hash) const {
+    for (ProbeSequence seq(hash, group_mask_);; seq.next()) {
+      const size_t group = seq.offset();
+      uint32 mask = GroupProbe(&control_[group]).match_empty_or_deleted();
+      if (mask != 0) return group + detail::CountTrailingZeros(mask);
+    }
+  }
+
+  // Marks a free slot for hash as full, growing the table if needed, and
+  // returns its index.
+  size_t Claim(uint64 hash) {
+    size_t index = FindFree(hash);
+    if (growth_left_ == 0 && control_[index] == kControlEmpty) {
+      // Tombstones count against the load factor. If they are many, dropping
+      // them is enough.
+      const size_t num_groups = capacity() / GroupProbe::size();
+      Rehash(size_ * 2 < MaxSize(capacity()) ? num_groups : num_groups * 2);
+      index = FindFree(hash);
+    }
+    if (control_[index] == kControlEmpty) growth_left_--;
+    control_[index] = H2(hash);
+    size_++;
+    return index;
+  }
+
+  void Resize(size_t num_groups) {
+    control_.assign(num_groups * GroupProbe::size(), kControlEmpty);
+    slots_.assign(control_.size(), Slot());
+    group_mask_ = num_groups - 1;
+    growth_left_ = MaxSize(capacity()) - size_;
+  }
+
+  void Rehash(size_t num_groups) {
+    std::vector<uint8> old_control;
+    std::vector<Slot> old_slots;
+    old_control.swap(control_);
+    old_slots.swap(slots_);
+    Resize(num_groups);
+    for (size_t i = 0; i < old_control.size(); i++) {
+      if (old_control[i] >= kControlEmpty) continue;
+      const uint64 hash = hash_(old_slots[i].key);
+      const size_t index = FindFree(hash);
+      control_[index] = H2(hash);
+      slots_[index] = std::move(old_slots[i]);
+    }
+  }
+
+  std::vector<uint8> control_;
+  std::vector<Slot> slots_;
+  size_t group_mask_ = 0;
+  size_t size_ = 0;
+  // The number of empty slots that can be filled before the table grows.
+  size_t growth_left_ = 0;
+  Hash hash_;
+};
+
+template <typename K, typename V, typename Hash>
+constexpr size_t FlatHashMap<K, V, Hash>::kNotFound;
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_FLAT_HASH_MAP_H_
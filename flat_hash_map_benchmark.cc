@@ -0,0 +1,114 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "flat_hash_map.h"
+
+namespace dimsum {
+namespace {
+
+// The number of lookups per iteration of the lookup benchmarks.
+constexpr size_t kNumLookups = 1 << 16;
+
+std::vector<uint64> RandomKeys(size_t n, uint64 seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<uint64> keys(n);
+  for (uint64& key : keys) key = rng();
+  return keys;
+}
+
+// Half of the lookups hit.
+std::vector<uint64> LookupKeys(const std::vector<uint64>& keys) {
+  std::vector<uint64> lookups = RandomKeys(kNumLookups, 1);
+  std::mt19937_64 rng(2);
+  for (size_t i = 0; i < kNumLookups; i += 2) {
+    lookups[i] = keys[rng() % keys.size()];
+  }
+  return lookups;
+}
+
+template <typename Map>
+void BM_Insert(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys(state.range(0), 0);
+  for (auto _ : state) {
+    Map map;
+    for (uint64 key : keys) map[key] = key;
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_Insert, std::unordered_map<uint64, uint64>)
+    ->Range(1 << 20, 100 << 20)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Insert, FlatHashMap<uint64, uint64>)
+    ->Range(1 << 20, 100 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_StdFind(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys(state.range(0), 0);
+  std::unordered_map<uint64, uint64> map;
+  for (uint64 key : keys) map[key] = key;
+  std::vector<uint64> lookups = LookupKeys(keys);
+  for (auto _ : state) {
+    uint64 sum = 0;
+    for (uint64 key : lookups) {
+      auto it = map.find(key);
+      if (it != map.end()) sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumLookups);
+}
+BENCHMARK(BM_StdFind)->Range(1 << 20, 100 << 20);
+
+void BM_Find(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys(state.range(0), 0);
+  FlatHashMap<uint64, uint64> map;
+  for (uint64 key : keys) map[key] = key;
+  std::vector<uint64> lookups = LookupKeys(keys);
+  for (auto _ : state) {
+    uint64 sum = 0;
+    for (uint64 key : lookups) {
+      if (const uint64* value = map.find(key)) sum += *value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumLookups);
+}
+BENCHMARK(BM_Find)->Range(1 << 20, 100 << 20);
+
+void BM_FindMany(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys(state.range(0), 0);
+  FlatHashMap<uint64, uint64> map;
+  for (uint64 key : keys) map[key] = key;
+  std::vector<uint64> lookups = LookupKeys(keys);
+  std::vector<uint64*> values(kNumLookups);
+  for (auto _ : state) {
+    map.find_many(lookups.data(), kNumLookups, values.data());
+    uint64 sum = 0;
+    for (const uint64* value : values) {
+      if (value != nullptr) sum += *value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumLookups);
+}
+BENCHMARK(BM_FindMany)->Range(1 << 20, 100 << 20);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,157 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "flat_hash_map.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+TEST(GroupProbeTest, Match) {
+  const size_t size = GroupProbe::size();
+  EXPECT_EQ(NativeSimd<uint8>::size(), size);
+  std::vector<uint8> control(size, kControlEmpty);
+  control[0] = 5;
+  control[size - 1] = 5;
+  control[2] = kControlDeleted;
+  control[3] = 0x7f;
+  GroupProbe probe(control.data());
+  EXPECT_EQ(1u | 1u << (size - 1), probe.match(5));
+  EXPECT_EQ(1u << 3, probe.match(0x7f));
+  EXPECT_EQ(0u, probe.match(6));
+  const uint32 all = size == 32 ? ~0u : (1u << size) - 1;
+  EXPECT_EQ(all & ~(1u | 1u << (size - 1) | 1u << 2 | 1u << 3),
+            probe.match_empty());
+  EXPECT_EQ(all & ~(1u | 1u << (size - 1) | 1u << 3),
+            probe.match_empty_or_deleted());
+}
+
+TEST(FlatHashMapTest, Basic) {
+  FlatHashMap<int, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(1));
+  auto inserted = map.insert(1, 10);
+  EXPECT_TRUE(inserted.second);
+  EXPECT_EQ(10, *inserted.first);
+  inserted = map.insert(1, 20);
+  EXPECT_FALSE(inserted.second);
+  EXPECT_EQ(10, *inserted.first);
+  map[2] = 30;
+  map[2] += 1;
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(31, *map.find(2));
+  const FlatHashMap<int, int>& const_map = map;
+  EXPECT_EQ(10, *const_map.find(1));
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_EQ(nullptr, map.find(1));
+  EXPECT_EQ(1u, map.size());
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(2));
+}
+
+TEST(FlatHashMapTest, MatchesUnorderedMap) {
+  // Few distinct keys and many erasures, so that tombstones are created and
+  // reused, and the table is rehashed in place.
+  std::mt19937 rng(0);
+  FlatHashMap<uint64, int> map;
+  std::unordered_map<uint64, int> expected;
+  for (int i = 0; i < 200000; i++) {
+    const uint64 key = rng() % 2000;
+    switch (rng() % 3) {
+      case 0:
+        EXPECT_EQ(expected.insert({key, i}).second,
+                  map.insert(key, i).second);
+        break;
+      case 1:
+        EXPECT_EQ(expected.erase(key) == 1, map.erase(key));
+        break;
+      case 2: {
+        const int* value = map.find(key);
+        auto it = expected.find(key);
+        ASSERT_EQ(it != expected.end(), value != nullptr) << key;
+        if (value != nullptr) {
+          EXPECT_EQ(it->second, *value);
+        }
+      }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  EXPECT_LE(map.capacity(), 4096u);
+  size_t visited = 0;
+  map.for_each([&](uint64 key, int value) {
+    EXPECT_EQ(expected.at(key), value);
+    visited++;
+  });
+  EXPECT_EQ(expected.size(), visited);
+}
+
+TEST(FlatHashMapTest, Grow) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 100000; i++) map[i] = -i;
+  EXPECT_EQ(100000u, map.size());
+  EXPECT_LE(map.size(), map.capacity() - map.capacity() / 8);
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_NE(nullptr, map.find(i));
+    EXPECT_EQ(-i, *map.find(i));
+  }
+  EXPECT_EQ(nullptr, map.find(100000));
+  EXPECT_EQ(nullptr, map.find(-1));
+}
+
+TEST(FlatHashMapTest, Reserve) {
+  FlatHashMap<int, int> map;
+  map[7] = 7;
+  map.reserve(10000);
+  const size_t capacity = map.capacity();
+  EXPECT_GE(capacity - capacity / 8, 10000u);
+  EXPECT_EQ(7, *map.find(7));
+  for (int i = 0; i < 10000; i++) map[i] = i;
+  EXPECT_EQ(capacity, map.capacity());
+}
+
+TEST(FlatHashMapTest, StringKeys) {
+  FlatHashMap<std::string, int> map;
+  for (int i = 0; i < 1000; i++) {
+    map[std::string(i % 40, 'x') + std::to_string(i)] = i;
+  }
+  for (int i = 0; i < 1000; i++) {
+    const int* value = map.find(std::string(i % 40, 'x') + std::to_string(i));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(nullptr, map.find("x"));
+}
+
+TEST(FlatHashMapTest, FindMany) {
+  FlatHashMap<uint64, uint64> map;
+  for (uint64 i = 0; i < 1000; i++) map[i * 3] = i;
+  std::vector<uint64> keys(1001);
+  for (uint64 i = 0; i < keys.size(); i++) keys[i] = i * 5;
+  std::vector<uint64*> values(keys.size());
+  map.find_many(keys.data(), keys.size(), values.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(map.find(keys[i]), values[i]) << keys[i];
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_HASH_H_
+#define DIMSUM_HASH_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+
+// A fast non-cryptographic 64-bit hash in the style of xxHash3, for hash
+// tables and partitioning. It is not resistant to hash flooding.
+//
+// Inputs longer than 16 bytes are consumed in 64-byte stripes by 8
+// independent uint64 accumulators. For each stripe, with w[i] being the i-th
+// little-endian uint32 of the stripe XORed with a secret, and d[j] the j-th
+// uint64 of the stripe, accumulator j adds w[j] * w[j + 8] + d[j ^ 4]. The
+// multiplications are mul_widened of uint32 lanes (pmuludq on x86). Every 16
+// stripes, the accumulators are scrambled, and at the end they are mixed into
+// one value. Inputs of up to 16 bytes are mixed directly with scalar
+// multiplications.
+//
+// The hash values are defined by the scalar description above, and not by the
+// SIMD width of the target: they are the same for SSE, AVX2, NEON and
+// simulated builds, and can be persisted. They assume a little-endian target.
+
+namespace dimsum {
+namespace detail {
+
+constexpr uint64 kHashPrime32_1 = 0x9e3779b1u;
+constexpr uint64 kHashPrime32_2 = 0x85ebca77u;
+constexpr uint64 kHashPrime32_3 = 0xc2b2ae3du;
+constexpr uint64 kHashPrime64_1 = 0x9e3779b185ebca87ull;
+constexpr uint64 kHashPrime64_2 = 0xc2b2ae3d27d4eb4full;
+constexpr uint64 kHashPrime64_3 = 0x165667b19e3779f9ull;
+constexpr uint64 kHashPrime64_4 = 0x85ebca77c2b2ae63ull;
+constexpr uint64 kHashPrime64_5 = 0x27d4eb2f165667c5ull;
+
+constexpr size_t kHashStripe = 64;
+constexpr size_t kHashStripesPerBlock = 16;
+
+// Byte offsets into the secret.
+constexpr size_t kHashScrambleOffset = 128;
+constexpr size_t kHashLastStripeOffset = 121;
+constexpr size_t kHashMergeOffset = 11;
+
+// The accumulators are split into HashBlocks, so that the algorithm does not
+// depend on the native SIMD width.
+using HashBlock = NativeSimd<uint64>;
+using HashHalfBlock = NativeSimd<uint32, HashBlock::size()>;
+constexpr int kHashBlocks = 8 / HashBlock::size();
+static_assert(8 % HashBlock::size() == 0 && HashBlock::size() <= 4,
+              "Unexpected HashBlock size");
+
+struct HashTables {
+  // 192 bytes from splitmix64, seeded with "dimsum.h".
+  uint64 secret[24];
+};
+
+inline const HashTables& GetHashTables() {
+  static const HashTables tables = {{
+      0x3b8be1818db8a7a1ull, 0x8e289408f72cb803ull, 0x2088edba35db3ee1ull,
+      0x047d2f1fc8573fa4ull, 0x3ac1df92f02155d4ull, 0x65115aa6c6b12b4eull,
+      0xa25916fd1f0de8bdull, 0x96a5da28cc6c2db5ull, 0x07447802eba5cd2cull,
+      0x98fa3e83c6e1362eull, 0xfa44a837c9d88a35ull, 0xab50beac9dad8fcbull,
+      0xc1a923b696b3dc97ull, 0xfb5571e3996b0864ull, 0xf82a94bfffca8013ull,
+      0x08e75303ada3d73dull, 0xb413532b69353bf9ull, 0x6b2ff0d7d03ac767ull,
+      0x189ebaa5bbe43c15ull, 0x7dac0da702ee39c0ull, 0x8e53a4753be21553ull,
+      0xebc9560b3e285619ull, 0xd6c4305099662472ull, 0x7c3b51c28e9fff11ull,
+  }};
+  return tables;
+}
+
+inline const char* HashSecret() {
+  return reinterpret_cast<const char*>(GetHashTables().secret);
+}
+
+inline uint64 HashLoad64(const char* p) {
+  uint64 word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+inline uint32 HashLoad32(const char* p) {
+  uint32 word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+inline uint64 HashRotl(uint64 x, int bits) {
+  return x << bits | x >> (64 - bits);
+}
+
+// The splitmix64 finalizer. It is a bijection, and is written for both scalars
+// and Simd objects.
+template <typename T>
+inline T HashAvalanche(T x) {
+  x ^= x >> 30;
+  x *= T(0xbf58476d1ce4e5b9ull);
+  x ^= x >> 27;
+  x *= T(0x94d049bb133111ebull);
+  x ^= x >> 31;
+  return x;
+}
+
+// Hashes inputs of at most 8 bytes, packed into x by HashSmall. Also used by
+// hash_keys on Simd objects.
+template <typename T>
+inline T HashUpTo8(T x, size_t size) {
+  const uint64 secret = HashLoad64(HashSecret());
+  return HashAvalanche((x ^ T(secret)) + T(size * kHashPrime64_1));
+}
+
+inline uint64 HashSmall(const char* data, size_t size) {
+  const char* secret = HashSecret();
+  if (size > 8) {
+    uint64 lo = HashLoad64(data) ^ HashLoad64(secret + 8);
+    uint64 hi = HashLoad64(data + size - 8) ^ HashLoad64(secret + 16);
+    return HashAvalanche((HashAvalanche(lo) ^ hi) + size * kHashPrime64_1);
+  }
+  uint64 x = 0;
+  if (size >= 4) {
+    x = HashLoad32(data) | uint64{HashLoad32(data + size - 4)} << 32;
+  } else if (size > 0) {
+    x = uint64{static_cast<uint8>(data[0])} |
+        uint64{static_cast<uint8>(data[size / 2])} << 8 |
+        uint64{static_cast<uint8>(data[size - 1])} << 16;
+  }
+  return HashUpTo8(x, size);
+}
+
+struct HashAccumulators {
+  HashBlock blocks[kHashBlocks];
+};
+
+// Adds num_stripes stripes from data, stripe s XORed with the 64 bytes of
+// secret at key + 8 * s.
+//
+// The accumulators are updated one HashBlock at a time, over all the stripes,
+// so that the block being updated stays in a register; GCC keeps an array
+// indexed in an inner loop in memory. The stripes are read again from L1 for
+// each HashBlock.
+inline void HashAccumulate(HashAccumulators* acc, const char* data,
+                           size_t num_stripes, const char* key) {
+  for (int i = 0; i < kHashBlocks; i++) {
+    const size_t lane = i * HashBlock::size();
+    HashBlock block = acc->blocks[i];
+    for (size_t s = 0; s < num_stripes; s++) {
+      const char* stripe = data + s * kHashStripe;
+      const char* stripe_key = key + 8 * s;
+      HashHalfBlock lo = LoadUnaligned<HashHalfBlock>(stripe + 4 * lane) ^
+                         LoadUnaligned<HashHalfBlock>(stripe_key + 4 * lane);
+      HashHalfBlock hi =
+          LoadUnaligned<HashHalfBlock>(stripe + 32 + 4 * lane) ^
+          LoadUnaligned<HashHalfBlock>(stripe_key + 32 + 4 * lane);
+      block += mul_widened(lo, hi) +
+               LoadUnaligned<HashBlock>(stripe + 8 * ((lane + 4) % 8));
+    }
+    acc->blocks[i] = block;
+  }
+}
+
+inline void HashScramble(HashAccumulators* acc) {
+  const char* key = HashSecret() + kHashScrambleOffset;
+  for (int i = 0; i < kHashBlocks; i++) {
+    HashBlock x = acc->blocks[i];
+    x ^= x >> 47;
+    x ^= LoadUnaligned<HashBlock>(key + i * sizeof(HashBlock));
+    acc->blocks[i] = x * HashBlock(kHashPrime32_1);
+  }
+}
+
+inline uint64 HashMerge(const HashAccumulators& acc, size_t size) {
+  const char* key = HashSecret() + kHashMergeOffset;
+  uint64 lanes[8];
+  for (int i = 0; i < kHashBlocks; i++) {
+    HashBlock x =
+        acc.blocks[i] ^ LoadUnaligned<HashBlock>(key + i * sizeof(HashBlock));
+    x = (x ^ x >> 29) * HashBlock(kHashPrime64_2);
+    StoreUnaligned(x, lanes + i * HashBlock::size());
+  }
+  uint64 h = size * kHashPrime64_1;
+  for (uint64 lane : lanes) {
+    h = HashRotl(h ^ lane, 27) * kHashPrime64_1 + kHashPrime64_4;
+  }
+  return HashAvalanche(h);
+}
+
+// Hashes inputs longer than 16 bytes.
+inline uint64 HashLarge(const char* data, size_t size) {
+  static const uint64 kInit[8] = {
+      kHashPrime32_3, kHashPrime64_1, kHashPrime64_2, kHashPrime64_3,
+      kHashPrime64_4, kHashPrime32_2, kHashPrime64_5, kHashPrime32_1};
+  HashAccumulators acc;
+  for (int i = 0; i < kHashBlocks; i++) {
+    acc.blocks[i] = LoadUnaligned<HashBlock>(kInit + i * HashBlock::size());
+  }
+  const char* secret = HashSecret();
+  if (size < kHashStripe) {
+    // The last stripe is zero-padded at the front.
+    char stripe[kHashStripe] = {};
+    memcpy(stripe + kHashStripe - size, data, size);
+    HashAccumulate(&acc, stripe, 1, secret + kHashLastStripeOffset);
+    return HashMerge(acc, size);
+  }
+  // Full stripes, excluding the last one, which may be partial.
+  const size_t num_stripes = (size - 1) / kHashStripe;
+  const size_t kBlockSize = kHashStripesPerBlock * kHashStripe;
+  const char* p = data;
+  for (size_t block = 0; block < num_stripes / kHashStripesPerBlock;
+       block++, p += kBlockSize) {
+    HashAccumulate(&acc, p, kHashStripesPerBlock, secret);
+    HashScramble(&acc);
+  }
+  HashAccumulate(&acc, p, num_stripes % kHashStripesPerBlock, secret);
+  // The last stripe overlaps the previous one, unless size is a multiple of
+  // kHashStripe.
+  HashAccumulate(&acc, data + size - kHashStripe, 1,
+                 secret + kHashLastStripeOffset);
+  return HashMerge(acc, size);
+}
+
+}  // namespace detail
+
+// Returns the 64-bit hash of size bytes at data.
+inline uint64 hash64(const char* data, size_t size) {
+  return size <= 16 ? detail::HashSmall(data, size)
+                    : detail::HashLarge(data, size);
+}
+
+// Stores the hashes of n keys to out. out[i] equals hash64 of the 8 bytes of
+// keys[i], so that the two can be mixed. Since the hash of 8 bytes is a
+// bijection, distinct keys never collide in the 64-bit result.
+inline void hash_keys(const uint64* keys, uint64* out, size_t n) {
+  using Block = NativeSimd<uint64>;
+  size_t i = 0;
+  // A 64-bit multiplication takes three pmuludq, so with only two lanes
+  // (SSE, NEON) the scalar multiplications are faster.
+  if (Block::size() > 2) {
+    for (; i + Block::size() <= n; i += Block::size()) {
+      Block x = detail::LoadUnaligned<Block>(keys + i);
+      detail::StoreUnaligned(detail::HashUpTo8(x, 8), out + i);
+    }
+  }
+  for (; i < n; i++) out[i] = detail::HashUpTo8(keys[i], 8);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_HASH_H_
@@ -0,0 +1,87 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hash.h"
+
+namespace dimsum {
+namespace {
+
+std::string RandomBytes(size_t size) {
+  std::mt19937 rng(0);
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = rng();
+  return bytes;
+}
+
+void BM_StdHash(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  std::hash<std::string> hasher;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hasher(data));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_StdHash)->Range(8, 1 << 20);
+
+void BM_Hash64(benchmark::State& state) {
+  std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hash64(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Hash64)->Range(8, 1 << 20);
+
+constexpr size_t kNumKeys = 4096;
+
+std::vector<uint64> RandomKeys() {
+  std::mt19937_64 rng(0);
+  std::vector<uint64> keys(kNumKeys);
+  for (uint64& key : keys) key = rng();
+  return keys;
+}
+
+// One key at a time, through hash64.
+void BM_Hash64Keys(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys();
+  std::vector<uint64> hashes(kNumKeys);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumKeys; i++) {
+      hashes[i] = hash64(reinterpret_cast<const char*>(&keys[i]), 8);
+    }
+    benchmark::DoNotOptimize(hashes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+BENCHMARK(BM_Hash64Keys);
+
+void BM_HashKeys(benchmark::State& state) {
+  std::vector<uint64> keys = RandomKeys();
+  std::vector<uint64> hashes(kNumKeys);
+  for (auto _ : state) {
+    hash_keys(keys.data(), hashes.data(), kNumKeys);
+    benchmark::DoNotOptimize(hashes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+BENCHMARK(BM_HashKeys);
+
+}  // namespace
+}  // namespace dimsum
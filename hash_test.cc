@@ -0,0 +1,154 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hash.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+using detail::HashLoad32;
+using detail::HashLoad64;
+
+uint64 Hash64(const std::string& data) {
+  return hash64(data.data(), data.size());
+}
+
+std::string RandomBytes(size_t size, std::mt19937* rng) {
+  std::string bytes(size, '\0');
+  for (char& c : bytes) c = (*rng)();
+  return bytes;
+}
+
+// The stripe loop of hash64 for inputs longer than 16 bytes, one uint64 lane
+// at a time.
+uint64 ReferenceHashLarge(std::string data) {
+  const char* secret = detail::HashSecret();
+  const size_t size = data.size();
+  uint64 acc[8] = {detail::kHashPrime32_3, detail::kHashPrime64_1,
+                   detail::kHashPrime64_2, detail::kHashPrime64_3,
+                   detail::kHashPrime64_4, detail::kHashPrime32_2,
+                   detail::kHashPrime64_5, detail::kHashPrime32_1};
+  auto accumulate = [&acc](const char* stripe, const char* key) {
+    for (int j = 0; j < 8; j++) {
+      uint64 lo = HashLoad32(stripe + 4 * j) ^ HashLoad32(key + 4 * j);
+      uint64 hi =
+          HashLoad32(stripe + 32 + 4 * j) ^ HashLoad32(key + 32 + 4 * j);
+      acc[j] += lo * hi + HashLoad64(stripe + 8 * (j ^ 4));
+    }
+  };
+  if (size < 64) data = std::string(64 - size, '\0') + data;
+  const size_t num_stripes = (data.size() - 1) / 64;
+  for (size_t s = 0; s < num_stripes; s++) {
+    accumulate(data.data() + 64 * s, secret + 8 * (s % 16));
+    if (s % 16 == 15) {
+      for (int j = 0; j < 8; j++) {
+        acc[j] ^= acc[j] >> 47;
+        acc[j] ^= HashLoad64(secret + 128 + 8 * j);
+        acc[j] *= detail::kHashPrime32_1;
+      }
+    }
+  }
+  accumulate(data.data() + data.size() - 64, secret + 121);
+  uint64 h = size * detail::kHashPrime64_1;
+  for (int j = 0; j < 8; j++) {
+    uint64 x = acc[j] ^ HashLoad64(secret + 11 + 8 * j);
+    x = (x ^ x >> 29) * detail::kHashPrime64_2;
+    h = detail::HashRotl(h ^ x, 27) * detail::kHashPrime64_1 +
+        detail::kHashPrime64_4;
+  }
+  return detail::HashAvalanche(h);
+}
+
+TEST(HashTest, KnownAnswers) {
+  // These values may be persisted, and must not change.
+  std::string ascending;
+  for (int i = 0; i < 1000; i++) ascending += static_cast<char>(i);
+  EXPECT_EQ(0xccfc30bf92955d1dull, Hash64(""));
+  EXPECT_EQ(0x03347451e55c67c4ull, Hash64("a"));
+  EXPECT_EQ(0xe284f7124b4222aaull, Hash64("dimsum"));
+  EXPECT_EQ(0xe0dced1f2de26671ull, Hash64("12345678"));
+  EXPECT_EQ(0xcb35e6a70721caacull, Hash64("0123456789abcdef"));
+  EXPECT_EQ(0x0483dafc6e0f61fbull, Hash64(ascending.substr(0, 17)));
+  EXPECT_EQ(0x14d520fb9d2cb5d7ull, Hash64(ascending.substr(0, 64)));
+  EXPECT_EQ(0xbe71e0830aadb387ull, Hash64(ascending.substr(0, 65)));
+  EXPECT_EQ(0x40613f3d0f4fbf50ull, Hash64(ascending));
+}
+
+TEST(HashTest, MatchesReference) {
+  std::mt19937 rng(0);
+  // Sizes around the stripe and block boundaries.
+  for (size_t size = 17; size < 2200; size += 1 + size / 32) {
+    std::string data = RandomBytes(size, &rng);
+    EXPECT_EQ(ReferenceHashLarge(data), Hash64(data)) << size;
+  }
+}
+
+TEST(HashTest, HashKeys) {
+  std::mt19937_64 rng(0);
+  std::vector<uint64> keys(1001);
+  for (uint64& key : keys) key = rng();
+  keys[0] = 0;
+  std::vector<uint64> hashes(keys.size());
+  hash_keys(keys.data(), hashes.data(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    char bytes[8];
+    memcpy(bytes, &keys[i], sizeof(bytes));
+    EXPECT_EQ(hash64(bytes, sizeof(bytes)), hashes[i]) << i;
+  }
+}
+
+TEST(HashTest, NoCollisions) {
+  std::unordered_set<uint64> hashes;
+  std::vector<uint64> keys(100000);
+  for (size_t i = 0; i < keys.size(); i++) keys[i] = i;
+  std::vector<uint64> key_hashes(keys.size());
+  hash_keys(keys.data(), key_hashes.data(), keys.size());
+  hashes.insert(key_hashes.begin(), key_hashes.end());
+  // Short strings, including prefixes of each other.
+  for (int i = 0; i < 100000; i++) {
+    hashes.insert(Hash64(std::to_string(i)));
+    hashes.insert(Hash64("key_" + std::to_string(i) + "_suffix"));
+    hashes.insert(Hash64(std::string(1 + i % 300, 'x') + std::to_string(i)));
+  }
+  EXPECT_EQ(400000u, hashes.size());
+}
+
+TEST(HashTest, Avalanche) {
+  // Flipping any input bit flips about half of the output bits.
+  std::mt19937 rng(0);
+  for (size_t size : {1, 3, 8, 12, 16, 17, 40, 64, 100, 1100}) {
+    std::string data = RandomBytes(size, &rng);
+    const uint64 hash = Hash64(data);
+    int flipped = 0;
+    for (size_t bit = 0; bit < 8 * size; bit++) {
+      std::string changed = data;
+      changed[bit / 8] ^= 1 << bit % 8;
+      flipped += __builtin_popcountll(hash ^ Hash64(changed));
+    }
+    double average = static_cast<double>(flipped) / (8 * size);
+    EXPECT_GT(average, 28) << size;
+    EXPECT_LT(average, 36) << size;
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
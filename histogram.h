@@ -0,0 +1,157 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_HISTOGRAM_H_
+#define DIMSUM_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "dimsum.h"
+
+// Histograms of uint8 values (256 bins) and uint16 values (65536 bins).
+//
+// Counting is a scatter of increments, whose speed is bounded by the
+// dependency between two increments of the same bin: the second load waits
+// for the first store. On skewed inputs, where most values hit a few bins,
+// this serializes the count. The increments are therefore spread over
+// replicated sub-histograms, so that neighboring values go to different
+// copies, and the copies are summed with Simd adds at the end. Values are
+// read 8 bytes at a time, and each is extracted with a shift.
+//
+// uint8 inputs use 8 copies, one per byte of a uint64, which all fit in L1.
+// uint16 bins take 256KB, so a copy costs cache misses that uniform inputs,
+// which rarely repeat a bin, don't win back. uint16 inputs use 2 copies only
+// when a sample of their first values repeats bins often, and are large
+// enough to amortize clearing and summing the second one.
+//
+// Counts are added to bins, so that histograms of the parts of an input can
+// be computed separately, e.g. on different threads, and summed with
+// histogram_merge.
+
+namespace dimsum {
+
+constexpr size_t kHistogramBins8 = 256;
+constexpr size_t kHistogramBins16 = 65536;
+
+// Adds from[0, num_bins) to to[0, num_bins).
+inline void histogram_merge(const uint32* from, size_t num_bins, uint32* to) {
+  using Block = NativeSimd<uint32>;
+  const size_t tail = num_bins % Block::size();
+  for (size_t i = 0; i < num_bins - tail; i += Block::size()) {
+    detail::StoreUnaligned(detail::LoadUnaligned<Block>(to + i) +
+                               detail::LoadUnaligned<Block>(from + i),
+                           to + i);
+  }
+  for (size_t i = num_bins - tail; i < num_bins; i++) to[i] += from[i];
+}
+
+namespace detail {
+
+constexpr int kHistogramCopies8 = 8;
+
+// Inputs shorter than this are counted directly into the bins, as summing
+// the copies would take longer than counting.
+constexpr size_t kHistogramMinCopySize8 = 1024;
+constexpr size_t kHistogramMinCopySize16 = 1 << 18;
+
+// uint16 inputs are counted into 2 copies when more than 1/8 of the first
+// kHistogramSkewSample16 values repeat one of the 3 values before them, i.e.
+// would wait on an increment still in flight.
+constexpr size_t kHistogramSkewSample16 = 1024;
+
+inline uint64 HistogramLoad(const void* p) {
+  uint64 word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+// Counts the bytes of word, byte k into counts[k].
+inline void HistogramCountBytes(uint64 word,
+                                uint32 (*counts)[kHistogramBins8]) {
+  counts[0][word & 0xff]++;
+  counts[1][word >> 8 & 0xff]++;
+  counts[2][word >> 16 & 0xff]++;
+  counts[3][word >> 24 & 0xff]++;
+  counts[4][word >> 32 & 0xff]++;
+  counts[5][word >> 40 & 0xff]++;
+  counts[6][word >> 48 & 0xff]++;
+  counts[7][word >> 56]++;
+}
+
+// Counts the uint16 values of word, alternately into even and odd.
+inline void HistogramCountHalves(uint64 word, uint32* even, uint32* odd) {
+  even[word & 0xffff]++;
+  odd[word >> 16 & 0xffff]++;
+  even[word >> 32 & 0xffff]++;
+  odd[word >> 48]++;
+}
+
+// Returns whether data[0, kHistogramSkewSample16) often repeats recent values.
+inline bool HistogramIsSkewed(const uint16* data) {
+  size_t repeats = 0;
+  for (size_t i = 3; i < kHistogramSkewSample16; i++) {
+    repeats += data[i] == data[i - 1] || data[i] == data[i - 2] ||
+               data[i] == data[i - 3];
+  }
+  return repeats > kHistogramSkewSample16 / 8;
+}
+
+}  // namespace detail
+
+// Adds the number of occurrences of each value of data[0, n) to bins, which
+// holds kHistogramBins8 counts.
+inline void histogram(const uint8* data, size_t n, uint32* bins) {
+  if (n < detail::kHistogramMinCopySize8) {
+    for (size_t i = 0; i < n; i++) bins[data[i]]++;
+    return;
+  }
+  uint32 counts[detail::kHistogramCopies8][kHistogramBins8] = {};
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    detail::HistogramCountBytes(detail::HistogramLoad(data + i), counts);
+    detail::HistogramCountBytes(detail::HistogramLoad(data + i + 8), counts);
+  }
+  for (; i < n; i++) counts[0][data[i]]++;
+  for (const auto& copy : counts) {
+    histogram_merge(copy, kHistogramBins8, bins);
+  }
+}
+
+// Adds the number of occurrences of each value of data[0, n) to bins, which
+// holds kHistogramBins16 counts.
+inline void histogram(const uint16* data, size_t n, uint32* bins) {
+  std::vector<uint32> copy;
+  uint32* odd = bins;
+  if (n >= detail::kHistogramMinCopySize16 &&
+      detail::HistogramIsSkewed(data)) {
+    copy.resize(kHistogramBins16);
+    odd = copy.data();
+  }
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    detail::HistogramCountHalves(detail::HistogramLoad(data + i), bins, odd);
+    detail::HistogramCountHalves(detail::HistogramLoad(data + i + 4), bins,
+                                 odd);
+  }
+  for (; i < n; i++) bins[data[i]]++;
+  if (!copy.empty()) histogram_merge(copy.data(), kHistogramBins16, bins);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_HISTOGRAM_H_
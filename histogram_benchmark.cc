@@ -0,0 +1,92 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "histogram.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kNumValues = 1 << 20;
+
+enum Distribution {
+  kUniform,
+  // 7/8 of the values are the same.
+  kSkewed,
+  kConstant,
+};
+
+template <typename T>
+std::vector<T> RandomValues(int distribution) {
+  std::mt19937 gen(0);
+  std::vector<T> values(kNumValues);
+  for (T& value : values) {
+    switch (distribution) {
+      case kUniform:
+        value = gen();
+        break;
+      case kSkewed:
+        value = gen() % 8 != 0 ? 7 : gen();
+        break;
+      case kConstant:
+        value = 42;
+        break;
+    }
+  }
+  return values;
+}
+
+template <typename T>
+void BM_ScalarHistogram(benchmark::State& state) {
+  std::vector<T> values = RandomValues<T>(state.range(0));
+  std::vector<uint32> bins(size_t{1} << 8 * sizeof(T));
+  for (auto _ : state) {
+    for (T value : values) bins[value]++;
+    benchmark::DoNotOptimize(bins.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_ScalarHistogram, uint8)
+    ->Arg(kUniform)
+    ->Arg(kSkewed)
+    ->Arg(kConstant);
+BENCHMARK_TEMPLATE(BM_ScalarHistogram, uint16)
+    ->Arg(kUniform)
+    ->Arg(kSkewed)
+    ->Arg(kConstant);
+
+template <typename T>
+void BM_Histogram(benchmark::State& state) {
+  std::vector<T> values = RandomValues<T>(state.range(0));
+  std::vector<uint32> bins(size_t{1} << 8 * sizeof(T));
+  for (auto _ : state) {
+    histogram(values.data(), values.size(), bins.data());
+    benchmark::DoNotOptimize(bins.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK_TEMPLATE(BM_Histogram, uint8)
+    ->Arg(kUniform)
+    ->Arg(kSkewed)
+    ->Arg(kConstant);
+BENCHMARK_TEMPLATE(BM_Histogram, uint16)
+    ->Arg(kUniform)
+    ->Arg(kSkewed)
+    ->Arg(kConstant);
+
+}  // namespace
+}  // namespace dimsum
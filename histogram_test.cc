@@ -0,0 +1,92 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "histogram.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+template <typename T>
+std::vector<T> RandomValues(size_t n, bool skewed, std::mt19937* gen) {
+  std::vector<T> values(n);
+  for (T& value : values) {
+    value = skewed && (*gen)() % 8 != 0 ? 7 : static_cast<T>((*gen)());
+  }
+  return values;
+}
+
+template <typename T>
+std::vector<uint32> ScalarHistogram(const std::vector<T>& values,
+                                    size_t num_bins) {
+  std::vector<uint32> bins(num_bins);
+  for (T value : values) bins[value]++;
+  return bins;
+}
+
+TEST(HistogramTest, Bytes) {
+  std::mt19937 gen(0);
+  for (size_t n : {0, 1, 15, 16, 17, 1000, 1023, 1024, 1025, 100000}) {
+    for (bool skewed : {false, true}) {
+      SCOPED_TRACE(testing::Message() << n << " " << skewed);
+      std::vector<uint8> values = RandomValues<uint8>(n, skewed, &gen);
+      std::vector<uint32> bins(kHistogramBins8);
+      histogram(values.data(), values.size(), bins.data());
+      EXPECT_EQ(ScalarHistogram(values, kHistogramBins8), bins);
+    }
+  }
+}
+
+TEST(HistogramTest, Halves) {
+  std::mt19937 gen(0);
+  for (size_t n : {0, 1, 7, 8, 9, 1000, (1 << 18) - 1, 1 << 18, 300001}) {
+    for (bool skewed : {false, true}) {
+      SCOPED_TRACE(testing::Message() << n << " " << skewed);
+      std::vector<uint16> values = RandomValues<uint16>(n, skewed, &gen);
+      std::vector<uint32> bins(kHistogramBins16);
+      histogram(values.data(), values.size(), bins.data());
+      EXPECT_EQ(ScalarHistogram(values, kHistogramBins16), bins);
+    }
+  }
+}
+
+// Histograms of parts add up to the histogram of the whole.
+TEST(HistogramTest, Merge) {
+  std::mt19937 gen(0);
+  std::vector<uint8> values = RandomValues<uint8>(5000, true, &gen);
+  std::vector<uint32> first(kHistogramBins8), second(kHistogramBins8);
+  histogram(values.data(), 3000, first.data());
+  histogram(values.data() + 3000, 2000, second.data());
+  histogram_merge(second.data(), kHistogramBins8, first.data());
+  EXPECT_EQ(ScalarHistogram(values, kHistogramBins8), first);
+
+  // Counting into non-zero bins adds to them.
+  histogram(values.data(), values.size(), first.data());
+  std::vector<uint32> expected = ScalarHistogram(values, kHistogramBins8);
+  for (uint32& count : expected) count *= 2;
+  EXPECT_EQ(expected, first);
+
+  // A number of bins that is not a multiple of the Simd size.
+  std::vector<uint32> from = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  std::vector<uint32> to(from.size(), 100);
+  histogram_merge(from.data(), from.size(), to.data());
+  for (size_t i = 0; i < to.size(); i++) EXPECT_EQ(101 + i, to[i]);
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -25,6 +25,7 @@
 #include <functional>
 #include <limits>
 
+#include "fallback.h"
 #include "port.h"
 #include "types.h"
 
@@ -37,14 +38,40 @@
 namespace dimsum {
 namespace detail {
 
+template <typename DestType, typename SrcType>
+DestType saturated_convert(SrcType val, std::true_type /* floating point */) {
+  using Limits = std::numeric_limits<DestType>;
+  // The limits are powers of two, 0, or powers of two minus 1, which round to
+  // the next power of two at worst. Either way, values between them truncate
+  // to a value in range.
+  if (val != val) return 0;
+  if (val <= static_cast<SrcType>(Limits::min())) return Limits::min();
+  if (val >= static_cast<SrcType>(Limits::max())) return Limits::max();
+  return static_cast<DestType>(val);
+}
+
+template <typename DestType, typename SrcType>
+DestType saturated_convert(SrcType val, std::false_type /* integral */) {
+  using Limits = std::numeric_limits<DestType>;
+  // Compares in int64 below and uint64 above 0, which hold the values of both
+  // types.
+  if (std::is_signed<SrcType>::value && static_cast<int64>(val) < 0) {
+    return static_cast<int64>(val) < static_cast<int64>(Limits::min())
+               ? Limits::min()
+               : static_cast<DestType>(val);
+  }
+  return static_cast<uint64>(val) > static_cast<uint64>(Limits::max())
+             ? Limits::max()
+             : static_cast<DestType>(val);
+}
+
 // Returns a DestType with the value clamped into its representable range.
+// DestType is integral, and NaN converts to 0.
 template <typename DestType, typename SrcType>
 DestType saturated_convert(SrcType val) {
-  return val > std::numeric_limits<DestType>::max()
-             ? std::numeric_limits<DestType>::max()
-             : (val < std::numeric_limits<DestType>::min()
-                    ? std::numeric_limits<DestType>::min()
-                    : static_cast<DestType>(val));
+  static_assert(std::is_integral<DestType>::value, "");
+  return saturated_convert<DestType>(val,
+                                     std::is_floating_point<SrcType>());
 }
 
 template <typename To, typename From>
@@ -160,6 +187,11 @@ using std::experimental::to_fixed_size;
 //
 // ----------------- Primitive Operations -----------------
 // Returns r, where r[i] = simd[indices[i]].
+//
+// The indices are compile-time constants, but the mirrored simd header moves
+// the elements one at a time, and GCC compiles that to a loop through memory
+// rather than one shuffle instruction. Hot loops that need a fixed
+// permutation use the backend's instruction for it, and shuffle() otherwise.
 template <size_t... indices, typename T, typename SrcAbi>
 ResizeTo<Simd<T, SrcAbi>, sizeof...(indices)> shuffle(Simd<T, SrcAbi> simd) {
   return std::experimental::__simd_shuffle<indices...>(simd, simd);
@@ -172,6 +204,27 @@ ResizeTo<Simd<T, SrcAbi>, sizeof...(indices)> shuffle(Simd<T, SrcAbi> lhs,
   return shuffle<indices...>(concat(lhs, rhs));
 }
 
+// Returns r, where r[i] is looked up from table by the run-time index
+// indices[i]. The lookup is done independently in each 16-byte segment: lanes
+// [16k, 16k + 16) only read table[16k ... 16k + 15]. If the most significant
+// bit of indices[i] is set, r[i] is 0. Other indices greater than 15 produce
+// unspecified results.
+//
+// This maps to pshufb on x86.
+template <typename Abi>
+Simd<uint8, Abi> lookup(Simd<uint8, Abi> table, Simd<uint8, Abi> indices) {
+  detail::NoteFallback<detail::fallback::lookup, uint8, Abi>();
+  constexpr size_t kSize = Simd<uint8, Abi>::size();
+  constexpr size_t kSegment = kSize < 16 ? kSize : 16;
+  Simd<uint8, Abi> ret;
+  for (size_t i = 0; i < ret.size(); i++) {
+    ret[i] = indices[i] & 0x80
+                 ? 0
+                 : table[i / kSegment * kSegment + indices[i] % kSegment];
+  }
+  return ret;
+}
+
 namespace detail {
 
 template <size_t... indices, typename T, typename Abi>
@@ -186,6 +239,7 @@ ResizeBy<Simd<T, Abi>, 2> zip_impl(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
 // Returns the element-wise saturated sum of two Simd objects.
 template <typename T, typename Abi>
 Simd<T, Abi> add_saturated(const Simd<T, Abi> lhs, const Simd<T, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::add_saturated, T, Abi>();
   T a[lhs.size()];
   for (size_t i = 0; i < lhs.size(); i++) {
     a[i] = detail::SaturatedAdd(lhs[i], rhs[i]);
@@ -196,6 +250,7 @@ Simd<T, Abi> add_saturated(const Simd<T, Abi> lhs, const Simd<T, Abi> rhs) {
 // Returns the element-wise saturated difference of two Simd objects.
 template <typename T, typename Abi>
 Simd<T, Abi> sub_saturated(const Simd<T, Abi> lhs, const Simd<T, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::sub_saturated, T, Abi>();
   T a[lhs.size()];
   for (size_t i = 0; i < lhs.size(); i++) {
     a[i] = detail::SaturatedSub(lhs[i], rhs[i]);
@@ -249,37 +304,109 @@ ScaleElemBy<Simd<T, Abi>, 2> mul_widened(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   return simd_cast<ScaleBy<T, 2>>(lhs) * simd_cast<ScaleBy<T, 2>>(rhs);
 }
 
+namespace detail {
+
+// The storage of Simd<T, Abi>, with one lane per element: a vector extension
+// type for native ABIs, and an array otherwise. Unlike
+// Simd<T, Abi>::__native_type (e.g. __m128i), operators on it are element-wise.
+template <typename T, typename Abi>
+using Vector = typename std::experimental::__simd_storage<T, Abi>::__raw_type;
+
+template <typename T, typename Abi>
+Vector<T, Abi> ToVector(Simd<T, Abi> simd) {
+  return Vector<T, Abi>(simd.__raw());
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> FromVector(Vector<T, Abi> vector) {
+  return typename Simd<T, Abi>::__native_type(vector);
+}
+
+// Whether generic implementations on Simd<T, Abi> apply the 16-byte version of
+// the operation to 16-byte pieces. All targets specialize the 16-byte
+// versions, so 8-byte native Simd objects and wider ones without
+// specializations (e.g. Simd256 without AVX) get vector code too.
+template <typename T, typename Abi>
+constexpr bool UsePieces() {
+  using SimdType = Simd<T, Abi>;
+  return std::is_same<SimdType, NativeSimd<T, SimdType::size()>>::value &&
+         (sizeof(SimdType) == 8 ||
+          (sizeof(SimdType) > 16 && sizeof(SimdType) % 16 == 0));
+}
+
+template <typename T>
+using Piece = NativeSimd<T, 16 / sizeof(T)>;
+
+// Returns lane_op applied to each element of simd.
+template <typename T, typename Abi, typename LaneOp>
+Simd<T, Abi> MapLanes(Simd<T, Abi> simd, LaneOp lane_op) {
+  Vector<T, Abi> vector = ToVector(simd);
+  DIMSUM_UNROLL for (size_t i = 0; i < simd.size(); i++) {
+    vector[i] = lane_op(vector[i]);
+  }
+  return FromVector<T, Abi>(vector);
+}
+
+template <typename T, typename Abi, typename PieceOp, typename LaneOp>
+Simd<T, Abi> MapGeneric(Simd<T, Abi> simd, PieceOp, LaneOp lane_op,
+                        std::false_type) {
+  return MapLanes(simd, lane_op);
+}
+
+// Pads 8-byte Simd objects with zeros, and splits wider ones.
+template <typename T, typename Abi, typename PieceOp, typename LaneOp>
+Simd<T, Abi> MapGeneric(Simd<T, Abi> simd, PieceOp piece_op, LaneOp,
+                        std::true_type) {
+  constexpr size_t kBytes = sizeof(Simd<T, Abi>);
+  constexpr size_t kPieceBytes = sizeof(Piece<T>);
+  using PieceRaw = typename Piece<T>::__native_type;
+  typename Simd<T, Abi>::__native_type raw = simd.__raw();
+  DIMSUM_UNROLL for (size_t i = 0; i < kBytes; i += kPieceBytes) {
+    const size_t num_bytes =
+        kBytes - i < kPieceBytes ? kBytes - i : kPieceBytes;
+    PieceRaw piece = {};
+    memcpy(&piece, reinterpret_cast<char*>(&raw) + i, num_bytes);
+    piece = piece_op(Piece<T>(piece)).__raw();
+    memcpy(reinterpret_cast<char*>(&raw) + i, &piece, num_bytes);
+  }
+  return raw;
+}
+
+// Returns piece_op or lane_op applied to simd, whichever gives vector code;
+// see UsePieces.
+template <typename T, typename Abi, typename PieceOp, typename LaneOp>
+Simd<T, Abi> MapGeneric(Simd<T, Abi> simd, PieceOp piece_op, LaneOp lane_op) {
+  return MapGeneric(simd, piece_op, lane_op,
+                    std::integral_constant<bool, UsePieces<T, Abi>()>());
+}
+
+}  // namespace detail
+
 // Returns the element-wise estimate of reciprocal.
 // On x86, the relative error is less or equal than 1.5/4096.
 // On POWER, the relative error is less or equal than 1/16384.
 // On ARM, the relative error may be slightly greater than 1/512.
 template <typename T, typename Abi>
 Simd<T, Abi> reciprocal_estimate(Simd<T, Abi> v) {
-  Simd<T, Abi> ret;
-  for (int i = 0; i < v.size(); i++) {
-    ret[i] = T(1) / v[i];
-  }
-  return ret;
+  detail::NoteFallback<detail::fallback::reciprocal_estimate, T, Abi>();
+  return Simd<T, Abi>(T(1)) / v;
 }
 
 // Returns the element-wise square root.
 template <typename T, typename Abi>
 Simd<T, Abi> sqrt(Simd<T, Abi> v) {
-  Simd<T, Abi> ret;
-  for (int i = 0; i < v.size(); i++) {
-    ret[i] = std::sqrt(v[i]);
-  }
-  return ret;
+  detail::NoteFallback<detail::fallback::sqrt, T, Abi>();
+  // With errno, compilers don't vectorize std::sqrt.
+  return detail::MapGeneric(
+      v, [](detail::Piece<T> piece) { return sqrt(piece); },
+      [](T lane) { return T(std::sqrt(lane)); });
 }
 
 // Returns the element-wise estimate of reciprocal square root.
 template <typename T, typename Abi>
 Simd<T, Abi> reciprocal_sqrt_estimate(Simd<T, Abi> v) {
-  Simd<T, Abi> ret;
-  for (int i = 0; i < v.size(); i++) {
-    ret[i] = T(1) / std::sqrt(v[i]);
-  }
-  return ret;
+  detail::NoteFallback<detail::fallback::reciprocal_sqrt_estimate, T, Abi>();
+  return Simd<T, Abi>(T(1)) / sqrt(v);
 }
 
 // Element-wise round to integral floating points using the round-toeven rule.
@@ -288,24 +415,51 @@ Simd<T, Abi> reciprocal_sqrt_estimate(Simd<T, Abi> v) {
 // Control field RN in FPSCR, which defaults to round-to-even.
 template <typename T, typename Abi>
 Simd<T, Abi> round(Simd<T, Abi> simd) {
-  Simd<T, Abi> ret;
-  for (size_t i = 0; i < simd.size(); i++) {
-    ret[i] = std::nearbyint(simd[i]);
-  }
-  return ret;
+  detail::NoteFallback<detail::fallback::round, T, Abi>();
+  return detail::MapGeneric(
+      simd, [](detail::Piece<T> piece) { return round(piece); },
+      [](T lane) { return T(std::nearbyint(lane)); });
 }
 
+namespace detail {
+
+// Whether Abi stores elements in a vector extension type, which casts to
+// other vector types of the same size reinterpret.
+template <typename Abi>
+struct IsVectorAbi : std::false_type {};
+
+template <int N>
+struct IsVectorAbi<std::experimental::__simd_abi<
+    std::experimental::_StorageKind::_VecExt, N>> : std::true_type {};
+
+template <typename DestSimd, typename T, typename Abi>
+DestSimd BitCastImpl(Simd<T, Abi> simd, std::true_type) {
+  return typename DestSimd::__native_type(simd.__raw());
+}
+
+template <typename DestSimd, typename T, typename Abi>
+DestSimd BitCastImpl(Simd<T, Abi> simd, std::false_type) {
+  NoteFallback<fallback::bit_cast, T, Abi>();
+  typename Simd<T, Abi>::__native_type src = simd.__raw();
+  typename DestSimd::__native_type dest;
+  static_assert(sizeof(dest) == sizeof(src), "");
+  memcpy(&dest, &src, sizeof(dest));
+  return dest;
+}
+
+}  // namespace detail
+
 // Casts to another vector type of the same width without changing any bits.
+// For native Simd objects, this is a cast of the vector registers, which
+// generates no instructions.
 template <typename Dest, typename T, typename Abi>
 ReinterpretTo<Simd<T, Abi>, Dest> bit_cast(Simd<T, Abi> simd) {
-  ReinterpretTo<Simd<T, Abi>, Dest> ret;
-  T src_arr[simd.size()];
-  simd.copy_to(src_arr, flags::element_aligned_tag());
-  Dest dest_arr[ret.size()];
-  static_assert(sizeof(dest_arr) == sizeof(src_arr), "");
-  memcpy(dest_arr, src_arr, sizeof(dest_arr));
-  return ReinterpretTo<Simd<T, Abi>, Dest>(dest_arr,
-                                           flags::element_aligned_tag());
+  using DestSimd = ReinterpretTo<Simd<T, Abi>, Dest>;
+  constexpr bool kVector =
+      detail::IsVectorAbi<Abi>::value &&
+      detail::IsVectorAbi<typename DestSimd::abi_type>::value;
+  return detail::BitCastImpl<DestSimd>(
+      simd, std::integral_constant<bool, kVector>());
 }
 
 // Convert input Simd or SimdMask to the non-portable native type.
@@ -319,10 +473,313 @@ typename SimdMask<T, Abi>::__native_type to_raw(SimdMask<T, Abi> v) {
   return v.__raw();
 }
 
+namespace detail {
+
+// Loads a SimdType from p, which needs no alignment. Going through the native
+// type keeps the value in a register with compilers that otherwise bounce
+// element_aligned loads off the stack.
+template <typename SimdType>
+SimdType LoadUnaligned(const void* p) {
+  typename SimdType::__native_type raw;
+  memcpy(&raw, p, sizeof(raw));
+  return raw;
+}
+
+// Stores the first num_bytes bytes of simd to p, which needs no alignment.
+template <typename T, typename Abi>
+void StoreUnaligned(Simd<T, Abi> simd, void* p,
+                    size_t num_bytes = sizeof(Simd<T, Abi>)) {
+  typename Simd<T, Abi>::__native_type raw = to_raw(simd);
+  memcpy(p, &raw, num_bytes);
+}
+
+// Returns a Block of uint8 whose byte i is table[i % 16]. lookup() indexes
+// each 16-byte segment separately, so its tables repeat in every segment.
+template <typename Block = NativeSimd<uint8>>
+Block BroadcastNibbleTable(const uint8 (&table)[16]) {
+  uint8 bytes[Block::size()];
+  for (size_t i = 0; i < Block::size(); i++) bytes[i] = table[i % 16];
+  return Block(bytes, flags::element_aligned);
+}
+
+// Returns the high nibble of each byte, e.g. as lookup() indices. x86 has no
+// byte shifts, so this shifts uint16 elements and masks.
+template <typename Abi>
+Simd<uint8, Abi> HighNibbles(Simd<uint8, Abi> simd) {
+  return bit_cast<uint8>(bit_cast<uint16>(simd) >> 4) & Simd<uint8, Abi>(0x0f);
+}
+
+}  // namespace detail
+
+// ----------------- Element Conversions -----------------
+// simd_cast and static_simd_cast of native Simd objects call
+// detail::StaticSimdCast (see the end of this file), which the backends
+// specialize through detail::ConvertElements.
+namespace detail {
+
+// Returns static_cast<Dest> of each element, one lane at a time.
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> ConvertLanes(Simd<T, Abi> simd) {
+  const Vector<T, Abi> src = ToVector(simd);
+  Vector<Dest, Abi> dest;
+  DIMSUM_UNROLL for (size_t i = 0; i < simd.size(); i++) {
+    dest[i] = static_cast<Dest>(src[i]);
+  }
+  return FromVector<Dest, Abi>(dest);
+}
+
+// Returns static_cast<Dest> of each element. Only called for the canonical
+// pairs of StaticSimdCast, which the backends specialize.
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> ConvertElements(Simd<T, Abi> simd) {
+  NoteFallback<fallback::simd_cast, T, Abi>();
+  return ConvertLanes<Dest>(simd);
+}
+
+// Returns the first (kHalf = 0) or second (kHalf = 1) half of simd.
+template <size_t kHalf, typename T, typename Abi>
+ResizeBy<Simd<T, Abi>, 1, 2> Half(Simd<T, Abi> simd) {
+  typename Simd<T, Abi>::__native_type raw = simd.__raw();
+  typename ResizeBy<Simd<T, Abi>, 1, 2>::__native_type half;
+  memcpy(&half, reinterpret_cast<char*>(&raw) + kHalf * sizeof(half),
+         sizeof(half));
+  return half;
+}
+
+// Returns the Simd object made of the elements of low, then those of high.
+template <typename T, typename Abi>
+ResizeBy<Simd<T, Abi>, 2> Combine(Simd<T, Abi> low, Simd<T, Abi> high) {
+  typename Simd<T, Abi>::__native_type halves[2] = {low.__raw(),
+                                                    high.__raw()};
+  typename ResizeBy<Simd<T, Abi>, 2>::__native_type raw;
+  memcpy(&raw, halves, sizeof(raw));
+  return raw;
+}
+
+// Converts each half of simd with the specialization for half the size, for
+// targets without vectors as wide as simd.
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> ConvertHalves(Simd<T, Abi> simd) {
+  return Combine(ConvertElements<Dest>(Half<0>(simd)),
+                 ConvertElements<Dest>(Half<1>(simd)));
+}
+
+template <typename Dest, typename T>
+constexpr bool IsIntegerConversion() {
+  return std::is_integral<Dest>::value && std::is_integral<T>::value;
+}
+
+// Integer conversions to wider types only depend on the signedness of the
+// source, and those to narrower or equally wide types on neither signedness.
+// StaticSimdCast does them as a conversion from ConversionSource<Dest, T> to
+// ConversionDest<Dest, T> between bit_casts, so that the backends only
+// specialize sign or zero extensions and truncations of unsigned integers.
+template <typename Dest, typename T>
+using ConversionSource = typename std::conditional<
+    IsIntegerConversion<Dest, T>() && sizeof(Dest) <= sizeof(T),
+    ToUnsigned<T>, T>::type;
+
+template <typename Dest, typename T>
+using ConversionDest = typename std::conditional<
+    IsIntegerConversion<Dest, T>(),
+    Number<sizeof(Dest), get_number_kind<ConversionSource<Dest, T>>()>,
+    Dest>::type;
+
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> StaticSimdCastImpl(Simd<T, Abi> simd, std::true_type) {
+  return bit_cast<Dest>(simd);
+}
+
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> StaticSimdCastImpl(Simd<T, Abi> simd, std::false_type) {
+  return bit_cast<Dest>(ConvertElements<ConversionDest<Dest, T>>(
+      bit_cast<ConversionSource<Dest, T>>(simd)));
+}
+
+// Returns static_cast<Dest> of each element of a native Simd object.
+template <typename Dest, typename T, typename Abi>
+Simd<Dest, Abi> StaticSimdCast(Simd<T, Abi> simd) {
+  constexpr bool kSameWidthIntegers =
+      std::is_same<ConversionSource<Dest, T>, ConversionDest<Dest, T>>::value;
+  return StaticSimdCastImpl<Dest>(
+      simd, std::integral_constant<bool, kSameWidthIntegers>());
+}
+
+}  // namespace detail
+
+// ----------------- Converting Loads and Stores -----------------
+// Simd::copy_from() and copy_to() convert one element at a time when the
+// memory type differs from the element type. The functions below convert
+// with vector instructions, e.g. pmovzx and cvtdq2ps on x86, for the common
+// pairs of types. None of them need alignment.
+
+// Loads SimdType::size() elements of type Src from p, each converted to
+// SimdType::value_type as by static_cast. For example,
+//   load_converted<Simd128<float>>(pixels)
+// loads 4 uint8 pixels into floats.
+template <typename SimdType, typename Src>
+SimdType load_converted(const Src* p);
+
+// Stores each element of simd to p, converted to Dest as by static_cast.
+// As with static_cast, floating points out of the range of an integral Dest
+// store unspecified values.
+template <typename Dest, typename T, typename Abi>
+void store_converted(Simd<T, Abi> simd, Dest* p);
+
+// Stores each element of simd to p, clamped into the range of Dest, which is
+// integral. Floating points are truncated towards zero; NaNs store
+// unspecified values.
+template <typename Dest, typename T, typename Abi>
+void store_saturated(Simd<T, Abi> simd, Dest* p);
+
+namespace detail {
+
+// Whether generic loads and stores of Simd<T, Abi> convert 16-byte pieces
+// with the specializations of the 16-byte versions, e.g. for Simd256 without
+// AVX2.
+template <typename T, typename Abi>
+constexpr bool UseWidePieces() {
+  return UsePieces<T, Abi>() && sizeof(Simd<T, Abi>) > 16;
+}
+
+template <typename T, typename Abi>
+using UseWidePiecesTag = std::integral_constant<bool, UseWidePieces<T, Abi>()>;
+
+template <typename SimdType, typename Src>
+SimdType LoadConvertedImpl(const Src* p, std::true_type /* pieces */) {
+  using T = typename SimdType::value_type;
+  typename SimdType::__native_type raw;
+  DIMSUM_UNROLL for (size_t i = 0; i < SimdType::size();
+                     i += Piece<T>::size()) {
+    typename Piece<T>::__native_type piece =
+        load_converted<Piece<T>>(p + i).__raw();
+    memcpy(reinterpret_cast<char*>(&raw) + i * sizeof(T), &piece,
+           sizeof(piece));
+  }
+  return raw;
+}
+
+template <typename SimdType, typename Src>
+SimdType LoadConvertedImpl(const Src* p, std::false_type /* pieces */) {
+  using T = typename SimdType::value_type;
+  using Abi = typename SimdType::abi_type;
+  Vector<T, Abi> ret;
+  DIMSUM_UNROLL for (size_t i = 0; i < SimdType::size(); i++) {
+    ret[i] = static_cast<T>(p[i]);
+  }
+  return FromVector<T, Abi>(ret);
+}
+
+template <typename SimdType, typename Src>
+SimdType LoadConverted(const Src* p, std::true_type /* same type */) {
+  return LoadUnaligned<SimdType>(p);
+}
+
+template <typename SimdType, typename Src>
+SimdType LoadConverted(const Src* p, std::false_type /* same type */) {
+  using T = typename SimdType::value_type;
+  using Abi = typename SimdType::abi_type;
+  NoteFallback<fallback::load_converted, T, Abi>();
+  return LoadConvertedImpl<SimdType>(p, UseWidePiecesTag<T, Abi>());
+}
+
+// Calls store_piece(piece, i) on each 16-byte piece of simd, where i is the
+// index of its first element.
+template <typename T, typename Abi, typename StorePiece>
+void ForEachPiece(Simd<T, Abi> simd, StorePiece store_piece) {
+  typename Simd<T, Abi>::__native_type raw = simd.__raw();
+  DIMSUM_UNROLL for (size_t i = 0; i < simd.size(); i += Piece<T>::size()) {
+    typename Piece<T>::__native_type piece;
+    memcpy(&piece, reinterpret_cast<const char*>(&raw) + i * sizeof(T),
+           sizeof(piece));
+    store_piece(Piece<T>(piece), i);
+  }
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreConvertedImpl(Simd<T, Abi> simd, Dest* p,
+                        std::true_type /* pieces */) {
+  ForEachPiece(simd, [p](Piece<T> piece, size_t i) {
+    store_converted(piece, p + i);
+  });
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreConvertedImpl(Simd<T, Abi> simd, Dest* p,
+                        std::false_type /* pieces */) {
+  const Vector<T, Abi> vector = ToVector(simd);
+  DIMSUM_UNROLL for (size_t i = 0; i < simd.size(); i++) {
+    p[i] = static_cast<Dest>(vector[i]);
+  }
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreConverted(Simd<T, Abi> simd, Dest* p,
+                    std::true_type /* same type */) {
+  StoreUnaligned(simd, p);
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreConverted(Simd<T, Abi> simd, Dest* p,
+                    std::false_type /* same type */) {
+  NoteFallback<fallback::store_converted, T, Abi>();
+  StoreConvertedImpl(simd, p, UseWidePiecesTag<T, Abi>());
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreSaturatedImpl(Simd<T, Abi> simd, Dest* p,
+                        std::true_type /* pieces */) {
+  ForEachPiece(simd, [p](Piece<T> piece, size_t i) {
+    store_saturated(piece, p + i);
+  });
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreSaturatedImpl(Simd<T, Abi> simd, Dest* p,
+                        std::false_type /* pieces */) {
+  const Vector<T, Abi> vector = ToVector(simd);
+  DIMSUM_UNROLL for (size_t i = 0; i < simd.size(); i++) {
+    p[i] = saturated_convert<Dest>(vector[i]);
+  }
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreSaturated(Simd<T, Abi> simd, Dest* p,
+                    std::true_type /* same type */) {
+  StoreUnaligned(simd, p);
+}
+
+template <typename Dest, typename T, typename Abi>
+void StoreSaturated(Simd<T, Abi> simd, Dest* p,
+                    std::false_type /* same type */) {
+  NoteFallback<fallback::store_saturated, T, Abi>();
+  StoreSaturatedImpl(simd, p, UseWidePiecesTag<T, Abi>());
+}
+
+}  // namespace detail
+
+template <typename SimdType, typename Src>
+SimdType load_converted(const Src* p) {
+  return detail::LoadConverted<SimdType>(
+      p, std::is_same<typename SimdType::value_type, Src>());
+}
+
+template <typename Dest, typename T, typename Abi>
+void store_converted(Simd<T, Abi> simd, Dest* p) {
+  detail::StoreConverted(simd, p, std::is_same<T, Dest>());
+}
+
+template <typename Dest, typename T, typename Abi>
+void store_saturated(Simd<T, Abi> simd, Dest* p) {
+  static_assert(std::is_integral<Dest>::value,
+                "store_saturated stores integers");
+  detail::StoreSaturated(simd, p, std::is_same<T, Dest>());
+}
+
 // Returns the element-wise comparison result.
 // Each element in the result is 0 for false and non-zero for true.
-// The result in each lane is undefined if either of the argument is NaN.
-// TODO(maskray) define NaN comparison if it is needed.
+// Floating point elements compare like the scalar operators: if either
+// argument is NaN, cmp_ne is true and the other comparisons are false.
 //
 // On x86_64, powerpc64le and aarch64, there is a stronger commitment that
 // each element is either 0 for false or ~0 for true.
@@ -333,6 +790,7 @@ typename SimdMask<T, Abi>::__native_type to_raw(SimdMask<T, Abi> v) {
 // with the exact width (float => uint32, double => uint64).
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_eq(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_eq, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -343,6 +801,7 @@ Simd<detail::ToUnsigned<Tp>, Abi> cmp_eq(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
 
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_ne(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_ne, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -353,6 +812,7 @@ Simd<detail::ToUnsigned<Tp>, Abi> cmp_ne(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
 
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_lt(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_lt, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -363,6 +823,7 @@ Simd<detail::ToUnsigned<Tp>, Abi> cmp_lt(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
 
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_le(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_le, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -373,6 +834,7 @@ Simd<detail::ToUnsigned<Tp>, Abi> cmp_le(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
 
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_gt(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_gt, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -383,6 +845,7 @@ Simd<detail::ToUnsigned<Tp>, Abi> cmp_gt(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
 
 template <typename Tp, typename Abi>
 Simd<detail::ToUnsigned<Tp>, Abi> cmp_ge(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  detail::NoteFallback<detail::fallback::cmp_ge, Tp, Abi>();
   using Unsigned = detail::ToUnsigned<Tp>;
   Simd<Unsigned, Abi> ret;
   for (int i = 0; i < ret.size(); i++) {
@@ -487,11 +950,13 @@ abs(Simd<T, Abi> simd) {
 // to Rounding Control field RN in FPSCR, which defaults to round-to-even.
 template <typename Dest, typename T, typename Abi>
 Simd<Dest, Abi> round_to_integer(Simd<T, Abi> v) {
-  Simd<Dest, Abi> ret;
-  for (int i = 0; i < v.size(); i++) {
-    ret[i] = static_cast<Dest>(std::nearbyint(v[i]));
+  detail::NoteFallback<detail::fallback::round_to_integer, T, Abi>();
+  detail::Vector<T, Abi> rounded = detail::ToVector(round(v));
+  detail::Vector<Dest, Abi> ret;
+  DIMSUM_UNROLL for (size_t i = 0; i < v.size(); i++) {
+    ret[i] = static_cast<Dest>(rounded[i]);
   }
-  return ret;
+  return detail::FromVector<Dest, Abi>(ret);
 }
 
 // Partitions the input elements into NewSize groups. For each group, sums up
@@ -561,11 +1026,46 @@ template <typename T, typename Abi>
 Simd<T, Abi> fma(Simd<T, Abi> a, Simd<T, Abi> b, Simd<T, Abi> c) {
   static_assert(std::is_floating_point<T>::value,
                 "Only floating point types are supported");
-  Simd<T, Abi> ret;
-  for (size_t i = 0; i < a.size(); i++) ret[i] = std::fma(a[i], b[i], c[i]);
-  return ret;
+  detail::NoteFallback<detail::fallback::fma, T, Abi>();
+  detail::Vector<T, Abi> ret = detail::ToVector(a);
+  const detail::Vector<T, Abi> b_vector = detail::ToVector(b);
+  const detail::Vector<T, Abi> c_vector = detail::ToVector(c);
+  DIMSUM_UNROLL for (size_t i = 0; i < a.size(); i++) {
+    ret[i] = std::fma(ret[i], b_vector[i], c_vector[i]);
+  }
+  return detail::FromVector<T, Abi>(ret);
 }
 
 }  // namespace dimsum
 
+_DIMSUM_BEGIN_NAMESPACE_EXPERIMENTAL_SIMD
+
+// Casts from native Simd objects to native Simd objects of the same size go
+// through dimsum::detail::StaticSimdCast instead of converting one element at
+// a time. The simd header is mirrored from libc++, so this specializes its
+// cast traits here rather than changing them there.
+template <class _Tp, int _Np>
+struct __static_simd_cast_traits<
+    simd<_Tp, __simd_abi<_StorageKind::_VecExt, _Np>>> {
+  using _Ret = simd<_Tp, __simd_abi<_StorageKind::_VecExt, _Np>>;
+
+  template <class _Up, class _Abi>
+  static typename std::enable_if<simd<_Up, _Abi>::size() == _Np, _Ret>::type
+  __apply(const simd<_Up, _Abi>& __v) {
+    _Ret __ret;
+    for (size_t __i = 0; __i < __v.size(); __i++) {
+      __ret[__i] = static_cast<_Tp>(__v[__i]);
+    }
+    return __ret;
+  }
+
+  template <class _Up>
+  static _Ret __apply(
+      const simd<_Up, __simd_abi<_StorageKind::_VecExt, _Np>>& __v) {
+    return dimsum::detail::StaticSimdCast<_Tp>(__v);
+  }
+};
+
+_DIMSUM_END_NAMESPACE_EXPERIMENTAL_SIMD
+
 #endif  // DIMSUM_OPERATIONS_H_
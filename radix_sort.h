@@ -0,0 +1,274 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_RADIX_SORT_H_
+#define DIMSUM_RADIX_SORT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dimsum.h"
+
+// A stable least-significant-digit radix sort of int32, uint32, int64,
+// uint64, float and double keys, optionally with a payload per key.
+//
+// Keys are first mapped to unsigned integers of the same width whose order
+// is the order of the keys: the sign bit of signed integers is flipped, and
+// negative floating point values have all their bits flipped, positive ones
+// only the sign bit. The mapping is applied to NativeSimd blocks with
+// bit_cast, and the digit histograms of all passes are counted in the same
+// pass over the keys. Keys are then scattered one 8-bit digit at a time,
+// skipping digits that are the same for all keys. Each pass writes through
+// small per-bucket buffers of one cache line, which are copied out when
+// full; 256 interleaved output streams would otherwise miss the TLB and the
+// write-combining buffers.
+//
+// Floating point keys are ordered by their bits: -0.0 is before 0.0, and NaNs
+// are first or last depending on their sign bit.
+
+namespace dimsum {
+namespace detail {
+
+// Whether K is one of the supported key types. Integer keys are ordered in
+// place through RadixBits<K>, which may only alias K if it is K's unsigned
+// variant. Other types of the same width, e.g. long long where int64 is long,
+// are not supported.
+template <typename K>
+constexpr bool IsRadixKey() {
+  return std::is_same<K, int32>::value || std::is_same<K, uint32>::value ||
+         std::is_same<K, int64>::value || std::is_same<K, uint64>::value ||
+         std::is_same<K, float>::value || std::is_same<K, double>::value;
+}
+
+template <typename K>
+using RadixBits = typename std::conditional<sizeof(K) == 4, uint32,
+                                            uint64>::type;
+
+template <typename K>
+using RadixBlock = NativeSimd<RadixBits<K>>;
+
+constexpr int kRadixDigitBits = 8;
+constexpr size_t kRadixBuckets = 1 << kRadixDigitBits;
+constexpr size_t kRadixBufferBytes = 64;
+
+// Inputs shorter than this are scattered directly: their buckets are short,
+// and the buffers would only add copies.
+constexpr size_t kRadixMinBufferedSize = 1 << 16;
+
+// Returns the mask that is XORed with the bits of a key to order them as
+// unsigned integers.
+template <typename K, typename Bits>
+Bits RadixOrderMask(Bits bits) {
+  constexpr int kSignShift = 8 * sizeof(K) - 1;
+  const Bits sign = Bits(RadixBits<K>{1} << kSignShift);
+  if (std::is_floating_point<K>::value) {
+    // All ones for negative values.
+    return (Bits(0) - (bits >> kSignShift)) | sign;
+  }
+  return std::is_signed<K>::value ? sign : Bits(0);
+}
+
+// The inverse of RadixOrderMask, applied to ordered bits.
+template <typename K, typename Bits>
+Bits RadixUnorderMask(Bits bits) {
+  constexpr int kSignShift = 8 * sizeof(K) - 1;
+  const Bits sign = Bits(RadixBits<K>{1} << kSignShift);
+  if (std::is_floating_point<K>::value) {
+    // All ones for ordered bits without the sign bit, which are negative.
+    return ((bits >> kSignShift) - Bits(1)) | sign;
+  }
+  return std::is_signed<K>::value ? sign : Bits(0);
+}
+
+// Stores the ordered bits of keys[0, n) to out, and adds the number of keys
+// with each value of digit d to counts[d].
+template <typename K>
+void RadixOrderKeys(const K* keys, size_t n, RadixBits<K>* out,
+                    size_t (*counts)[kRadixBuckets]) {
+  using Bits = RadixBits<K>;
+  using Block = RadixBlock<K>;
+  const size_t tail = n % Block::size();
+  for (size_t i = 0; i < n - tail; i += Block::size()) {
+    Block bits = bit_cast<Bits>(LoadUnaligned<NativeSimd<K, Block::size()>>(
+        keys + i));
+    StoreUnaligned(bits ^ RadixOrderMask<K>(bits), out + i);
+  }
+  for (size_t i = n - tail; i < n; i++) {
+    Bits bits;
+    memcpy(&bits, keys + i, sizeof(bits));
+    out[i] = bits ^ RadixOrderMask<K>(bits);
+  }
+  for (size_t i = 0; i < n; i++) {
+    const Bits bits = out[i];
+    for (size_t d = 0; d < sizeof(K); d++) {
+      counts[d][bits >> kRadixDigitBits * d & (kRadixBuckets - 1)]++;
+    }
+  }
+}
+
+template <typename K>
+void RadixUnorderKeys(const RadixBits<K>* bits, size_t n, K* keys) {
+  using Bits = RadixBits<K>;
+  using Block = RadixBlock<K>;
+  const size_t tail = n % Block::size();
+  for (size_t i = 0; i < n - tail; i += Block::size()) {
+    Block block = LoadUnaligned<Block>(bits + i);
+    StoreUnaligned(bit_cast<K>(block ^ RadixUnorderMask<K>(block)), keys + i);
+  }
+  for (size_t i = n - tail; i < n; i++) {
+    const Bits key = bits[i] ^ RadixUnorderMask<K>(bits[i]);
+    memcpy(keys + i, &key, sizeof(key));
+  }
+}
+
+// A payload type for sorts without one.
+struct RadixNoValues {};
+
+template <typename V>
+constexpr bool RadixHasValues() {
+  return !std::is_same<V, RadixNoValues>::value;
+}
+
+// Moves the keys of src, and the values of src_values, to their buckets of
+// digit d in dst and dst_values; offsets[b] is the start of bucket b.
+template <typename Bits, typename V>
+void RadixScatter(const Bits* src, const V* src_values, size_t n, int d,
+                  size_t* offsets, Bits* dst, V* dst_values) {
+  const int shift = kRadixDigitBits * d;
+  for (size_t i = 0; i < n; i++) {
+    const size_t bucket = src[i] >> shift & (kRadixBuckets - 1);
+    const size_t offset = offsets[bucket]++;
+    dst[offset] = src[i];
+    if (RadixHasValues<V>()) dst_values[offset] = src_values[i];
+  }
+}
+
+// Same as above, through a buffer of kRadixBufferBytes of keys per bucket.
+// Values are buffered alongside, as many as the keys.
+template <typename Bits, typename V>
+void RadixScatterBuffered(const Bits* src, const V* src_values, size_t n,
+                          int d, size_t* offsets, Bits* dst, V* dst_values) {
+  constexpr size_t kBuffered = kRadixBufferBytes / sizeof(Bits);
+  struct Buffers {
+    Bits keys[kRadixBuckets][kBuffered];
+    V values[RadixHasValues<V>() ? kRadixBuckets : 1][kBuffered];
+    uint8 size[kRadixBuckets];
+  };
+  std::vector<Buffers> storage(1);
+  Buffers& buffers = storage[0];
+  memset(buffers.size, 0, sizeof(buffers.size));
+  const int shift = kRadixDigitBits * d;
+  for (size_t i = 0; i < n; i++) {
+    const size_t bucket = src[i] >> shift & (kRadixBuckets - 1);
+    const size_t size = buffers.size[bucket];
+    buffers.keys[bucket][size] = src[i];
+    if (RadixHasValues<V>()) buffers.values[bucket][size] = src_values[i];
+    if (size + 1 < kBuffered) {
+      buffers.size[bucket] = size + 1;
+      continue;
+    }
+    const size_t offset = offsets[bucket];
+    memcpy(dst + offset, buffers.keys[bucket], sizeof(buffers.keys[bucket]));
+    if (RadixHasValues<V>()) {
+      memcpy(dst_values + offset, buffers.values[bucket],
+             sizeof(buffers.values[bucket]));
+    }
+    offsets[bucket] = offset + kBuffered;
+    buffers.size[bucket] = 0;
+  }
+  for (size_t bucket = 0; bucket < kRadixBuckets; bucket++) {
+    const size_t size = buffers.size[bucket];
+    memcpy(dst + offsets[bucket], buffers.keys[bucket], size * sizeof(Bits));
+    if (RadixHasValues<V>()) {
+      memcpy(dst_values + offsets[bucket], buffers.values[bucket],
+             size * sizeof(V));
+    }
+  }
+}
+
+template <typename K, typename V>
+void RadixSort(K* keys, V* values, size_t n) {
+  using Bits = RadixBits<K>;
+  // Integer keys are ordered in place, as Bits may alias them. Floating point
+  // keys need a buffer of their own.
+  constexpr bool kInPlace = std::is_integral<K>::value;
+  // Not value-initialized: the scatters write every element before reading
+  // it, and zeroing would be an extra pass over memory.
+  std::unique_ptr<Bits[]> buffer(new Bits[kInPlace ? n : 2 * n]);
+  std::unique_ptr<V[]> values_buffer(new V[RadixHasValues<V>() ? n : 0]);
+  Bits* src = kInPlace ? reinterpret_cast<Bits*>(keys) : buffer.get() + n;
+  Bits* dst = buffer.get();
+  V* src_values = values;
+  V* dst_values = values_buffer.get();
+
+  size_t counts[sizeof(K)][kRadixBuckets] = {};
+  RadixOrderKeys(keys, n, src, counts);
+  for (size_t d = 0; d < sizeof(K); d++) {
+    size_t offsets[kRadixBuckets];
+    size_t offset = 0;
+    bool trivial = false;
+    for (size_t bucket = 0; bucket < kRadixBuckets; bucket++) {
+      offsets[bucket] = offset;
+      offset += counts[d][bucket];
+      trivial |= counts[d][bucket] == n;
+    }
+    // All keys are in the same bucket, and would stay in place.
+    if (trivial) continue;
+    if (n >= kRadixMinBufferedSize) {
+      RadixScatterBuffered(src, src_values, n, d, offsets, dst, dst_values);
+    } else {
+      RadixScatter(src, src_values, n, d, offsets, dst, dst_values);
+    }
+    std::swap(src, dst);
+    std::swap(src_values, dst_values);
+  }
+  RadixUnorderKeys(src, n, keys);
+  if (RadixHasValues<V>() && src_values != values) {
+    std::copy(src_values, src_values + n, values);
+  }
+}
+
+}  // namespace detail
+
+// Sorts keys[0, n) in increasing order, and moves values[i] along with
+// keys[i]. The sort is stable. K is int32, uint32, int64, uint64, float or
+// double; V is trivially copyable. Takes n integer keys, or 2n floating
+// point keys, and n values of scratch memory.
+template <typename K, typename V>
+void radix_sort(K* keys, V* values, size_t n) {
+  static_assert(detail::IsRadixKey<K>(),
+                "Keys must be int32, uint32, int64, uint64, float or double");
+  static_assert(std::is_trivially_copyable<V>::value,
+                "Values must be trivially copyable");
+  detail::RadixSort(keys, values, n);
+}
+
+// Sorts keys[0, n) in increasing order.
+template <typename K>
+void radix_sort(K* keys, size_t n) {
+  static_assert(detail::IsRadixKey<K>(),
+                "Keys must be int32, uint32, int64, uint64, float or double");
+  detail::RadixSort(keys, static_cast<detail::RadixNoValues*>(nullptr), n);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_RADIX_SORT_H_
@@ -0,0 +1,103 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "radix_sort.h"
+
+namespace dimsum {
+namespace {
+
+template <typename K>
+std::vector<K> RandomKeys(size_t n) {
+  std::mt19937_64 gen(0);
+  std::vector<K> keys(n);
+  for (K& key : keys) key = static_cast<K>(gen() >> 8);
+  return keys;
+}
+
+template <typename K>
+void BM_StdSort(benchmark::State& state) {
+  std::vector<K> input = RandomKeys<K>(state.range(0));
+  std::vector<K> keys;
+  for (auto _ : state) {
+    keys = input;
+    std::sort(keys.begin(), keys.end());
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_StdSort, uint32)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StdSort, uint64)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StdSort, float)->Arg(1 << 20);
+
+template <typename K>
+void BM_RadixSort(benchmark::State& state) {
+  std::vector<K> input = RandomKeys<K>(state.range(0));
+  std::vector<K> keys;
+  for (auto _ : state) {
+    keys = input;
+    radix_sort(keys.data(), keys.size());
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_RadixSort, uint32)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_RadixSort, uint64)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_RadixSort, float)->Arg(1 << 20);
+
+// Key-value sorts, against sorting pairs.
+template <typename K>
+void BM_StdStableSortPairs(benchmark::State& state) {
+  std::vector<K> keys = RandomKeys<K>(state.range(0));
+  std::vector<std::pair<K, uint32>> input(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) input[i] = {keys[i], i};
+  std::vector<std::pair<K, uint32>> pairs;
+  for (auto _ : state) {
+    pairs = input;
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const std::pair<K, uint32>& a,
+                        const std::pair<K, uint32>& b) {
+                       return a.first < b.first;
+                     });
+    benchmark::DoNotOptimize(pairs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_StdStableSortPairs, uint32)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StdStableSortPairs, uint64)->Arg(1 << 20);
+
+template <typename K>
+void BM_RadixSortPairs(benchmark::State& state) {
+  std::vector<K> input = RandomKeys<K>(state.range(0));
+  std::vector<K> keys;
+  std::vector<uint32> values(input.size());
+  for (auto _ : state) {
+    keys = input;
+    for (size_t i = 0; i < values.size(); i++) values[i] = i;
+    radix_sort(keys.data(), values.data(), keys.size());
+    benchmark::DoNotOptimize(keys.data());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_RadixSortPairs, uint32)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_RadixSortPairs, uint64)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace dimsum
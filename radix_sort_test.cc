@@ -0,0 +1,151 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+template <typename K>
+K RandomKey(std::mt19937_64* gen, std::true_type /*is_floating_point*/) {
+  std::uniform_real_distribution<K> dist(-1e6, 1e6);
+  return dist(*gen);
+}
+
+template <typename K>
+K RandomKey(std::mt19937_64* gen, std::false_type /*is_floating_point*/) {
+  return static_cast<K>((*gen)());
+}
+
+template <typename K>
+K RandomKey(std::mt19937_64* gen) {
+  return RandomKey<K>(gen, std::is_floating_point<K>());
+}
+
+template <typename K>
+class RadixSortTest : public ::testing::Test {};
+
+using RadixSortTypes =
+    ::testing::Types<int32, uint32, int64, uint64, float, double>;
+TYPED_TEST_CASE(RadixSortTest, RadixSortTypes);
+
+TYPED_TEST(RadixSortTest, Keys) {
+  using K = TypeParam;
+  std::mt19937_64 gen(0);
+  // Above and below the size at which the scatter is buffered.
+  for (size_t n : {0, 1, 2, 3, 17, 1000, 100000}) {
+    SCOPED_TRACE(n);
+    std::vector<K> keys(n);
+    for (K& key : keys) key = RandomKey<K>(&gen);
+    std::vector<K> expected(keys);
+    std::sort(expected.begin(), expected.end());
+    radix_sort(keys.data(), keys.size());
+    EXPECT_EQ(expected, keys);
+  }
+}
+
+TYPED_TEST(RadixSortTest, Extremes) {
+  using K = TypeParam;
+  std::vector<K> keys = {std::numeric_limits<K>::max(),
+                         std::numeric_limits<K>::lowest(),
+                         0,
+                         1,
+                         static_cast<K>(-1),
+                         std::numeric_limits<K>::min(),
+                         static_cast<K>(100)};
+  std::vector<K> expected(keys);
+  std::sort(expected.begin(), expected.end());
+  radix_sort(keys.data(), keys.size());
+  EXPECT_EQ(expected, keys);
+}
+
+// Keys with few distinct values, so that values check stability.
+TYPED_TEST(RadixSortTest, KeysAndValues) {
+  using K = TypeParam;
+  std::mt19937_64 gen(0);
+  for (size_t n : {1000, 100000}) {
+    SCOPED_TRACE(n);
+    std::vector<K> keys(n);
+    std::vector<uint32> values(n);
+    std::vector<std::pair<K, uint32>> expected(n);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = static_cast<K>(static_cast<int>(gen() % 1000) - 500);
+      values[i] = i;
+      expected[i] = {keys[i], values[i]};
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const std::pair<K, uint32>& a,
+                        const std::pair<K, uint32>& b) {
+                       return a.first < b.first;
+                     });
+    radix_sort(keys.data(), values.data(), n);
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(expected[i].first, keys[i]) << i;
+      ASSERT_EQ(expected[i].second, values[i]) << i;
+    }
+  }
+}
+
+TEST(RadixSortTest, FloatOrder) {
+  std::vector<float> keys = {1.0f, -0.0f, 0.0f, -INFINITY, INFINITY,
+                             -1.5f, std::numeric_limits<float>::denorm_min(),
+                             -std::numeric_limits<float>::denorm_min()};
+  radix_sort(keys.data(), keys.size());
+  std::vector<float> expected = {-INFINITY,
+                                 -1.5f,
+                                 -std::numeric_limits<float>::denorm_min(),
+                                 -0.0f,
+                                 0.0f,
+                                 std::numeric_limits<float>::denorm_min(),
+                                 1.0f,
+                                 INFINITY};
+  ASSERT_EQ(expected.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(expected[i], keys[i]) << i;
+    EXPECT_EQ(std::signbit(expected[i]), std::signbit(keys[i])) << i;
+  }
+}
+
+struct Payload {
+  uint64 a;
+  uint32 b;
+};
+
+TEST(RadixSortTest, StructValues) {
+  std::mt19937_64 gen(0);
+  const size_t n = 70000;
+  std::vector<uint64> keys(n);
+  std::vector<Payload> values(n);
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = gen() >> 20;
+    values[i] = {keys[i] * 3, static_cast<uint32>(i)};
+  }
+  radix_sort(keys.data(), values.data(), n);
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  for (size_t i = 0; i < n; i++) ASSERT_EQ(keys[i] * 3, values[i].a) << i;
+}
+
+}  // namespace
+}  // namespace dimsum
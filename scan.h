@@ -0,0 +1,291 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_SCAN_H_
+#define DIMSUM_SCAN_H_
+
+#include <algorithm>
+#include <cstddef>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+#include "search.h"
+
+// Predicates over columns of int32, int64, float or double values, for
+// columnar scans: scan_equal, scan_between and scan_in.
+//
+// A scan writes a selection bitmap, in which bit i % 64 of word i / 64 is set
+// if row i matches. Bits past the last row are clear. The bitmap can also be
+// combined with the one of a previous scan with AND or OR, in the same pass,
+// to evaluate a conjunction or disjunction of predicates over several
+// columns. bitmap_to_selection turns a bitmap into a selection vector of row
+// indices.
+//
+// The rows are compared a NativeSimd<T> block at a time with cmp_*, and the
+// masks of the blocks of 64 rows are gathered into one bitmap word with
+// movemask. Like the scalar operators, cmp_* are false for NaN, so NaN rows and
+// NaN constants match nothing.
+
+namespace dimsum {
+
+// How a scan combines its result with the bitmap it writes to.
+enum class ScanCombine {
+  // bitmap = matches.
+  kSet,
+  // bitmap &= matches.
+  kAnd,
+  // bitmap |= matches.
+  kOr,
+};
+
+// Returns the number of bitmap words of a scan of n rows.
+constexpr size_t scan_bitmap_words(size_t n) { return (n + 63) / 64; }
+
+namespace detail {
+
+// Keeps predicate constants from taking part in the deduction of T, so that
+// scan_equal(int32_column, n, 1, ...) compiles.
+template <typename T>
+struct ScanIdentity {
+  using type = T;
+};
+
+template <typename T>
+using ScanBlock = NativeSimd<T>;
+
+inline void CombineScanWord(uint64 word, ScanCombine combine, uint64* out) {
+  switch (combine) {
+    case ScanCombine::kSet:
+      *out = word;
+      break;
+    case ScanCombine::kAnd:
+      *out &= word;
+      break;
+    case ScanCombine::kOr:
+      *out |= word;
+      break;
+  }
+}
+
+// Returns the matches of pred among the 64 rows of column.
+template <typename T, typename Predicate>
+uint64 ScanWord(const T* column, const Predicate& pred) {
+  using Block = ScanBlock<T>;
+  uint64 word = 0;
+  for (size_t i = 0; i < 64; i += Block::size()) {
+    const uint32 mask = x86::movemask(pred(LoadUnaligned<Block>(column + i)));
+    word |= uint64{mask} << i;
+  }
+  return word;
+}
+
+// Same as above, for the last size < 64 rows of a column.
+template <typename T, typename Predicate>
+uint64 ScanLastWord(const T* column, size_t size, const Predicate& pred) {
+  uint64 word = 0;
+  for (size_t i = 0; i < size; i++) word |= uint64{pred(column[i])} << i;
+  return word;
+}
+
+template <typename T, typename Predicate>
+void Scan(const T* column, size_t n, const Predicate& pred, uint64* bitmap,
+          ScanCombine combine) {
+  size_t row = 0;
+  for (; row + 64 <= n; row += 64, bitmap++) {
+    CombineScanWord(ScanWord(column + row, pred), combine, bitmap);
+  }
+  if (row < n) {
+    CombineScanWord(ScanLastWord(column + row, n - row, pred), combine,
+                    bitmap);
+  }
+}
+
+// Each predicate is called on a ScanBlock<T>, returning the cmp_* mask of its
+// matches, and on a T, returning whether it matches.
+template <typename T>
+class ScanEqual {
+ public:
+  explicit ScanEqual(T value) : value_(value), block_(value) {}
+
+  ScanBlock<ToUnsigned<T>> operator()(ScanBlock<T> v) const {
+    return cmp_eq(v, block_);
+  }
+  bool operator()(T v) const { return v == value_; }
+
+ private:
+  T value_;
+  ScanBlock<T> block_;
+};
+
+template <typename T>
+class ScanBetween {
+ public:
+  ScanBetween(T lo, T hi) : lo_(lo), hi_(hi), lo_block_(lo), hi_block_(hi) {}
+
+  ScanBlock<ToUnsigned<T>> operator()(ScanBlock<T> v) const {
+    return cmp_ge(v, lo_block_) & cmp_le(v, hi_block_);
+  }
+  bool operator()(T v) const { return lo_ <= v && v <= hi_; }
+
+ private:
+  T lo_;
+  T hi_;
+  ScanBlock<T> lo_block_;
+  ScanBlock<T> hi_block_;
+};
+
+// The values of a scan_in are broadcast kScanInGroup at a time, and each
+// block of rows is compared with all values of a group before its mask is
+// gathered. Longer lists take one pass per group over chunks of kScanInRows
+// rows, which stay in L1 across the passes.
+constexpr size_t kScanInGroup = 8;
+constexpr size_t kScanInRows = 256;
+
+// Matches any of 1 to kScanInGroup values.
+template <typename T>
+class ScanAnyOf {
+ public:
+  ScanAnyOf(const T* values, size_t size) : values_(values), size_(size) {
+    for (size_t i = 0; i < size; i++) blocks_[i] = ScanBlock<T>(values[i]);
+  }
+
+  ScanBlock<ToUnsigned<T>> operator()(ScanBlock<T> v) const {
+    ScanBlock<ToUnsigned<T>> mask = cmp_eq(v, blocks_[0]);
+    for (size_t i = 1; i < size_; i++) mask |= cmp_eq(v, blocks_[i]);
+    return mask;
+  }
+  bool operator()(T v) const {
+    for (size_t i = 0; i < size_; i++) {
+      if (v == values_[i]) return true;
+    }
+    return false;
+  }
+
+ private:
+  const T* values_;
+  size_t size_;
+  ScanBlock<T> blocks_[kScanInGroup];
+};
+
+struct ScanTables {
+  ScanTables() {
+    for (int mask = 0; mask < 16; mask++) {
+      uint32 lanes[4] = {};
+      int lane = 0;
+      for (int i = 0; i < 4; i++) {
+        if (mask & 1 << i) lanes[lane++] = i;
+      }
+      selection[mask] = Simd128<uint32>(lanes, flags::element_aligned);
+      count[mask] = lane;
+    }
+  }
+
+  // selection[mask] holds the indices of the bits of mask, lowest first, and
+  // count[mask] their number. The latter avoids a call to __popcountdi2 on
+  // targets without popcnt.
+  Simd128<uint32> selection[16];
+  uint8 count[16];
+};
+
+inline const ScanTables& GetScanTables() {
+  static const ScanTables tables;
+  return tables;
+}
+
+}  // namespace detail
+
+// Selects the rows of column[0, n) that are equal to value.
+template <typename T>
+void scan_equal(const T* column, size_t n,
+                typename detail::ScanIdentity<T>::type value, uint64* bitmap,
+                ScanCombine combine = ScanCombine::kSet) {
+  detail::Scan(column, n, detail::ScanEqual<T>(value), bitmap, combine);
+}
+
+// Selects the rows of column[0, n) in [lo, hi].
+template <typename T>
+void scan_between(const T* column, size_t n,
+                  typename detail::ScanIdentity<T>::type lo,
+                  typename detail::ScanIdentity<T>::type hi, uint64* bitmap,
+                  ScanCombine combine = ScanCombine::kSet) {
+  detail::Scan(column, n, detail::ScanBetween<T>(lo, hi), bitmap, combine);
+}
+
+// Selects the rows of column[0, n) that are equal to any of
+// values[0, num_values). The cost grows with num_values; it is meant for
+// short lists, and lists of up to 8 values take a single pass.
+template <typename T>
+void scan_in(const T* column, size_t n, const T* values, size_t num_values,
+             uint64* bitmap, ScanCombine combine = ScanCombine::kSet) {
+  constexpr size_t kWords = detail::kScanInRows / 64;
+  for (size_t row = 0; row < n; row += detail::kScanInRows) {
+    const size_t rows =
+        n - row < detail::kScanInRows ? n - row : detail::kScanInRows;
+    uint64 words[kWords] = {};
+    for (size_t v = 0; v < num_values; v += detail::kScanInGroup) {
+      const detail::ScanAnyOf<T> pred(
+          values + v, std::min(num_values - v, detail::kScanInGroup));
+      for (size_t w = 0; w * 64 < rows; w++) {
+        const T* words_column = column + row + w * 64;
+        words[w] |= rows - w * 64 >= 64
+                        ? detail::ScanWord(words_column, pred)
+                        : detail::ScanLastWord(words_column, rows - w * 64,
+                                               pred);
+      }
+    }
+    for (size_t w = 0; w * 64 < rows; w++) {
+      detail::CombineScanWord(words[w], combine, bitmap + row / 64 + w);
+    }
+  }
+}
+
+// Stores the indices of the rows selected by bitmap, in increasing order, to
+// out, and returns their number. bitmap holds scan_bitmap_words(n) words;
+// out needs room for n indices.
+//
+// Dense words are expanded 4 rows at a time, by adding the row of the first
+// to a table entry indexed by their 4 bits; sparse words go one bit at a time.
+inline size_t bitmap_to_selection(const uint64* bitmap, size_t n,
+                                  uint32* out) {
+  const detail::ScanTables& tables = detail::GetScanTables();
+  size_t count = 0;
+  for (size_t row = 0; row < n; row += 64) {
+    uint64 word = bitmap[row / 64];
+    if (n - row < 64) {
+      word &= (uint64{1} << (n - row)) - 1;
+      for (int i : BitmaskIterator<uint64>(word)) out[count++] = row + i;
+      break;
+    }
+    if (__builtin_popcountll(word) < 16) {
+      for (int i : BitmaskIterator<uint64>(word)) out[count++] = row + i;
+      continue;
+    }
+    // The 4 lanes stored for rows [row + i, row + i + 4) start at most at
+    // out + row + i, so they stay within the room of out in a full word.
+    Simd128<uint32> rows(static_cast<uint32>(row));
+    for (int i = 0; i < 64; i += 4, word >>= 4) {
+      const int nibble = word & 0xf;
+      detail::StoreUnaligned(rows + tables.selection[nibble], out + count);
+      count += tables.count[nibble];
+      rows += Simd128<uint32>(4);
+    }
+  }
+  return count;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_SCAN_H_
@@ -0,0 +1,161 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "scan.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kNumRows = 1 << 16;
+
+// Values in [0, 100), so that the predicates below select about half of the
+// rows, at random.
+template <typename T>
+std::vector<T> RandomColumn() {
+  std::mt19937 gen(0);
+  std::vector<T> column(kNumRows);
+  for (T& value : column) value = static_cast<T>(gen() % 100);
+  return column;
+}
+
+template <typename T>
+void BM_ScalarBetween(benchmark::State& state) {
+  std::vector<T> column = RandomColumn<T>();
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (auto _ : state) {
+    for (size_t row = 0; row < kNumRows; row += 64) {
+      uint64 word = 0;
+      for (size_t i = 0; i < 64; i++) {
+        const T value = column[row + i];
+        word |= uint64{25 <= value && value <= 74} << i;
+      }
+      bitmap[row / 64] = word;
+    }
+    benchmark::DoNotOptimize(bitmap.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK_TEMPLATE(BM_ScalarBetween, int32);
+BENCHMARK_TEMPLATE(BM_ScalarBetween, int64);
+BENCHMARK_TEMPLATE(BM_ScalarBetween, float);
+BENCHMARK_TEMPLATE(BM_ScalarBetween, double);
+
+template <typename T>
+void BM_ScanBetween(benchmark::State& state) {
+  std::vector<T> column = RandomColumn<T>();
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (auto _ : state) {
+    scan_between(column.data(), kNumRows, 25, 74, bitmap.data());
+    benchmark::DoNotOptimize(bitmap.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK_TEMPLATE(BM_ScanBetween, int32);
+BENCHMARK_TEMPLATE(BM_ScanBetween, int64);
+BENCHMARK_TEMPLATE(BM_ScanBetween, float);
+BENCHMARK_TEMPLATE(BM_ScanBetween, double);
+
+template <typename T>
+void BM_ScanEqual(benchmark::State& state) {
+  std::vector<T> column = RandomColumn<T>();
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (auto _ : state) {
+    scan_equal(column.data(), kNumRows, 42, bitmap.data());
+    benchmark::DoNotOptimize(bitmap.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK_TEMPLATE(BM_ScanEqual, int32);
+BENCHMARK_TEMPLATE(BM_ScanEqual, int64);
+BENCHMARK_TEMPLATE(BM_ScanEqual, float);
+BENCHMARK_TEMPLATE(BM_ScanEqual, double);
+
+template <typename T>
+void BM_ScanIn(benchmark::State& state) {
+  std::vector<T> column = RandomColumn<T>();
+  std::vector<T> values;
+  for (int i = 0; i < state.range(0); i++) values.push_back(i * 7 % 100);
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (auto _ : state) {
+    scan_in(column.data(), kNumRows, values.data(), values.size(),
+            bitmap.data());
+    benchmark::DoNotOptimize(bitmap.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK_TEMPLATE(BM_ScanIn, int32)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ScanIn, double)->Arg(4)->Arg(16);
+
+// int32 BETWEEN AND double = OR int64 =.
+void BM_ScanCombined(benchmark::State& state) {
+  std::vector<int32> a = RandomColumn<int32>();
+  std::vector<double> b = RandomColumn<double>();
+  std::vector<int64> c = RandomColumn<int64>();
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (auto _ : state) {
+    scan_between(a.data(), kNumRows, 25, 74, bitmap.data());
+    scan_equal(b.data(), kNumRows, 1, bitmap.data(), ScanCombine::kAnd);
+    scan_equal(c.data(), kNumRows, 2, bitmap.data(), ScanCombine::kOr);
+    benchmark::DoNotOptimize(bitmap.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK(BM_ScanCombined);
+
+// The argument is the density of the bitmap in 1/16ths.
+void BM_BitmapToSelection(benchmark::State& state) {
+  std::mt19937 gen(0);
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (size_t i = 0; i < kNumRows; i++) {
+    if (gen() % 16 < static_cast<uint32>(state.range(0))) {
+      bitmap[i / 64] |= uint64{1} << i % 64;
+    }
+  }
+  std::vector<uint32> selection(kNumRows);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        bitmap_to_selection(bitmap.data(), kNumRows, selection.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK(BM_BitmapToSelection)->Arg(1)->Arg(4)->Arg(8)->Arg(15);
+
+void BM_ScalarBitmapToSelection(benchmark::State& state) {
+  std::mt19937 gen(0);
+  std::vector<uint64> bitmap(scan_bitmap_words(kNumRows));
+  for (size_t i = 0; i < kNumRows; i++) {
+    if (gen() % 16 < static_cast<uint32>(state.range(0))) {
+      bitmap[i / 64] |= uint64{1} << i % 64;
+    }
+  }
+  std::vector<uint32> selection(kNumRows);
+  for (auto _ : state) {
+    size_t count = 0;
+    for (size_t row = 0; row < kNumRows; row += 64) {
+      for (int i : BitmaskIterator<uint64>(bitmap[row / 64])) {
+        selection[count++] = row + i;
+      }
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+BENCHMARK(BM_ScalarBitmapToSelection)->Arg(1)->Arg(4)->Arg(8)->Arg(15);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,197 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "scan.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Values in [0, 16), so that predicates match often.
+template <typename T>
+std::vector<T> RandomColumn(size_t n, std::mt19937* gen) {
+  std::vector<T> column(n);
+  for (T& value : column) value = static_cast<T>((*gen)() % 16);
+  return column;
+}
+
+template <typename Predicate>
+std::vector<uint64> ScalarBitmap(size_t n, Predicate pred) {
+  std::vector<uint64> bitmap(scan_bitmap_words(n));
+  for (size_t i = 0; i < n; i++) {
+    if (pred(i)) bitmap[i / 64] |= uint64{1} << i % 64;
+  }
+  return bitmap;
+}
+
+template <typename T>
+class ScanTest : public ::testing::Test {};
+
+using ScanTypes = ::testing::Types<int32, int64, float, double>;
+TYPED_TEST_CASE(ScanTest, ScanTypes);
+
+TYPED_TEST(ScanTest, Predicates) {
+  using T = TypeParam;
+  std::mt19937 gen(0);
+  for (size_t n : {0, 1, 63, 64, 65, 255, 256, 257, 1000}) {
+    SCOPED_TRACE(n);
+    std::vector<T> column = RandomColumn<T>(n, &gen);
+    // Stale bits must be overwritten.
+    std::vector<uint64> bitmap(scan_bitmap_words(n), ~uint64{0});
+
+    scan_equal(column.data(), n, 3, bitmap.data());
+    EXPECT_EQ(ScalarBitmap(n, [&](size_t i) { return column[i] == 3; }),
+              bitmap);
+
+    scan_between(column.data(), n, 2, 7, bitmap.data());
+    EXPECT_EQ(ScalarBitmap(n,
+                           [&](size_t i) {
+                             return 2 <= column[i] && column[i] <= 7;
+                           }),
+              bitmap);
+
+    const T values[] = {1, 5, 11, 42};
+    scan_in(column.data(), n, values, 4, bitmap.data());
+    EXPECT_EQ(ScalarBitmap(n,
+                           [&](size_t i) {
+                             return column[i] == 1 || column[i] == 5 ||
+                                    column[i] == 11;
+                           }),
+              bitmap);
+
+    // More values than are compared in one pass.
+    std::vector<T> odd;
+    for (int i = 0; i < 20; i++) odd.push_back(2 * i + 1);
+    scan_in(column.data(), n, odd.data(), odd.size(), bitmap.data());
+    EXPECT_EQ(ScalarBitmap(n,
+                           [&](size_t i) {
+                             return static_cast<int>(column[i]) % 2 == 1;
+                           }),
+              bitmap);
+
+    scan_in(column.data(), n, values, 0, bitmap.data());
+    EXPECT_EQ(std::vector<uint64>(scan_bitmap_words(n)), bitmap);
+  }
+}
+
+TYPED_TEST(ScanTest, Extremes) {
+  using T = TypeParam;
+  const T kMin = std::numeric_limits<T>::lowest();
+  const T kMax = std::numeric_limits<T>::max();
+  std::vector<T> column(100, 0);
+  column[0] = kMin;
+  column[99] = kMax;
+  std::vector<uint64> bitmap(scan_bitmap_words(column.size()));
+  scan_between(column.data(), column.size(), kMin, kMin, bitmap.data());
+  EXPECT_EQ(1u, bitmap[0]);
+  EXPECT_EQ(0u, bitmap[1]);
+  scan_between(column.data(), column.size(), 1, kMax, bitmap.data());
+  EXPECT_EQ(0u, bitmap[0]);
+  EXPECT_EQ(uint64{1} << 35, bitmap[1]);
+  // An empty range.
+  scan_between(column.data(), column.size(), 1, 0, bitmap.data());
+  EXPECT_EQ(0u, bitmap[0] | bitmap[1]);
+}
+
+// NaN rows and NaN constants match nothing, like the scalar comparisons.
+template <typename T>
+void TestNaN() {
+  const T kNaN = std::numeric_limits<T>::quiet_NaN();
+  const T kInf = std::numeric_limits<T>::infinity();
+  std::vector<T> column(100, 1);
+  column[5] = kNaN;
+  column[70] = -kNaN;
+  // All rows but the NaNs.
+  const uint64 numbers[] = {~(uint64{1} << 5),
+                            (uint64{1} << 36) - 1 - (uint64{1} << 6)};
+  std::vector<uint64> bitmap(scan_bitmap_words(column.size()));
+  scan_between(column.data(), column.size(), -kInf, kInf, bitmap.data());
+  EXPECT_EQ(numbers[0], bitmap[0]);
+  EXPECT_EQ(numbers[1], bitmap[1]);
+  scan_equal(column.data(), column.size(), T(1), bitmap.data());
+  EXPECT_EQ(numbers[0], bitmap[0]);
+  EXPECT_EQ(numbers[1], bitmap[1]);
+  scan_equal(column.data(), column.size(), kNaN, bitmap.data());
+  EXPECT_EQ(0u, bitmap[0] | bitmap[1]);
+  scan_between(column.data(), column.size(), kNaN, kInf, bitmap.data());
+  EXPECT_EQ(0u, bitmap[0] | bitmap[1]);
+  const T values[] = {kNaN, 2};
+  scan_in(column.data(), column.size(), values, 2, bitmap.data());
+  EXPECT_EQ(0u, bitmap[0] | bitmap[1]);
+}
+
+TEST(ScanTest, NaN) {
+  TestNaN<float>();
+  TestNaN<double>();
+}
+
+TEST(ScanTest, Combine) {
+  std::mt19937 gen(0);
+  const size_t n = 1000;
+  std::vector<int32> a = RandomColumn<int32>(n, &gen);
+  std::vector<double> b = RandomColumn<double>(n, &gen);
+  std::vector<int64> c = RandomColumn<int64>(n, &gen);
+  std::vector<uint64> bitmap(scan_bitmap_words(n));
+
+  // a BETWEEN 3 AND 9 AND b = 4
+  scan_between(a.data(), n, 3, 9, bitmap.data());
+  scan_equal(b.data(), n, 4, bitmap.data(), ScanCombine::kAnd);
+  EXPECT_EQ(ScalarBitmap(n,
+                         [&](size_t i) {
+                           return 3 <= a[i] && a[i] <= 9 && b[i] == 4;
+                         }),
+            bitmap);
+
+  // ... OR c IN (0, 15)
+  const int64 values[] = {0, 15};
+  scan_in(c.data(), n, values, 2, bitmap.data(), ScanCombine::kOr);
+  EXPECT_EQ(ScalarBitmap(n,
+                         [&](size_t i) {
+                           return (3 <= a[i] && a[i] <= 9 && b[i] == 4) ||
+                                  c[i] == 0 || c[i] == 15;
+                         }),
+            bitmap);
+}
+
+TEST(ScanTest, BitmapToSelection) {
+  std::mt19937 gen(0);
+  for (size_t n : {0, 1, 64, 100, 1000}) {
+    for (uint32 density : {0, 1, 4, 12, 16}) {
+      SCOPED_TRACE(testing::Message() << n << " " << density);
+      std::vector<uint64> bitmap(scan_bitmap_words(n));
+      std::vector<uint32> expected;
+      for (size_t i = 0; i < n; i++) {
+        if (gen() % 16 < density) {
+          bitmap[i / 64] |= uint64{1} << i % 64;
+          expected.push_back(i);
+        }
+      }
+      // Bits past n are ignored.
+      if (n % 64 != 0) bitmap.back() |= ~uint64{0} << n % 64;
+      std::vector<uint32> selection(n);
+      selection.resize(
+          bitmap_to_selection(bitmap.data(), n, selection.data()));
+      EXPECT_EQ(expected, selection);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
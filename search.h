@@ -0,0 +1,268 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_SEARCH_H_
+#define DIMSUM_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <type_traits>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Byte search primitives over memory buffers: memchr-like find_byte, a
+// find_any_of over a compile-time set of bytes, and count_byte.
+//
+// Buffers are scanned in NativeSimd<uint8> blocks. The first block is loaded
+// unaligned, the body with vector-aligned loads, and the last partial block is
+// re-read so that it ends at the end of the buffer. No byte outside of
+// [data, data + size) is ever read.
+
+namespace dimsum {
+namespace detail {
+
+inline int CountTrailingZeros(uint32 mask) { return __builtin_ctz(mask); }
+
+inline int CountTrailingZeros(uint64 mask) { return __builtin_ctzll(mask); }
+
+}  // namespace detail
+
+// Iterates over the indices of set bits in mask, from the least significant
+// bit. The mask is usually produced by x86::movemask, so the indices are lane
+// numbers:
+//   for (int i : BitmaskIterator<uint32>(match_byte(block, ','))) { ... }
+template <typename Mask>
+class BitmaskIterator {
+  static_assert(std::is_unsigned<Mask>::value, "Mask must be unsigned");
+
+ public:
+  explicit BitmaskIterator(Mask mask) : mask_(mask) {}
+
+  BitmaskIterator begin() const { return *this; }
+  BitmaskIterator end() const { return BitmaskIterator(0); }
+
+  int operator*() const { return detail::CountTrailingZeros(mask_); }
+
+  BitmaskIterator& operator++() {
+    mask_ &= mask_ - 1;
+    return *this;
+  }
+
+  bool operator!=(const BitmaskIterator& other) const {
+    return mask_ != other.mask_;
+  }
+
+ private:
+  Mask mask_;
+};
+
+// The unit of work of all search functions. Bit i of a block mask corresponds
+// to byte i of the block.
+using SearchBlock = NativeSimd<uint8>;
+
+static_assert(SearchBlock::size() <= 32, "Block masks must fit in uint32");
+
+// Returns the mask of bytes in block that are equal to c.
+inline uint32 match_byte(SearchBlock block, char c) {
+  return x86::movemask(cmp_eq(block, SearchBlock(static_cast<uint8>(c))));
+}
+
+namespace detail {
+
+constexpr bool ContainsHighNibble(uint8) { return false; }
+
+template <typename... Rest>
+constexpr bool ContainsHighNibble(uint8 nibble, char c, Rest... rest) {
+  return static_cast<uint8>(c) >> 4 == nibble ||
+         ContainsHighNibble(nibble, rest...);
+}
+
+constexpr int CountHighNibbles() { return 0; }
+
+// Returns the number of distinct high nibbles among the arguments.
+template <typename... Rest>
+constexpr int CountHighNibbles(char c, Rest... rest) {
+  return (ContainsHighNibble(static_cast<uint8>(c) >> 4, rest...) ? 0 : 1) +
+         CountHighNibbles(rest...);
+}
+
+template <bool kUseTables, char... kChars>
+class AnyOfClassifier;
+
+// Classifies bytes against a set of up to 8 distinct high nibbles with two
+// 16-entry tables: each distinct high nibble is assigned a bit, hi_table maps a
+// high nibble to its bit, and lo_table maps a low nibble to the bits of all
+// high nibbles it is paired with in the set. A byte is in the set iff
+// lo_table[byte & 0xf] & hi_table[byte >> 4] is non-zero.
+template <char... kChars>
+class AnyOfClassifier<true, kChars...> {
+ public:
+  AnyOfClassifier() {
+    const uint8 set[] = {static_cast<uint8>(kChars)...};
+    uint8 lo[16] = {}, hi[16] = {};
+    int num_groups = 0;
+    for (uint8 c : set) {
+      if (hi[c >> 4] == 0) hi[c >> 4] = 1 << num_groups++;
+      lo[c & 0xf] |= hi[c >> 4];
+    }
+    lo_table_ = BroadcastNibbleTable(lo);
+    hi_table_ = BroadcastNibbleTable(hi);
+  }
+
+  uint32 operator()(SearchBlock block) const {
+    SearchBlock lo_nibbles = block & SearchBlock(0x0f);
+    SearchBlock hi_nibbles = HighNibbles(block);
+    SearchBlock hits =
+        lookup(lo_table_, lo_nibbles) & lookup(hi_table_, hi_nibbles);
+    return x86::movemask(cmp_ne(hits, SearchBlock(0)));
+  }
+
+ private:
+  SearchBlock lo_table_;
+  SearchBlock hi_table_;
+};
+
+// Sets with more than 8 distinct high nibbles fall back to one cmp_eq per
+// member.
+template <char... kChars>
+class AnyOfClassifier<false, kChars...> {
+ public:
+  uint32 operator()(SearchBlock block) const {
+    const uint8 set[] = {static_cast<uint8>(kChars)...};
+    SearchBlock hits = 0;
+    for (uint8 c : set) {
+      hits |= cmp_eq(block, SearchBlock(c));
+    }
+    return x86::movemask(hits);
+  }
+};
+
+template <char... kChars>
+using AnyOf = AnyOfClassifier<CountHighNibbles(kChars...) <= 8, kChars...>;
+
+template <char... kChars>
+const AnyOf<kChars...>& GetAnyOfClassifier() {
+  static const AnyOf<kChars...> classifier;
+  return classifier;
+}
+
+// Calls visit(block_start, mask) on consecutive blocks covering
+// [data, data + size), where mask = classify(block) restricted to the bytes
+// not reported before. Every byte is reported exactly once, in address order.
+// Stops as soon as visit returns false.
+template <typename Classify, typename Visit>
+void ScanBlocks(const char* data, size_t size, const Classify& classify,
+                Visit&& visit) {
+  constexpr size_t kBlock = SearchBlock::size();
+  auto load = [](const char* p) {
+    return SearchBlock(reinterpret_cast<const uint8*>(p),
+                       flags::element_aligned);
+  };
+  auto load_aligned = [](const char* p) {
+    return SearchBlock(reinterpret_cast<const uint8*>(p),
+                       flags::vector_aligned);
+  };
+
+  if (size < kBlock) {
+    uint8 buffer[kBlock] = {};
+    if (size > 0) memcpy(buffer, data, size);
+    visit(data, classify(SearchBlock(buffer, flags::element_aligned)) &
+                    ((uint32{1} << size) - 1));
+    return;
+  }
+
+  const char* end = data + size;
+  if (!visit(data, classify(load(data)))) return;
+
+  // [data, done) has been reported. p is the first aligned block that is not
+  // fully covered by the head block.
+  const char* done = data + kBlock;
+  const char* p = reinterpret_cast<const char*>(
+      reinterpret_cast<uintptr_t>(done) & ~uintptr_t{kBlock - 1});
+  if (p + kBlock <= end) {
+    if (!visit(p, classify(load_aligned(p)) & (~uint32{0} << (done - p)))) {
+      return;
+    }
+    for (p += kBlock; p + kBlock <= end; p += kBlock) {
+      if (!visit(p, classify(load_aligned(p)))) return;
+    }
+    done = p;
+  }
+  if (done < end) {
+    const char* tail = end - kBlock;
+    visit(tail, classify(load(tail)) & (~uint32{0} << (done - tail)));
+  }
+}
+
+template <typename Classify>
+const char* FindFirst(const char* data, size_t size, const Classify& classify) {
+  const char* found = nullptr;
+  ScanBlocks(data, size, classify, [&found](const char* block, uint32 mask) {
+    if (mask == 0) return true;
+    found = block + CountTrailingZeros(mask);
+    return false;
+  });
+  return found;
+}
+
+}  // namespace detail
+
+// Returns the mask of bytes in block that are any of kChars.
+template <char... kChars>
+uint32 match_any_of(SearchBlock block) {
+  return detail::GetAnyOfClassifier<kChars...>()(block);
+}
+
+// Returns a pointer to the first byte in [data, data + size) that is equal to
+// c, or nullptr if there is none. Same as memchr.
+inline const char* find_byte(const char* data, size_t size, char c) {
+  const SearchBlock needle(static_cast<uint8>(c));
+  return detail::FindFirst(data, size, [needle](SearchBlock block) -> uint32 {
+    return x86::movemask(cmp_eq(block, needle));
+  });
+}
+
+// Returns a pointer to the first byte in [data, data + size) that is any of
+// kChars, or nullptr if there is none.
+//
+// Example: find_any_of<'\n', ',', '"', '\\'>(line, size).
+template <char... kChars>
+const char* find_any_of(const char* data, size_t size) {
+  static_assert(sizeof...(kChars) > 0, "The set must not be empty");
+  return detail::FindFirst(data, size, detail::GetAnyOfClassifier<kChars...>());
+}
+
+// Returns the number of bytes in [data, data + size) that are equal to c.
+inline size_t count_byte(const char* data, size_t size, char c) {
+  const SearchBlock needle(static_cast<uint8>(c));
+  size_t count = 0;
+  detail::ScanBlocks(data, size,
+                     [needle](SearchBlock block) -> uint32 {
+                       return x86::movemask(cmp_eq(block, needle));
+                     },
+                     [&count](const char*, uint32 mask) {
+                       count += __builtin_popcount(mask);
+                       return true;
+                     });
+  return count;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_SEARCH_H_
@@ -0,0 +1,89 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "search.h"
+
+namespace dimsum {
+namespace {
+
+// A buffer of state.range(0) bytes with no match but the last byte, so that
+// every function scans the whole buffer.
+std::string MakeBuffer(const benchmark::State& state, char last) {
+  std::string buffer(state.range(0), 'x');
+  buffer.back() = last;
+  return buffer;
+}
+
+void BM_Memchr(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\n');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(memchr(buffer.data(), '\n', buffer.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_Memchr)->Range(16, 1 << 20);
+
+void BM_FindByte(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\n');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(find_byte(buffer.data(), buffer.size(), '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_FindByte)->Range(16, 1 << 20);
+
+void BM_Strpbrk(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\\');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strpbrk(buffer.c_str(), "\n,\"\\"));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_Strpbrk)->Range(16, 1 << 20);
+
+void BM_FindAnyOf(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\\');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        find_any_of<'\n', ',', '"', '\\'>(buffer.data(), buffer.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_FindAnyOf)->Range(16, 1 << 20);
+
+void BM_StdCount(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\n');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::count(buffer.begin(), buffer.end(), '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_StdCount)->Range(16, 1 << 20);
+
+void BM_CountByte(benchmark::State& state) {
+  std::string buffer = MakeBuffer(state, '\n');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(count_byte(buffer.data(), buffer.size(), '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_CountByte)->Range(16, 1 << 20);
+
+}  // namespace
+}  // namespace dimsum
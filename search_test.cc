@@ -0,0 +1,139 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Returns a buffer of size bytes drawn from alphabet.
+std::string RandomBuffer(size_t size, const std::string& alphabet,
+                         std::mt19937* gen) {
+  std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+  std::string ret(size, '\0');
+  for (auto& c : ret) c = alphabet[dist(*gen)];
+  return ret;
+}
+
+const char* ScalarFindAnyOf(const char* data, size_t size, const char* set) {
+  for (size_t i = 0; i < size; i++) {
+    if (memchr(set, data[i], strlen(set)) != nullptr) return data + i;
+  }
+  return nullptr;
+}
+
+TEST(SearchTest, BitmaskIterator) {
+  std::vector<int> indices;
+  for (int i : BitmaskIterator<uint32>(0x80000005u)) indices.push_back(i);
+  EXPECT_EQ((std::vector<int>{0, 2, 31}), indices);
+
+  indices.clear();
+  for (int i : BitmaskIterator<uint64>(1ull << 63)) indices.push_back(i);
+  EXPECT_EQ(std::vector<int>{63}, indices);
+
+  for (int i : BitmaskIterator<uint32>(0)) ADD_FAILURE() << i;
+}
+
+TEST(SearchTest, MatchByte) {
+  uint8 bytes[SearchBlock::size()] = {};
+  bytes[1] = ',';
+  bytes[SearchBlock::size() - 1] = ',';
+  auto block = SearchBlock(bytes, flags::element_aligned);
+  EXPECT_EQ((1u << 1) | (1u << (SearchBlock::size() - 1)),
+            match_byte(block, ','));
+  EXPECT_EQ(0u, match_byte(block, '\n'));
+}
+
+TEST(SearchTest, FindByte) {
+  std::mt19937 gen(42);
+  for (size_t size = 0; size < 200; size++) {
+    // Over-allocate so that every start alignment is exercised.
+    std::string buffer = RandomBuffer(size + 64, "abcdefgh\xff", &gen);
+    for (size_t offset = 0; offset < 33; offset++) {
+      const char* data = buffer.data() + offset;
+      for (char c : {'a', 'h', 'z', '\xff'}) {
+        EXPECT_EQ(memchr(data, c, size), find_byte(data, size, c))
+            << size << " " << offset << " " << c;
+      }
+    }
+  }
+}
+
+TEST(SearchTest, FindByteLastPosition) {
+  for (size_t size = 1; size < 100; size++) {
+    std::string buffer(size, 'a');
+    buffer.back() = 'b';
+    EXPECT_EQ(buffer.data() + size - 1, find_byte(buffer.data(), size, 'b'));
+    EXPECT_EQ(nullptr, find_byte(buffer.data(), size - 1, 'b'));
+  }
+}
+
+TEST(SearchTest, CountByte) {
+  std::mt19937 gen(42);
+  for (size_t size = 0; size < 200; size++) {
+    std::string buffer = RandomBuffer(size + 64, "ab", &gen);
+    for (size_t offset = 0; offset < 33; offset++) {
+      const char* data = buffer.data() + offset;
+      EXPECT_EQ(static_cast<size_t>(std::count(data, data + size, 'a')),
+                count_byte(data, size, 'a'))
+          << size << " " << offset;
+    }
+  }
+}
+
+TEST(SearchTest, FindAnyOf) {
+  std::mt19937 gen(42);
+  for (size_t size = 0; size < 200; size++) {
+    std::string buffer =
+        RandomBuffer(size + 64, "abcdefghijklmnop\n,\"\\", &gen);
+    for (size_t offset = 0; offset < 33; offset++) {
+      const char* data = buffer.data() + offset;
+      EXPECT_EQ(ScalarFindAnyOf(data, size, "\n,\"\\"),
+                (find_any_of<'\n', ',', '"', '\\'>(data, size)))
+          << size << " " << offset;
+      EXPECT_EQ(ScalarFindAnyOf(data, size, "p"),
+                (find_any_of<'p'>(data, size)))
+          << size << " " << offset;
+    }
+  }
+}
+
+TEST(SearchTest, FindAnyOfAllNibbles) {
+  // Every byte value with the same low nibble, with 16 distinct high nibbles,
+  // which does not fit into the nibble tables.
+  std::string buffer;
+  for (int i = 0; i < 256; i++) buffer.push_back(static_cast<char>(i));
+  for (int i = 0; i < 16; i++) {
+    const char* data = buffer.data() + i * 16 + 4;
+    EXPECT_EQ(data + 3,
+              (find_any_of<'\x07', '\x17', '\x27', '\x37', '\x47', '\x57',
+                           '\x67', '\x77', '\x87', '\x97', '\xa7', '\xb7',
+                           '\xc7', '\xd7', '\xe7', '\xf7'>(data, 12)));
+  }
+  // Bytes that share low nibbles with members, but not high nibbles.
+  EXPECT_EQ(buffer.data() + 0x27,
+            (find_any_of<'\x27', '\x38'>(buffer.data(), buffer.size())));
+  EXPECT_EQ(nullptr, (find_any_of<'\x27', '\x38'>(buffer.data(), 0x27)));
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -66,6 +66,116 @@ inline Simd256<double> abs(Simd256<double> simd) {
                           Simd256<uint64>(~(1ull << 63)));
 }
 
+// vpshufb looks up each 128-bit lane separately, which is what lookup()
+// promises.
+template <>
+inline Simd256<uint8> lookup(Simd256<uint8> table, Simd256<uint8> indices) {
+  return _mm256_shuffle_epi8(to_raw(table), to_raw(indices));
+}
+
+// Unsigned comparisons, as for Simd128 objects in simd_sse.h.
+#ifdef __AVX2__
+template <>
+inline Simd256<uint8> cmp_le(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(to_raw(lhs), to_raw(rhs)),
+                          to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint8> cmp_ge(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return _mm256_cmpeq_epi8(_mm256_max_epu8(to_raw(lhs), to_raw(rhs)),
+                          to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint8> cmp_lt(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint8> cmp_gt(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint16> cmp_le(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return _mm256_cmpeq_epi16(_mm256_min_epu16(to_raw(lhs), to_raw(rhs)),
+                           to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint16> cmp_ge(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return _mm256_cmpeq_epi16(_mm256_max_epu16(to_raw(lhs), to_raw(rhs)),
+                           to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint16> cmp_lt(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint16> cmp_gt(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint32> cmp_le(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return _mm256_cmpeq_epi32(_mm256_min_epu32(to_raw(lhs), to_raw(rhs)),
+                           to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint32> cmp_ge(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return _mm256_cmpeq_epi32(_mm256_max_epu32(to_raw(lhs), to_raw(rhs)),
+                           to_raw(lhs));
+}
+
+template <>
+inline Simd256<uint32> cmp_lt(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint32> cmp_gt(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+
+// uint64 elements compare as signed with their sign bits flipped. AVX-512 has
+// unsigned comparisons, which compilers use instead.
+#ifndef __AVX512VL__
+namespace detail {
+
+inline __m256i FlipSignBits(Simd256<uint64> simd) {
+  return _mm256_xor_si256(to_raw(simd), _mm256_set1_epi64x(INT64_MIN));
+}
+
+}  // namespace detail
+
+template <>
+inline Simd256<uint64> cmp_gt(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return _mm256_cmpgt_epi64(detail::FlipSignBits(lhs),
+                            detail::FlipSignBits(rhs));
+}
+
+template <>
+inline Simd256<uint64> cmp_lt(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return _mm256_cmpgt_epi64(detail::FlipSignBits(rhs),
+                            detail::FlipSignBits(lhs));
+}
+
+template <>
+inline Simd256<uint64> cmp_ge(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return ~cmp_lt(lhs, rhs);
+}
+
+template <>
+inline Simd256<uint64> cmp_le(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return ~cmp_gt(lhs, rhs);
+}
+#endif  // __AVX512VL__
+#endif  // __AVX2__
+
 template <>
 inline Simd256<float> reciprocal_estimate(Simd256<float> simd) {
   return _mm256_rcp_ps(to_raw(simd));
@@ -176,11 +286,321 @@ inline Simd256<int32> round_to_integer(Simd256<float> simd) {
   return _mm256_cvtps_epi32(to_raw(simd));
 }
 
+// Conversions between element types; see detail::StaticSimdCast. Widening
+// converts Simd128 to Simd256 and narrowing Simd256 to Simd128.
+namespace detail {
+
+#ifdef __AVX2__
+template <>
+inline Simd256<int16> ConvertElements<int16>(Simd128<int8> simd) {
+  return _mm256_cvtepi8_epi16(to_raw(simd));
+}
+
+template <>
+inline Simd256<uint16> ConvertElements<uint16>(Simd128<uint8> simd) {
+  return _mm256_cvtepu8_epi16(to_raw(simd));
+}
+
+template <>
+inline Simd256<int32> ConvertElements<int32>(Simd128<int16> simd) {
+  return _mm256_cvtepi16_epi32(to_raw(simd));
+}
+
+template <>
+inline Simd256<uint32> ConvertElements<uint32>(Simd128<uint16> simd) {
+  return _mm256_cvtepu16_epi32(to_raw(simd));
+}
+
+template <>
+inline Simd256<int64> ConvertElements<int64>(Simd128<int32> simd) {
+  return _mm256_cvtepi32_epi64(to_raw(simd));
+}
+
+template <>
+inline Simd256<uint64> ConvertElements<uint64>(Simd128<uint32> simd) {
+  return _mm256_cvtepu32_epi64(to_raw(simd));
+}
+
+// Clears the high half of each element, so that the saturating pack of the two
+// 128-bit halves truncates.
+template <>
+inline Simd128<uint8> ConvertElements<uint8>(Simd256<uint16> simd) {
+  const __m256i low_bytes =
+      _mm256_and_si256(to_raw(simd), _mm256_set1_epi16(0xff));
+  return _mm_packus_epi16(_mm256_castsi256_si128(low_bytes),
+                          _mm256_extracti128_si256(low_bytes, 1));
+}
+
+template <>
+inline Simd128<uint16> ConvertElements<uint16>(Simd256<uint32> simd) {
+  const __m256i low_halves =
+      _mm256_and_si256(to_raw(simd), _mm256_set1_epi32(0xffff));
+  return _mm_packus_epi32(_mm256_castsi256_si128(low_halves),
+                          _mm256_extracti128_si256(low_halves, 1));
+}
+#endif  // __AVX2__
+
+template <>
+inline Simd128<uint32> ConvertElements<uint32>(Simd256<uint64> simd) {
+  const __m256 raw = _mm256_castsi256_ps(to_raw(simd));
+  return _mm_castps_si128(_mm_shuffle_ps(_mm256_castps256_ps128(raw),
+                                         _mm256_extractf128_ps(raw, 1),
+                                         _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+template <>
+inline Simd256<float> ConvertElements<float>(Simd256<int32> simd) {
+  return _mm256_cvtepi32_ps(to_raw(simd));
+}
+
+template <>
+inline Simd256<int32> ConvertElements<int32>(Simd256<float> simd) {
+  return _mm256_cvttps_epi32(to_raw(simd));
+}
+
+#ifdef __AVX512VL__
+template <>
+inline Simd256<float> ConvertElements<float>(Simd256<uint32> simd) {
+  return _mm256_cvtepu32_ps(to_raw(simd));
+}
+#elif defined(__AVX2__)
+// See the Simd128 version.
+template <>
+inline Simd256<float> ConvertElements<float>(Simd256<uint32> simd) {
+  const __m256i raw = to_raw(simd);
+  const __m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(raw, 16));
+  const __m256 low = _mm256_cvtepi32_ps(
+      _mm256_blend_epi16(raw, _mm256_setzero_si256(), 0xaa));
+  return _mm256_add_ps(_mm256_mul_ps(high, _mm256_set1_ps(65536.f)), low);
+}
+#endif
+
+#if defined(__AVX512DQ__) && defined(__AVX512VL__)
+template <>
+inline Simd256<double> ConvertElements<double>(Simd256<int64> simd) {
+  return _mm256_cvtepi64_pd(to_raw(simd));
+}
+
+template <>
+inline Simd256<int64> ConvertElements<int64>(Simd256<double> simd) {
+  return _mm256_cvttpd_epi64(to_raw(simd));
+}
+#elif defined(__AVX2__)
+// See the Simd128 version.
+template <>
+inline Simd256<double> ConvertElements<double>(Simd256<int64> simd) {
+  const __m256i raw = to_raw(simd);
+  __m256i high = _mm256_blend_epi16(_mm256_srai_epi32(raw, 16),
+                                    _mm256_setzero_si256(), 0x33);
+  high = _mm256_add_epi64(high, _mm256_castpd_si256(_mm256_set1_pd(0x1.8p68)));
+  const __m256i low = _mm256_blend_epi16(
+      raw, _mm256_castpd_si256(_mm256_set1_pd(0x1p52)), 0x88);
+  const __m256d high_minus_2_52 = _mm256_sub_pd(
+      _mm256_castsi256_pd(high), _mm256_set1_pd(0x1.8p68 + 0x1p52));
+  return _mm256_add_pd(high_minus_2_52, _mm256_castsi256_pd(low));
+}
+#endif
+
+}  // namespace detail
+
 template <typename T>
 Simd256<ScaleBy<T, 2>> mul_widened(Simd128<T> lhs, Simd128<T> rhs) {
   return simd_cast<ScaleBy<T, 2>>(lhs) * simd_cast<ScaleBy<T, 2>>(rhs);
 }
 
+#ifdef __AVX2__
+template <>
+inline Simd256<uint64> mul_widened(Simd128<uint32> lhs, Simd128<uint32> rhs) {
+  return _mm256_mul_epu32(to_raw(simd_cast<uint64>(lhs)),
+                          to_raw(simd_cast<uint64>(rhs)));
+}
+
+template <>
+inline Simd256<int64> mul_widened(Simd128<int32> lhs, Simd128<int32> rhs) {
+  return _mm256_mul_epi32(to_raw(simd_cast<int64>(lhs)),
+                          to_raw(simd_cast<int64>(rhs)));
+}
+#endif
+
+#ifdef __AVX2__
+namespace detail {
+
+inline __m128i LoadLow64Bits(const void* p) {
+  return _mm_loadl_epi64(static_cast<const __m128i*>(p));
+}
+
+inline __m128i Load128Bits(const void* p) {
+  return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+
+// Packs the int32 elements of simd into int16 with signed saturation, keeping
+// the order; see the comment at the top.
+inline __m128i PackInt32(__m256i simd) {
+  return _mm_packs_epi32(_mm256_castsi256_si128(simd),
+                         _mm256_extracti128_si256(simd, 1));
+}
+
+// See the Simd128 version.
+inline __m256i TruncateClamped(Simd256<float> simd, float max) {
+  return _mm256_cvttps_epi32(_mm256_min_ps(to_raw(simd), _mm256_set1_ps(max)));
+}
+
+}  // namespace detail
+
+template <>
+inline Simd256<int32> load_converted<Simd256<int32>>(const int8* p) {
+  return _mm256_cvtepi8_epi32(detail::LoadLow64Bits(p));
+}
+
+template <>
+inline Simd256<int32> load_converted<Simd256<int32>>(const uint8* p) {
+  return _mm256_cvtepu8_epi32(detail::LoadLow64Bits(p));
+}
+
+template <>
+inline Simd256<int32> load_converted<Simd256<int32>>(const int16* p) {
+  return _mm256_cvtepi16_epi32(detail::Load128Bits(p));
+}
+
+template <>
+inline Simd256<int32> load_converted<Simd256<int32>>(const uint16* p) {
+  return _mm256_cvtepu16_epi32(detail::Load128Bits(p));
+}
+
+template <>
+inline Simd256<int16> load_converted<Simd256<int16>>(const int8* p) {
+  return _mm256_cvtepi8_epi16(detail::Load128Bits(p));
+}
+
+template <>
+inline Simd256<int16> load_converted<Simd256<int16>>(const uint8* p) {
+  return _mm256_cvtepu8_epi16(detail::Load128Bits(p));
+}
+
+template <>
+inline Simd256<uint16> load_converted<Simd256<uint16>>(const uint8* p) {
+  return _mm256_cvtepu8_epi16(detail::Load128Bits(p));
+}
+
+template <>
+inline Simd256<float> load_converted<Simd256<float>>(const int8* p) {
+  return _mm256_cvtepi32_ps(to_raw(load_converted<Simd256<int32>>(p)));
+}
+
+template <>
+inline Simd256<float> load_converted<Simd256<float>>(const uint8* p) {
+  return _mm256_cvtepi32_ps(to_raw(load_converted<Simd256<int32>>(p)));
+}
+
+template <>
+inline Simd256<float> load_converted<Simd256<float>>(const int16* p) {
+  return _mm256_cvtepi32_ps(to_raw(load_converted<Simd256<int32>>(p)));
+}
+
+template <>
+inline Simd256<float> load_converted<Simd256<float>>(const uint16* p) {
+  return _mm256_cvtepi32_ps(to_raw(load_converted<Simd256<int32>>(p)));
+}
+
+template <>
+inline Simd256<float> load_converted<Simd256<float>>(const int32* p) {
+  return _mm256_cvtepi32_ps(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+template <>
+inline void store_saturated(Simd256<int32> simd, int16* p) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                   detail::PackInt32(to_raw(simd)));
+}
+
+template <>
+inline void store_saturated(Simd256<int32> simd, uint16* p) {
+  __m256i raw = to_raw(simd);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                   _mm_packus_epi32(_mm256_castsi256_si128(raw),
+                                    _mm256_extracti128_si256(raw, 1)));
+}
+
+// See the Simd128 version.
+template <>
+inline void store_saturated(Simd256<int32> simd, int8* p) {
+  __m128i int16s = detail::PackInt32(to_raw(simd));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(p),
+                   _mm_packs_epi16(int16s, int16s));
+}
+
+template <>
+inline void store_saturated(Simd256<int32> simd, uint8* p) {
+  __m128i int16s = detail::PackInt32(to_raw(simd));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(p),
+                   _mm_packus_epi16(int16s, int16s));
+}
+
+template <>
+inline void store_saturated(Simd256<int16> simd, int8* p) {
+  __m256i raw = to_raw(simd);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                   _mm_packs_epi16(_mm256_castsi256_si128(raw),
+                                   _mm256_extracti128_si256(raw, 1)));
+}
+
+template <>
+inline void store_saturated(Simd256<int16> simd, uint8* p) {
+  __m256i raw = to_raw(simd);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                   _mm_packus_epi16(_mm256_castsi256_si128(raw),
+                                    _mm256_extracti128_si256(raw, 1)));
+}
+
+template <>
+inline void store_saturated(Simd256<float> simd, int16* p) {
+  store_saturated(Simd256<int32>(detail::TruncateClamped(simd, 32767)), p);
+}
+
+template <>
+inline void store_saturated(Simd256<float> simd, uint16* p) {
+  store_saturated(Simd256<int32>(detail::TruncateClamped(simd, 65535)), p);
+}
+
+template <>
+inline void store_saturated(Simd256<float> simd, int8* p) {
+  store_saturated(Simd256<int32>(detail::TruncateClamped(simd, 127)), p);
+}
+
+template <>
+inline void store_saturated(Simd256<float> simd, uint8* p) {
+  store_saturated(Simd256<int32>(detail::TruncateClamped(simd, 255)), p);
+}
+
+// See the Simd128 version.
+template <>
+inline void store_converted(Simd256<float> simd, int32* p) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                      _mm256_cvttps_epi32(to_raw(simd)));
+}
+
+template <>
+inline void store_converted(Simd256<float> simd, int16* p) {
+  store_saturated(Simd256<int32>(_mm256_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd256<float> simd, uint16* p) {
+  store_saturated(Simd256<int32>(_mm256_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd256<float> simd, int8* p) {
+  store_saturated(Simd256<int32>(_mm256_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd256<float> simd, uint8* p) {
+  store_saturated(Simd256<int32>(_mm256_cvttps_epi32(to_raw(simd))), p);
+}
+#endif  // __AVX2__
+
 }  // namespace dimsum
 
 #endif  // __AVX__
@@ -56,6 +56,232 @@ inline Simd128<int64> abs(Simd128<int64> simd) {
 }
 #endif
 
+// SSE4.2 adds pcmpgtq; before it, compilers compare int64 elements one at a
+// time in general purpose registers.
+#if defined(__SSE4_1__) && !defined(__SSE4_2__)
+namespace detail {
+
+// Returns ~0 in the elements where lhs > rhs. The high halves are compared as
+// signed and the low halves, with their sign bits flipped, as unsigned; the
+// latter only decide the elements whose high halves are equal.
+inline __m128i CmpGtInt64(__m128i lhs, __m128i rhs) {
+  const __m128i flip_low = _mm_set_epi32(0, INT32_MIN, 0, INT32_MIN);
+  lhs = _mm_xor_si128(lhs, flip_low);
+  rhs = _mm_xor_si128(rhs, flip_low);
+  const __m128i gt = _mm_cmpgt_epi32(lhs, rhs);
+  const __m128i low_gt_if_high_eq =
+      _mm_and_si128(_mm_cmpeq_epi32(lhs, rhs), _mm_slli_epi64(gt, 32));
+  return _mm_shuffle_epi32(_mm_or_si128(gt, low_gt_if_high_eq),
+                           _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+}  // namespace detail
+
+template <>
+inline Simd128<uint64> cmp_gt(Simd128<int64> lhs, Simd128<int64> rhs) {
+  return detail::CmpGtInt64(to_raw(lhs), to_raw(rhs));
+}
+
+template <>
+inline Simd128<uint64> cmp_lt(Simd128<int64> lhs, Simd128<int64> rhs) {
+  return detail::CmpGtInt64(to_raw(rhs), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint64> cmp_ge(Simd128<int64> lhs, Simd128<int64> rhs) {
+  return ~cmp_lt(lhs, rhs);
+}
+
+template <>
+inline Simd128<uint64> cmp_le(Simd128<int64> lhs, Simd128<int64> rhs) {
+  return ~cmp_gt(lhs, rhs);
+}
+#endif
+
+// x86 only compares signed integers. Unsigned elements are less or equal
+// exactly when they equal the minimum of both operands. There is no such
+// minimum of uint64 elements before AVX-512; compilers already compare them as
+// signed with their sign bits flipped.
+template <>
+inline Simd128<uint8> cmp_le(Simd128<uint8> lhs, Simd128<uint8> rhs) {
+  return _mm_cmpeq_epi8(_mm_min_epu8(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint8> cmp_ge(Simd128<uint8> lhs, Simd128<uint8> rhs) {
+  return _mm_cmpeq_epi8(_mm_max_epu8(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint8> cmp_lt(Simd128<uint8> lhs, Simd128<uint8> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd128<uint8> cmp_gt(Simd128<uint8> lhs, Simd128<uint8> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+
+#ifdef __SSE4_1__
+template <>
+inline Simd128<uint16> cmp_le(Simd128<uint16> lhs, Simd128<uint16> rhs) {
+  return _mm_cmpeq_epi16(_mm_min_epu16(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint16> cmp_ge(Simd128<uint16> lhs, Simd128<uint16> rhs) {
+  return _mm_cmpeq_epi16(_mm_max_epu16(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint16> cmp_lt(Simd128<uint16> lhs, Simd128<uint16> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd128<uint16> cmp_gt(Simd128<uint16> lhs, Simd128<uint16> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+
+template <>
+inline Simd128<uint32> cmp_le(Simd128<uint32> lhs, Simd128<uint32> rhs) {
+  return _mm_cmpeq_epi32(_mm_min_epu32(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint32> cmp_ge(Simd128<uint32> lhs, Simd128<uint32> rhs) {
+  return _mm_cmpeq_epi32(_mm_max_epu32(to_raw(lhs), to_raw(rhs)), to_raw(lhs));
+}
+
+template <>
+inline Simd128<uint32> cmp_lt(Simd128<uint32> lhs, Simd128<uint32> rhs) {
+  return ~cmp_ge(lhs, rhs);
+}
+
+template <>
+inline Simd128<uint32> cmp_gt(Simd128<uint32> lhs, Simd128<uint32> rhs) {
+  return ~cmp_le(lhs, rhs);
+}
+#endif  // __SSE4_1__
+
+// Without AVX2, compilers compare the elements of Simd256 objects one at a
+// time, so the halves are compared as Simd128 objects.
+#if defined(__SSE4_1__) && !defined(__AVX2__)
+namespace detail {
+
+template <typename T, typename Result = T>
+Simd256<Result> CompareHalves(
+    Simd256<T> lhs, Simd256<T> rhs,
+    Simd128<Result> (*compare)(Simd128<T>, Simd128<T>)) {
+  return Combine(compare(Half<0>(lhs), Half<0>(rhs)),
+                 compare(Half<1>(lhs), Half<1>(rhs)));
+}
+
+}  // namespace detail
+
+template <>
+inline Simd256<uint8> cmp_lt(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return detail::CompareHalves<uint8>(lhs, rhs, cmp_lt);
+}
+
+template <>
+inline Simd256<uint8> cmp_le(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return detail::CompareHalves<uint8>(lhs, rhs, cmp_le);
+}
+
+template <>
+inline Simd256<uint8> cmp_gt(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return detail::CompareHalves<uint8>(lhs, rhs, cmp_gt);
+}
+
+template <>
+inline Simd256<uint8> cmp_ge(Simd256<uint8> lhs, Simd256<uint8> rhs) {
+  return detail::CompareHalves<uint8>(lhs, rhs, cmp_ge);
+}
+
+template <>
+inline Simd256<uint16> cmp_lt(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return detail::CompareHalves<uint16>(lhs, rhs, cmp_lt);
+}
+
+template <>
+inline Simd256<uint16> cmp_le(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return detail::CompareHalves<uint16>(lhs, rhs, cmp_le);
+}
+
+template <>
+inline Simd256<uint16> cmp_gt(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return detail::CompareHalves<uint16>(lhs, rhs, cmp_gt);
+}
+
+template <>
+inline Simd256<uint16> cmp_ge(Simd256<uint16> lhs, Simd256<uint16> rhs) {
+  return detail::CompareHalves<uint16>(lhs, rhs, cmp_ge);
+}
+
+template <>
+inline Simd256<uint32> cmp_lt(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return detail::CompareHalves<uint32>(lhs, rhs, cmp_lt);
+}
+
+template <>
+inline Simd256<uint32> cmp_le(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return detail::CompareHalves<uint32>(lhs, rhs, cmp_le);
+}
+
+template <>
+inline Simd256<uint32> cmp_gt(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return detail::CompareHalves<uint32>(lhs, rhs, cmp_gt);
+}
+
+template <>
+inline Simd256<uint32> cmp_ge(Simd256<uint32> lhs, Simd256<uint32> rhs) {
+  return detail::CompareHalves<uint32>(lhs, rhs, cmp_ge);
+}
+
+#ifdef __SSE4_2__
+template <>
+inline Simd256<uint64> cmp_lt(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return detail::CompareHalves<uint64>(lhs, rhs, cmp_lt);
+}
+
+template <>
+inline Simd256<uint64> cmp_le(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return detail::CompareHalves<uint64>(lhs, rhs, cmp_le);
+}
+
+template <>
+inline Simd256<uint64> cmp_gt(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return detail::CompareHalves<uint64>(lhs, rhs, cmp_gt);
+}
+
+template <>
+inline Simd256<uint64> cmp_ge(Simd256<uint64> lhs, Simd256<uint64> rhs) {
+  return detail::CompareHalves<uint64>(lhs, rhs, cmp_ge);
+}
+#endif  // __SSE4_2__
+
+template <>
+inline Simd256<uint64> cmp_lt(Simd256<int64> lhs, Simd256<int64> rhs) {
+  return detail::CompareHalves<int64, uint64>(lhs, rhs, cmp_lt);
+}
+
+template <>
+inline Simd256<uint64> cmp_le(Simd256<int64> lhs, Simd256<int64> rhs) {
+  return detail::CompareHalves<int64, uint64>(lhs, rhs, cmp_le);
+}
+
+template <>
+inline Simd256<uint64> cmp_gt(Simd256<int64> lhs, Simd256<int64> rhs) {
+  return detail::CompareHalves<int64, uint64>(lhs, rhs, cmp_gt);
+}
+
+template <>
+inline Simd256<uint64> cmp_ge(Simd256<int64> lhs, Simd256<int64> rhs) {
+  return detail::CompareHalves<int64, uint64>(lhs, rhs, cmp_ge);
+}
+#endif  // defined(__SSE4_1__) && !defined(__AVX2__)
+
 // ::abs for floating points is implemented by bit_and each lane with shr(-1, 1)
 // to clear the sign bit (the most significant bit).
 template <>
@@ -69,6 +295,13 @@ inline Simd128<double> abs(Simd128<double> simd) {
                           Simd128<uint64>(~(1ull << 63)));
 }
 
+#ifdef __SSSE3__
+template <>
+inline Simd128<uint8> lookup(Simd128<uint8> table, Simd128<uint8> indices) {
+  return _mm_shuffle_epi8(to_raw(table), to_raw(indices));
+}
+#endif
+
 template <>
 inline Simd128<float> reciprocal_estimate(Simd128<float> simd) {
   return _mm_rcp_ps(to_raw(simd));
@@ -180,11 +413,473 @@ inline Simd128<int32> round_to_integer(Simd128<float> simd) {
   return _mm_cvtps_epi32(to_raw(simd));
 }
 
+// Conversions between element types; see detail::StaticSimdCast. Without AVX,
+// Simd256 objects are converted as two Simd128 halves.
+namespace detail {
+
+// Moves a Simd64 object into the low half of a register and back.
+template <typename T>
+Simd64<T> FromLow64Bits(__m128i raw) {
+  Simd64<T> simd;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&simd), raw);
+  return simd;
+}
+
+template <typename T>
+__m128i ToLow64Bits(Simd64<T> simd) {
+  return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&simd));
+}
+
+#ifdef __SSE4_1__
+template <>
+inline Simd128<int16> ConvertElements<int16>(Simd64<int8> simd) {
+  return _mm_cvtepi8_epi16(ToLow64Bits(simd));
+}
+
+template <>
+inline Simd128<uint16> ConvertElements<uint16>(Simd64<uint8> simd) {
+  return _mm_cvtepu8_epi16(ToLow64Bits(simd));
+}
+
+// Compilers turn these into a single pmovsx or pmovzx, while moving a Simd64
+// object into an __m128i for the intrinsics costs a movq.
+
+template <>
+inline Simd128<int32> ConvertElements<int32>(Simd64<int16> simd) {
+  return ConvertLanes<int32>(simd);
+}
+
+template <>
+inline Simd128<uint32> ConvertElements<uint32>(Simd64<uint16> simd) {
+  return ConvertLanes<uint32>(simd);
+}
+
+template <>
+inline Simd128<int64> ConvertElements<int64>(Simd64<int32> simd) {
+  return ConvertLanes<int64>(simd);
+}
+
+template <>
+inline Simd128<uint64> ConvertElements<uint64>(Simd64<uint32> simd) {
+  return ConvertLanes<uint64>(simd);
+}
+
+// pshufb gathers the low bytes of each element.
+template <>
+inline Simd64<uint8> ConvertElements<uint8>(Simd128<uint16> simd) {
+  return FromLow64Bits<uint8>(
+      _mm_shuffle_epi8(to_raw(simd), _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                   -1, -1, -1, -1, -1, -1, -1,
+                                                   -1)));
+}
+
+template <>
+inline Simd64<uint16> ConvertElements<uint16>(Simd128<uint32> simd) {
+  return FromLow64Bits<uint16>(
+      _mm_shuffle_epi8(to_raw(simd), _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                                   -1, -1, -1, -1, -1, -1, -1,
+                                                   -1)));
+}
+#endif  // __SSE4_1__
+
+template <>
+inline Simd64<uint32> ConvertElements<uint32>(Simd128<uint64> simd) {
+  return FromLow64Bits<uint32>(
+      _mm_shuffle_epi32(to_raw(simd), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+template <>
+inline Simd128<float> ConvertElements<float>(Simd128<int32> simd) {
+  return _mm_cvtepi32_ps(to_raw(simd));
+}
+
+template <>
+inline Simd128<int32> ConvertElements<int32>(Simd128<float> simd) {
+  return _mm_cvttps_epi32(to_raw(simd));
+}
+
+#ifdef __AVX512VL__
+template <>
+inline Simd128<float> ConvertElements<float>(Simd128<uint32> simd) {
+  return _mm_cvtepu32_ps(to_raw(simd));
+}
+#elif defined(__SSE4_1__)
+// Converts the high and low 16 bits separately. Both conversions and the
+// multiplication are exact, so the sum rounds once, like static_cast.
+template <>
+inline Simd128<float> ConvertElements<float>(Simd128<uint32> simd) {
+  const __m128i raw = to_raw(simd);
+  const __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(raw, 16));
+  const __m128 low =
+      _mm_cvtepi32_ps(_mm_blend_epi16(raw, _mm_setzero_si128(), 0xaa));
+  return _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.f)), low);
+}
+#endif
+
+#if defined(__AVX512DQ__) && defined(__AVX512VL__)
+template <>
+inline Simd128<double> ConvertElements<double>(Simd128<int64> simd) {
+  return _mm_cvtepi64_pd(to_raw(simd));
+}
+
+template <>
+inline Simd128<int64> ConvertElements<int64>(Simd128<double> simd) {
+  return _mm_cvttpd_epi64(to_raw(simd));
+}
+#elif defined(__SSE4_1__)
+// Without AVX-512DQ there are no conversions of int64. The top 16 bits of each
+// element go into the mantissa of 3 * 2^67 and the low 48 bits into that of
+// 2^52, which makes two doubles that subtract exactly, and add with one
+// rounding, like static_cast.
+template <>
+inline Simd128<double> ConvertElements<double>(Simd128<int64> simd) {
+  const __m128i raw = to_raw(simd);
+  __m128i high = _mm_blend_epi16(_mm_srai_epi32(raw, 16),
+                                 _mm_setzero_si128(), 0x33);
+  high = _mm_add_epi64(high, _mm_castpd_si128(_mm_set1_pd(0x1.8p68)));
+  const __m128i low =
+      _mm_blend_epi16(raw, _mm_castpd_si128(_mm_set1_pd(0x1p52)), 0x88);
+  const __m128d high_minus_2_52 =
+      _mm_sub_pd(_mm_castsi128_pd(high), _mm_set1_pd(0x1.8p68 + 0x1p52));
+  return _mm_add_pd(high_minus_2_52, _mm_castsi128_pd(low));
+}
+#endif
+
+// Simd256 without AVX converts the two halves of the wider Simd object.
+#if defined(__SSE4_1__) && !defined(__AVX2__)
+template <typename T, typename Widen>
+Simd256<T> WidenHalves(Simd128<ScaleBy<T, 1, 2>> simd, Widen widen) {
+  const __m128i raw = to_raw(simd);
+  return Combine(Simd128<T>(widen(raw)),
+                 Simd128<T>(widen(_mm_unpackhi_epi64(raw, raw))));
+}
+
+template <>
+inline Simd256<int16> ConvertElements<int16>(Simd128<int8> simd) {
+  return WidenHalves<int16>(
+      simd, [](__m128i half) { return _mm_cvtepi8_epi16(half); });
+}
+
+template <>
+inline Simd256<uint16> ConvertElements<uint16>(Simd128<uint8> simd) {
+  return WidenHalves<uint16>(
+      simd, [](__m128i half) { return _mm_cvtepu8_epi16(half); });
+}
+
+template <>
+inline Simd256<int32> ConvertElements<int32>(Simd128<int16> simd) {
+  return WidenHalves<int32>(
+      simd, [](__m128i half) { return _mm_cvtepi16_epi32(half); });
+}
+
+template <>
+inline Simd256<uint32> ConvertElements<uint32>(Simd128<uint16> simd) {
+  return WidenHalves<uint32>(
+      simd, [](__m128i half) { return _mm_cvtepu16_epi32(half); });
+}
+
+template <>
+inline Simd256<int64> ConvertElements<int64>(Simd128<int32> simd) {
+  return WidenHalves<int64>(
+      simd, [](__m128i half) { return _mm_cvtepi32_epi64(half); });
+}
+
+template <>
+inline Simd256<uint64> ConvertElements<uint64>(Simd128<uint32> simd) {
+  return WidenHalves<uint64>(
+      simd, [](__m128i half) { return _mm_cvtepu32_epi64(half); });
+}
+
+// Clears the high half of each element, so that the saturating pack truncates.
+template <>
+inline Simd128<uint8> ConvertElements<uint8>(Simd256<uint16> simd) {
+  const __m128i low_bytes = _mm_set1_epi16(0xff);
+  return _mm_packus_epi16(_mm_and_si128(to_raw(Half<0>(simd)), low_bytes),
+                          _mm_and_si128(to_raw(Half<1>(simd)), low_bytes));
+}
+
+template <>
+inline Simd128<uint16> ConvertElements<uint16>(Simd256<uint32> simd) {
+  const __m128i low_halves = _mm_set1_epi32(0xffff);
+  return _mm_packus_epi32(_mm_and_si128(to_raw(Half<0>(simd)), low_halves),
+                          _mm_and_si128(to_raw(Half<1>(simd)), low_halves));
+}
+
+template <>
+inline Simd256<float> ConvertElements<float>(Simd256<uint32> simd) {
+  return ConvertHalves<float>(simd);
+}
+
+template <>
+inline Simd256<double> ConvertElements<double>(Simd256<int64> simd) {
+  return ConvertHalves<double>(simd);
+}
+#endif  // defined(__SSE4_1__) && !defined(__AVX2__)
+
+#ifndef __AVX__
+template <>
+inline Simd128<uint32> ConvertElements<uint32>(Simd256<uint64> simd) {
+  return _mm_castps_si128(
+      _mm_shuffle_ps(_mm_castsi128_ps(to_raw(Half<0>(simd))),
+                     _mm_castsi128_ps(to_raw(Half<1>(simd))),
+                     _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+template <>
+inline Simd256<float> ConvertElements<float>(Simd256<int32> simd) {
+  return ConvertHalves<float>(simd);
+}
+
+template <>
+inline Simd256<int32> ConvertElements<int32>(Simd256<float> simd) {
+  return ConvertHalves<int32>(simd);
+}
+#endif  // __AVX__
+
+}  // namespace detail
+
 template <typename T>
 Simd128<ScaleBy<T, 2>> mul_widened(Simd64<T> lhs, Simd64<T> rhs) {
   return simd_cast<ScaleBy<T, 2>>(lhs) * simd_cast<ScaleBy<T, 2>>(rhs);
 }
 
+// pmuludq multiplies the low 32 bits of each 64-bit lane, so one widening
+// multiply replaces the three of a full 64-bit multiplication.
+template <>
+inline Simd128<uint64> mul_widened(Simd64<uint32> lhs, Simd64<uint32> rhs) {
+  return _mm_mul_epu32(to_raw(simd_cast<uint64>(lhs)),
+                       to_raw(simd_cast<uint64>(rhs)));
+}
+
+#ifdef __SSE4_1__
+template <>
+inline Simd128<int64> mul_widened(Simd64<int32> lhs, Simd64<int32> rhs) {
+  return _mm_mul_epi32(to_raw(simd_cast<int64>(lhs)),
+                       to_raw(simd_cast<int64>(rhs)));
+}
+#endif
+
+#ifdef __SSE4_1__
+namespace detail {
+
+// Load and store the low 4 or 8 bytes of a vector, with no alignment.
+inline __m128i Load32Bits(const void* p) {
+  int32 bits;
+  memcpy(&bits, p, sizeof(bits));
+  return _mm_cvtsi32_si128(bits);
+}
+
+inline __m128i Load64Bits(const void* p) {
+  return _mm_loadl_epi64(static_cast<const __m128i*>(p));
+}
+
+inline void Store32Bits(__m128i v, void* p) {
+  int32 bits = _mm_cvtsi128_si32(v);
+  memcpy(p, &bits, sizeof(bits));
+}
+
+inline void Store64Bits(__m128i v, void* p) {
+  _mm_storel_epi64(static_cast<__m128i*>(p), v);
+}
+
+// cvttps2dq returns INT32_MIN for floats out of the int32 range. Clamping
+// from above to max makes those too large saturate, and those too small
+// already do.
+inline __m128i TruncateClamped(Simd128<float> simd, float max) {
+  return _mm_cvttps_epi32(_mm_min_ps(to_raw(simd), _mm_set1_ps(max)));
+}
+
+}  // namespace detail
+
+template <>
+inline Simd128<int32> load_converted<Simd128<int32>>(const int8* p) {
+  return _mm_cvtepi8_epi32(detail::Load32Bits(p));
+}
+
+template <>
+inline Simd128<int32> load_converted<Simd128<int32>>(const uint8* p) {
+  return _mm_cvtepu8_epi32(detail::Load32Bits(p));
+}
+
+template <>
+inline Simd128<int32> load_converted<Simd128<int32>>(const int16* p) {
+  return _mm_cvtepi16_epi32(detail::Load64Bits(p));
+}
+
+template <>
+inline Simd128<int32> load_converted<Simd128<int32>>(const uint16* p) {
+  return _mm_cvtepu16_epi32(detail::Load64Bits(p));
+}
+
+template <>
+inline Simd128<int16> load_converted<Simd128<int16>>(const int8* p) {
+  return _mm_cvtepi8_epi16(detail::Load64Bits(p));
+}
+
+template <>
+inline Simd128<int16> load_converted<Simd128<int16>>(const uint8* p) {
+  return _mm_cvtepu8_epi16(detail::Load64Bits(p));
+}
+
+template <>
+inline Simd128<uint16> load_converted<Simd128<uint16>>(const uint8* p) {
+  return _mm_cvtepu8_epi16(detail::Load64Bits(p));
+}
+
+template <>
+inline Simd128<float> load_converted<Simd128<float>>(const int8* p) {
+  return _mm_cvtepi32_ps(to_raw(load_converted<Simd128<int32>>(p)));
+}
+
+template <>
+inline Simd128<float> load_converted<Simd128<float>>(const uint8* p) {
+  return _mm_cvtepi32_ps(to_raw(load_converted<Simd128<int32>>(p)));
+}
+
+template <>
+inline Simd128<float> load_converted<Simd128<float>>(const int16* p) {
+  return _mm_cvtepi32_ps(to_raw(load_converted<Simd128<int32>>(p)));
+}
+
+template <>
+inline Simd128<float> load_converted<Simd128<float>>(const uint16* p) {
+  return _mm_cvtepi32_ps(to_raw(load_converted<Simd128<int32>>(p)));
+}
+
+template <>
+inline Simd128<float> load_converted<Simd128<float>>(const int32* p) {
+  return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+template <>
+inline void store_saturated(Simd128<int32> simd, int16* p) {
+  detail::Store64Bits(_mm_packs_epi32(to_raw(simd), to_raw(simd)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<int32> simd, uint16* p) {
+  detail::Store64Bits(_mm_packus_epi32(to_raw(simd), to_raw(simd)), p);
+}
+
+// Saturating to int16 first keeps the order, so saturating that again gives
+// the same result.
+template <>
+inline void store_saturated(Simd128<int32> simd, int8* p) {
+  __m128i int16s = _mm_packs_epi32(to_raw(simd), to_raw(simd));
+  detail::Store32Bits(_mm_packs_epi16(int16s, int16s), p);
+}
+
+template <>
+inline void store_saturated(Simd128<int32> simd, uint8* p) {
+  __m128i int16s = _mm_packs_epi32(to_raw(simd), to_raw(simd));
+  detail::Store32Bits(_mm_packus_epi16(int16s, int16s), p);
+}
+
+template <>
+inline void store_saturated(Simd128<int16> simd, int8* p) {
+  detail::Store64Bits(_mm_packs_epi16(to_raw(simd), to_raw(simd)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<int16> simd, uint8* p) {
+  detail::Store64Bits(_mm_packus_epi16(to_raw(simd), to_raw(simd)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<float> simd, int16* p) {
+  store_saturated(Simd128<int32>(detail::TruncateClamped(simd, 32767)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<float> simd, uint16* p) {
+  store_saturated(Simd128<int32>(detail::TruncateClamped(simd, 65535)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<float> simd, int8* p) {
+  store_saturated(Simd128<int32>(detail::TruncateClamped(simd, 127)), p);
+}
+
+template <>
+inline void store_saturated(Simd128<float> simd, uint8* p) {
+  store_saturated(Simd128<int32>(detail::TruncateClamped(simd, 255)), p);
+}
+
+// For floats out of range, whose static_cast is unspecified, cvttps2dq gives
+// INT32_MIN and the narrower stores saturate that.
+template <>
+inline void store_converted(Simd128<float> simd, int32* p) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                   _mm_cvttps_epi32(to_raw(simd)));
+}
+
+template <>
+inline void store_converted(Simd128<float> simd, int16* p) {
+  store_saturated(Simd128<int32>(_mm_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd128<float> simd, uint16* p) {
+  store_saturated(Simd128<int32>(_mm_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd128<float> simd, int8* p) {
+  store_saturated(Simd128<int32>(_mm_cvttps_epi32(to_raw(simd))), p);
+}
+
+template <>
+inline void store_converted(Simd128<float> simd, uint8* p) {
+  store_saturated(Simd128<int32>(_mm_cvttps_epi32(to_raw(simd))), p);
+}
+#endif  // __SSE4_1__
+
 }  // namespace dimsum
 
+#if defined(__SSE4_1__) && !defined(__AVX2__)
+_DIMSUM_BEGIN_NAMESPACE_EXPERIMENTAL_SIMD
+
+#ifndef __SSE4_2__
+// min and max of int64 elements select with the comparison above. The simd
+// header is mirrored from libc++, so they are specialized here.
+template <>
+inline dimsum::Simd128<int64> min(
+    const dimsum::Simd128<int64>& __a,
+    const dimsum::Simd128<int64>& __b) noexcept {
+  return _mm_blendv_epi8(__a.__raw(), __b.__raw(),
+                         dimsum::detail::CmpGtInt64(__a.__raw(), __b.__raw()));
+}
+
+template <>
+inline dimsum::Simd128<int64> max(
+    const dimsum::Simd128<int64>& __a,
+    const dimsum::Simd128<int64>& __b) noexcept {
+  return _mm_blendv_epi8(__b.__raw(), __a.__raw(),
+                         dimsum::detail::CmpGtInt64(__a.__raw(), __b.__raw()));
+}
+#endif  // __SSE4_2__
+
+// As with the comparisons, compilers select the int64 elements of Simd256
+// objects one at a time, so the halves are handled as Simd128 objects.
+template <>
+inline dimsum::Simd256<int64> min(
+    const dimsum::Simd256<int64>& __a,
+    const dimsum::Simd256<int64>& __b) noexcept {
+  using dimsum::detail::Half;
+  return dimsum::detail::Combine(min(Half<0>(__a), Half<0>(__b)),
+                                 min(Half<1>(__a), Half<1>(__b)));
+}
+
+template <>
+inline dimsum::Simd256<int64> max(
+    const dimsum::Simd256<int64>& __a,
+    const dimsum::Simd256<int64>& __b) noexcept {
+  using dimsum::detail::Half;
+  return dimsum::detail::Combine(max(Half<0>(__a), Half<0>(__b)),
+                                 max(Half<1>(__a), Half<1>(__b)));
+}
+
+_DIMSUM_END_NAMESPACE_EXPERIMENTAL_SIMD
+#endif  // defined(__SSE4_1__) && !defined(__AVX2__)
+
 #endif  // DIMSUM_SIMD_SSE_H_
@@ -48,6 +48,19 @@ Simd<T, Abi> shuffle(const Simd<T, Abi> lhs, const Simd<T, Abi> rhs = {}) {
   return Simd<T, Abi>(a, flags::element_aligned);
 }
 
+template <typename Abi>
+Simd<uint8, Abi> lookup(Simd<uint8, Abi> table, Simd<uint8, Abi> indices) {
+  constexpr size_t kSize = Simd<uint8, Abi>::size();
+  constexpr size_t kSegment = kSize < 16 ? kSize : 16;
+  uint8 a[kSize];
+  for (size_t i = 0; i < kSize; i++) {
+    a[i] = indices[i] & 0x80
+               ? 0
+               : table[i / kSegment * kSegment + indices[i] % kSegment];
+  }
+  return Simd<uint8, Abi>(a, flags::element_aligned);
+}
+
 template <typename T, typename Abi>
 typename std::enable_if<std::is_integral<T>::value, Simd<T, Abi>>::type abs(
     Simd<T, Abi> simd) {
@@ -162,7 +175,7 @@ template <typename T, typename Abi>
 Simd<T, Abi> add_saturated(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   T a[lhs.size()];
   for (size_t i = 0; i < lhs.size(); i++) {
-    a[i] = detail::SaturatedAdd(lhs[i], rhs[i]);
+    a[i] = detail::SaturatedAdd<T>(lhs[i], rhs[i]);
   }
   return Simd<T, Abi>(a, flags::element_aligned);
 }
@@ -180,7 +193,7 @@ template <typename T, typename Abi>
 Simd<T, Abi> sub_saturated(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   T a[lhs.size()];
   for (size_t i = 0; i < lhs.size(); i++) {
-    a[i] = detail::SaturatedSub(lhs[i], rhs[i]);
+    a[i] = detail::SaturatedSub<T>(lhs[i], rhs[i]);
   }
   return Simd<T, Abi>(a, flags::element_aligned);
 }
@@ -412,20 +425,34 @@ Simd<T, Abi> min(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   return Simd<T, Abi>(a, flags::element_aligned);
 }
 
-// TODO(maskray) {int,uint}{8,32,64} specializations are provided.
-// Provide float/double specializations if there are use cases to check sign
-// bits
 template <typename T, typename Abi>
 int movemask(Simd<T, Abi> simd) {
-  static_assert(std::is_integral<T>::value,
-                "Only integral types are supported");
+  auto bits = bit_cast<detail::ToUnsigned<T>>(simd);
   int res = 0;
   for (size_t i = 0; i < simd.size(); i++) {
-    res |= (simd[i] >> (sizeof(T) * CHAR_BIT - 1) & 1) << i;
+    res |= (bits[i] >> (sizeof(T) * CHAR_BIT - 1) & 1) << i;
   }
   return res;
 }
 
+template <int kLhsLane, int kRhsLane, typename Abi>
+Simd<uint64, Abi> clmul(Simd<uint64, Abi> lhs, Simd<uint64, Abi> rhs) {
+  uint64 a[lhs.size()];
+  for (size_t i = 0; i < lhs.size(); i += 2) {
+    uint64 x = lhs[i + kLhsLane], y = rhs[i + kRhsLane];
+    uint64 low = 0, high = 0;
+    for (int j = 0; j < 64; j++) {
+      if (y >> j & 1) {
+        low ^= x << j;
+        high ^= j == 0 ? 0 : x >> (64 - j);
+      }
+    }
+    a[i] = low;
+    a[i + 1] = high;
+  }
+  return Simd<uint64, Abi>(a, flags::element_aligned);
+}
+
 }  // namespace simulated
 }  // namespace dimsum
 
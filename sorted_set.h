@@ -0,0 +1,412 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_SORTED_SET_H_
+#define DIMSUM_SORTED_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Set operations on sorted uint32 arrays without duplicates, such as posting
+// lists: intersect_sorted, union_sorted and difference_sorted.
+//
+// The arrays are processed in blocks of 4 lanes. Two blocks are compared
+// all-pairs, with cmp_eq against the 4 rotations of one of them, and the
+// block with the smaller last element is advanced. The selected lanes of a
+// block are written with a left-pack: a lookup() of the block by a 16-entry
+// table indexed by the movemask of the selection, followed by a full store of
+// which only the first popcount(mask) lanes are kept.
+//
+// When one array is much smaller than the other, each of its elements is
+// instead searched in the larger one by galloping over blocks of 4, and
+// checked with a single cmp_eq. Union and difference copy the runs of the
+// larger array between the elements found.
+//
+// Blocks are Simd128 on all targets. The all-pairs comparison of 8-lane
+// blocks would need 8 cross-lane rotations for each of which AVX2 has no
+// cheaper instruction, and the left-pack table would have 256 entries.
+
+namespace dimsum {
+namespace detail {
+
+using SetBlock = Simd128<uint32>;
+
+// One of the arrays is searched by galloping when it is this many times
+// larger than the other.
+constexpr size_t kGallopRatio = 32;
+
+struct SortedSetTables {
+  SortedSetTables() {
+    for (int mask = 0; mask < 16; mask++) {
+      uint8 indices[16];
+      int lane = 0;
+      for (int i = 0; i < 4; i++) {
+        if (mask & 1 << i) {
+          for (int byte = 0; byte < 4; byte++) {
+            indices[4 * lane + byte] = 4 * i + byte;
+          }
+          lane++;
+        }
+      }
+      for (int i = 4 * lane; i < 16; i++) indices[i] = 0x80;
+      left_pack[mask] = Simd128<uint8>(indices, flags::element_aligned);
+    }
+  }
+
+  // left_pack[mask] moves the lanes selected by mask to the front.
+  Simd128<uint8> left_pack[16];
+};
+
+inline const SortedSetTables& GetSortedSetTables() {
+  static const SortedSetTables tables;
+  return tables;
+}
+
+inline SetBlock LoadSetBlock(const uint32* p) {
+  return LoadUnaligned<SetBlock>(p);
+}
+
+// Stores the lanes of block selected by mask to out, and returns their number.
+// Writes all 4 lanes of out.
+inline size_t StoreLeftPacked(const SortedSetTables& tables, SetBlock block,
+                              int mask, uint32* out) {
+  StoreUnaligned(bit_cast<uint32>(lookup(bit_cast<uint8>(block),
+                                         tables.left_pack[mask])),
+                 out);
+  return __builtin_popcount(mask);
+}
+
+// Same as above, but writes at most room lanes of out.
+inline size_t StoreLeftPacked(const SortedSetTables& tables, SetBlock block,
+                              int mask, uint32* out, size_t room) {
+  if (room >= 4) return StoreLeftPacked(tables, block, mask, out);
+  uint32 lanes[4];
+  const size_t count = StoreLeftPacked(tables, block, mask, lanes);
+  memcpy(out, lanes, count * sizeof(uint32));
+  return count;
+}
+
+// Returns {block[1], block[2], block[3], block[0]}, with one pshufd on x86; see
+// shuffle() for why the generic version is avoided.
+inline SetBlock RotateSetBlock(SetBlock block) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_1__)
+  return _mm_shuffle_epi32(to_raw(block), 0x39);
+#else
+  return shuffle<1, 2, 3, 0>(block);
+#endif
+}
+
+// Returns {prev[3], block[0], block[1], block[2]}.
+inline SetBlock PrevSetLanes(SetBlock prev, SetBlock block) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_1__)
+  return _mm_alignr_epi8(to_raw(block), to_raw(prev), 12);
+#else
+  return shuffle<3, 4, 5, 6>(prev, block);
+#endif
+}
+
+// Returns the mask of lanes of a equal to some lane of b.
+inline int MatchSetBlocks(SetBlock a, SetBlock b) {
+  SetBlock b1 = RotateSetBlock(b);
+  SetBlock b2 = RotateSetBlock(b1);
+  SetBlock b3 = RotateSetBlock(b2);
+  return x86::movemask(
+      bit_cast<uint32>((cmp_eq(a, b) | cmp_eq(a, b1)) |
+                       (cmp_eq(a, b2) | cmp_eq(a, b3))));
+}
+
+// Returns the first of the blocks at j, j + 4, j + 8, ... that ends with an
+// element >= x, or the start of the last, partial block if there is none.
+// Searches exponentially, then binary searches between the last two probes.
+inline size_t GallopSetBlock(const uint32* data, size_t j, size_t size,
+                             uint32 x) {
+  if (j + 4 > size || data[j + 3] >= x) return j;
+  // In blocks from j: block lo ends with an element < x, and block hi with
+  // one >= x, or is the partial block.
+  const size_t num_blocks = (size - j) / 4;
+  size_t lo = 0;
+  size_t hi = 1;
+  while (hi < num_blocks && data[j + 4 * hi + 3] < x) {
+    const size_t step = 2 * (hi - lo);
+    lo = hi;
+    hi = std::min(lo + step, num_blocks);
+  }
+  while (hi - lo > 1) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (data[j + 4 * mid + 3] < x) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return j + 4 * hi;
+}
+
+// Returns whether x is in the sorted data[j, size), and advances j past the
+// elements smaller than x.
+inline bool GallopContains(const uint32* data, size_t* j, size_t size,
+                           uint32 x) {
+  *j = GallopSetBlock(data, *j, size, x);
+  if (*j + 4 <= size) {
+    return x86::movemask(bit_cast<uint32>(
+               cmp_eq(LoadSetBlock(data + *j), SetBlock(x)))) != 0;
+  }
+  *j = std::lower_bound(data + *j, data + size, x) - data;
+  return *j < size && data[*j] == x;
+}
+
+// Returns the first index >= j of an element of data >= x.
+inline size_t GallopLowerBound(const uint32* data, size_t j, size_t size,
+                               uint32 x) {
+  j = GallopSetBlock(data, j, size, x);
+  return std::lower_bound(data + j, data + std::min(j + 4, size), x) - data;
+}
+
+// Copies large[*j, end) to out, and returns the number of elements copied.
+// large may be null when the run is empty, so memcpy is skipped then.
+inline size_t CopyRun(const uint32* large, size_t* j, size_t end,
+                      uint32* out) {
+  const size_t count = end - *j;
+  if (count > 0) memcpy(out, large + *j, count * sizeof(uint32));
+  *j = end;
+  return count;
+}
+
+inline size_t IntersectGallop(const uint32* small, size_t small_size,
+                              const uint32* large, size_t large_size,
+                              uint32* out) {
+  size_t count = 0;
+  size_t j = 0;
+  for (size_t i = 0; i < small_size; i++) {
+    if (GallopContains(large, &j, large_size, small[i])) {
+      out[count++] = small[i];
+    }
+  }
+  return count;
+}
+
+// The union of a small and a large array: the runs of the large array between
+// the elements of the small one are copied.
+inline size_t UnionGallop(const uint32* small, size_t small_size,
+                          const uint32* large, size_t large_size,
+                          uint32* out) {
+  size_t count = 0;
+  size_t j = 0;
+  for (size_t i = 0; i < small_size; i++) {
+    const uint32 x = small[i];
+    count += CopyRun(large, &j, GallopLowerBound(large, j, large_size, x),
+                     out + count);
+    if (j < large_size && large[j] == x) j++;
+    out[count++] = x;
+  }
+  return count + CopyRun(large, &j, large_size, out + count);
+}
+
+// Sorts the 8 lanes of a and b, which are both sorted, into min and max. This
+// is the merge network of Inoue et al.: each min/max step settles one more
+// lane of min, which is then rotated out.
+inline void MergeSetBlocks(SetBlock a, SetBlock b, SetBlock* min_block,
+                           SetBlock* max_block) {
+  SetBlock lo = min(a, b);
+  SetBlock hi = max(a, b);
+  for (int i = 0; i < 3; i++) {
+    lo = RotateSetBlock(lo);
+    SetBlock next_lo = min(lo, hi);
+    hi = max(lo, hi);
+    lo = next_lo;
+  }
+  *min_block = RotateSetBlock(lo);
+  *max_block = hi;
+}
+
+}  // namespace detail
+
+// Writes the elements of both a and b to out, in increasing order, and
+// returns their number. a and b are sorted without duplicates; out has room
+// for min(a_size, b_size) elements.
+inline size_t intersect_sorted(const uint32* a, size_t a_size, const uint32* b,
+                               size_t b_size, uint32* out) {
+  using detail::SetBlock;
+  if (a_size * detail::kGallopRatio <= b_size) {
+    return detail::IntersectGallop(a, a_size, b, b_size, out);
+  }
+  if (b_size * detail::kGallopRatio <= a_size) {
+    return detail::IntersectGallop(b, b_size, a, a_size, out);
+  }
+  const detail::SortedSetTables& tables = detail::GetSortedSetTables();
+  const size_t capacity = std::min(a_size, b_size);
+  size_t i = 0, j = 0, count = 0;
+  while (i + 4 <= a_size && j + 4 <= b_size) {
+    SetBlock block = detail::LoadSetBlock(a + i);
+    const int mask = detail::MatchSetBlocks(block, detail::LoadSetBlock(b + j));
+    count += detail::StoreLeftPacked(tables, block, mask, out + count,
+                                     capacity - count);
+    const uint32 a_max = a[i + 3];
+    const uint32 b_max = b[j + 3];
+    if (a_max <= b_max) i += 4;
+    if (b_max <= a_max) j += 4;
+  }
+  while (i < a_size && j < b_size) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      out[count++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  return count;
+}
+
+// Writes the elements of a or b to out, in increasing order, and returns
+// their number. a and b are sorted without duplicates; out has room for
+// a_size + b_size elements.
+inline size_t union_sorted(const uint32* a, size_t a_size, const uint32* b,
+                           size_t b_size, uint32* out) {
+  using detail::SetBlock;
+  if (a_size * detail::kGallopRatio <= b_size) {
+    return detail::UnionGallop(a, a_size, b, b_size, out);
+  }
+  if (b_size * detail::kGallopRatio <= a_size) {
+    return detail::UnionGallop(b, b_size, a, a_size, out);
+  }
+  size_t i = 0, j = 0, count = 0;
+  if (a_size >= 4 && b_size >= 4) {
+    const detail::SortedSetTables& tables = detail::GetSortedSetTables();
+    // The blocks are merged into a sorted stream of blocks, of which max is
+    // the pending last one. A lane of a merged block is dropped if it equals
+    // the previous element, which is the last lane of prev for the first
+    // lane. The first merged block starts with the smallest element of a
+    // and b, which is at most 0xfffffffc and so differs from prev.
+    SetBlock prev(~0u);
+    SetBlock min_block, max_block;
+    detail::MergeSetBlocks(detail::LoadSetBlock(a), detail::LoadSetBlock(b),
+                           &min_block, &max_block);
+    i = j = 4;
+    for (;;) {
+      const int duplicates = x86::movemask(bit_cast<uint32>(
+          cmp_eq(min_block, detail::PrevSetLanes(prev, min_block))));
+      // At least 4 elements are pending in max_block, so the 4 lanes written
+      // fit in out.
+      count += detail::StoreLeftPacked(tables, min_block, ~duplicates & 0xf,
+                                       out + count);
+      prev = min_block;
+      // The next block is from the array with the smaller next element.
+      // If that array has only a partial block left, the rest is scalar.
+      const bool take_a = j == b_size || (i < a_size && a[i] <= b[j]);
+      SetBlock next;
+      if (take_a && i + 4 <= a_size) {
+        next = detail::LoadSetBlock(a + i);
+        i += 4;
+      } else if (!take_a && j + 4 <= b_size) {
+        next = detail::LoadSetBlock(b + j);
+        j += 4;
+      } else {
+        break;
+      }
+      detail::MergeSetBlocks(next, max_block, &min_block, &max_block);
+    }
+    // Merge the pending block and the tails, which are all at least the last
+    // stored element.
+    uint32 pending[4];
+    detail::StoreUnaligned(max_block, pending);
+    uint32 last = prev[3];
+    size_t k = 0;
+    while (k < 4 || i < a_size || j < b_size) {
+      uint32 x = ~0u;
+      int source = -1;
+      if (k < 4) x = pending[k], source = 0;
+      if (i < a_size && (source < 0 || a[i] < x)) x = a[i], source = 1;
+      if (j < b_size && (source < 0 || b[j] < x)) x = b[j], source = 2;
+      if (source == 0) k++;
+      if (source == 1) i++;
+      if (source == 2) j++;
+      if (x != last) out[count++] = last = x;
+    }
+    return count;
+  }
+  while (i < a_size && j < b_size) {
+    if (a[i] < b[j]) {
+      out[count++] = a[i++];
+    } else if (b[j] < a[i]) {
+      out[count++] = b[j++];
+    } else {
+      out[count++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  while (i < a_size) out[count++] = a[i++];
+  while (j < b_size) out[count++] = b[j++];
+  return count;
+}
+
+// Writes the elements of a that are not in b to out, in increasing order, and
+// returns their number. a and b are sorted without duplicates; out has room
+// for a_size elements.
+inline size_t difference_sorted(const uint32* a, size_t a_size,
+                                const uint32* b, size_t b_size, uint32* out) {
+  using detail::SetBlock;
+  size_t i = 0, j = 0, count = 0;
+  if (a_size * detail::kGallopRatio <= b_size) {
+    for (; i < a_size; i++) {
+      if (!detail::GallopContains(b, &j, b_size, a[i])) out[count++] = a[i];
+    }
+    return count;
+  }
+  if (b_size * detail::kGallopRatio <= a_size) {
+    // Copy the runs of a between the elements of b.
+    for (; j < b_size; j++) {
+      count += detail::CopyRun(
+          a, &i, detail::GallopLowerBound(a, i, a_size, b[j]), out + count);
+      if (i < a_size && a[i] == b[j]) i++;
+    }
+    return count + detail::CopyRun(a, &i, a_size, out + count);
+  }
+  const detail::SortedSetTables& tables = detail::GetSortedSetTables();
+  // The lanes of the block of a at i found in the blocks of b so far.
+  int found = 0;
+  while (i + 4 <= a_size && j + 4 <= b_size) {
+    SetBlock block = detail::LoadSetBlock(a + i);
+    found |= detail::MatchSetBlocks(block, detail::LoadSetBlock(b + j));
+    const uint32 a_max = a[i + 3];
+    const uint32 b_max = b[j + 3];
+    if (a_max <= b_max) {
+      // count <= i, so the 4 lanes written fit in out.
+      count +=
+          detail::StoreLeftPacked(tables, block, ~found & 0xf, out + count);
+      found = 0;
+      i += 4;
+    }
+    if (b_max <= a_max) j += 4;
+  }
+  for (size_t start = i; i < a_size; i++) {
+    if (i - start < 4 && (found >> (i - start) & 1)) continue;
+    while (j < b_size && b[j] < a[i]) j++;
+    if (j == b_size || b[j] != a[i]) out[count++] = a[i];
+  }
+  return count;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_SORTED_SET_H_
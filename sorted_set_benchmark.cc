@@ -0,0 +1,106 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "sorted_set.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kLargeSize = 1 << 16;
+
+// Returns a sorted set of about kLargeSize / ratio elements from
+// [0, 4 * kLargeSize).
+std::vector<uint32> RandomSet(int ratio, uint32 seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint32> set(kLargeSize / ratio);
+  for (uint32& x : set) x = rng() % (4 * kLargeSize);
+  std::sort(set.begin(), set.end());
+  set.erase(std::unique(set.begin(), set.end()), set.end());
+  return set;
+}
+
+// Benchmarks op on a set of kLargeSize elements and one range(0) times
+// smaller.
+template <typename Op>
+void BenchmarkSetOp(benchmark::State& state, Op op) {
+  std::vector<uint32> small = RandomSet(state.range(0), 1);
+  std::vector<uint32> large = RandomSet(1, 2);
+  std::vector<uint32> out(small.size() + large.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(op(small, large, out.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * (small.size() + large.size()));
+}
+
+void BM_ScalarIntersect(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), out) -
+           out;
+  });
+}
+BENCHMARK(BM_ScalarIntersect)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_Intersect(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return intersect_sorted(a.data(), a.size(), b.data(), b.size(), out);
+  });
+}
+BENCHMARK(BM_Intersect)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_ScalarUnion(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return std::set_union(a.begin(), a.end(), b.begin(), b.end(), out) - out;
+  });
+}
+BENCHMARK(BM_ScalarUnion)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_Union(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return union_sorted(a.data(), a.size(), b.data(), b.size(), out);
+  });
+}
+BENCHMARK(BM_Union)->RangeMultiplier(4)->Range(1, 1024);
+
+// The difference of the large set and the small one, and the reverse.
+void BM_ScalarDifference(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return (std::set_difference(b.begin(), b.end(), a.begin(), a.end(), out) -
+            out) +
+           (std::set_difference(a.begin(), a.end(), b.begin(), b.end(), out) -
+            out);
+  });
+}
+BENCHMARK(BM_ScalarDifference)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_Difference(benchmark::State& state) {
+  BenchmarkSetOp(state, [](const std::vector<uint32>& a,
+                           const std::vector<uint32>& b, uint32* out) {
+    return difference_sorted(b.data(), b.size(), a.data(), a.size(), out) +
+           difference_sorted(a.data(), a.size(), b.data(), b.size(), out);
+  });
+}
+BENCHMARK(BM_Difference)->RangeMultiplier(4)->Range(1, 1024);
+
+}  // namespace
+}  // namespace dimsum
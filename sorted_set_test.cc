@@ -0,0 +1,134 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sorted_set.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+using Set = std::vector<uint32>;
+
+// Returns size distinct values below limit, sorted.
+Set RandomSet(size_t size, uint32 limit, std::mt19937* rng) {
+  std::set<uint32> set;
+  while (set.size() < size) set.insert((*rng)() % limit);
+  return Set(set.begin(), set.end());
+}
+
+// Runs op with an output of exactly the documented capacity, so that
+// AddressSanitizer catches writes past it.
+template <typename Op>
+Set Run(Op op, const Set& a, const Set& b, size_t capacity) {
+  std::unique_ptr<uint32[]> out(new uint32[capacity]);
+  const size_t size = op(a.data(), a.size(), b.data(), b.size(), out.get());
+  return Set(out.get(), out.get() + size);
+}
+
+void CheckAll(const Set& a, const Set& b) {
+  Set expected;
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(expected));
+  EXPECT_EQ(expected,
+            Run(intersect_sorted, a, b, std::min(a.size(), b.size())));
+  EXPECT_EQ(expected,
+            Run(intersect_sorted, b, a, std::min(a.size(), b.size())));
+  expected.clear();
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                 std::back_inserter(expected));
+  EXPECT_EQ(expected, Run(union_sorted, a, b, a.size() + b.size()));
+  EXPECT_EQ(expected, Run(union_sorted, b, a, a.size() + b.size()));
+  expected.clear();
+  std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                      std::back_inserter(expected));
+  EXPECT_EQ(expected, Run(difference_sorted, a, b, a.size()));
+  expected.clear();
+  std::set_difference(b.begin(), b.end(), a.begin(), a.end(),
+                      std::back_inserter(expected));
+  EXPECT_EQ(expected, Run(difference_sorted, b, a, b.size()));
+}
+
+TEST(SortedSetTest, Small) {
+  CheckAll({}, {});
+  CheckAll({}, {1, 2, 3});
+  CheckAll({1, 2, 3, 4}, {1, 2, 3, 4});
+  CheckAll({1, 2, 3, 4}, {5, 6, 7, 8});
+  CheckAll({0, 1, 2, 3, 4, 5, 6, 7}, {0, 2, 4, 6, 8});
+  CheckAll({0, 0xfffffffd, 0xfffffffe, 0xffffffff},
+           {1, 2, 0xfffffffe, 0xffffffff});
+}
+
+// Empty sets may have null data, as std::vector does.
+TEST(SortedSetTest, EmptyNull) {
+  uint32 out[1];
+  EXPECT_EQ(0u, intersect_sorted(nullptr, 0, nullptr, 0, out));
+  EXPECT_EQ(0u, union_sorted(nullptr, 0, nullptr, 0, out));
+  EXPECT_EQ(0u, difference_sorted(nullptr, 0, nullptr, 0, out));
+  const uint32 set[] = {1, 2, 3};
+  EXPECT_EQ(0u, intersect_sorted(nullptr, 0, set, 3, out));
+  EXPECT_EQ(0u, difference_sorted(nullptr, 0, set, 3, out));
+}
+
+TEST(SortedSetTest, Random) {
+  std::mt19937 rng(0);
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    const size_t a_size = rng() % 100;
+    const size_t b_size = rng() % 100;
+    // Dense ranges produce many matches and duplicate runs, sparse ones few.
+    const uint32 limit = iteration % 2 ? 200 : 100000;
+    Set a = RandomSet(a_size, limit, &rng);
+    Set b = RandomSet(b_size, limit, &rng);
+    CheckAll(a, b);
+    if (HasFailure()) return;
+  }
+}
+
+TEST(SortedSetTest, Skewed) {
+  // Sizes on both sides of kGallopRatio.
+  std::mt19937 rng(0);
+  for (size_t small_size : {1, 3, 10, 31, 32, 33, 100}) {
+    Set small = RandomSet(small_size, 50000, &rng);
+    Set large = RandomSet(3200, 50000, &rng);
+    // Also the extremes and elements of the partial last block.
+    small.push_back(large.front());
+    small.push_back(large.back());
+    small.push_back(large[large.size() - 2]);
+    std::sort(small.begin(), small.end());
+    small.erase(std::unique(small.begin(), small.end()), small.end());
+    CheckAll(small, large);
+  }
+}
+
+TEST(SortedSetTest, Runs) {
+  // Long stretches where one array is entirely below the other.
+  Set a, b;
+  for (uint32 i = 0; i < 1000; i++) {
+    (i / 37 % 2 ? a : b).push_back(i);
+    if (i % 5 == 0) (i / 37 % 2 ? b : a).push_back(i);
+  }
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  CheckAll(a, b);
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_STRUCTURAL_H_
+#define DIMSUM_STRUCTURAL_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+#include "search.h"
+
+// Structural indexing of JSON and CSV text, the first stage of simdjson-style
+// parsers.
+//
+// Input is processed in 64-byte chunks. Each chunk is classified into 64-bit
+// masks (quotes, backslashes, operators, whitespace) with cmp_eq and lookup()
+// on NativeSimd<uint8> blocks and to_bitmask. Quoted regions are the prefix XOR
+// of the unescaped quote mask, a carry-less multiply by all ones. The set bits
+// of the resulting structural mask are then appended to an index array.
+
+namespace dimsum {
+namespace detail {
+
+using StructuralBlock = NativeSimd<uint8>;
+
+constexpr size_t kStructuralChunk = 64;
+constexpr size_t kBlocksPerChunk = kStructuralChunk / StructuralBlock::size();
+
+// One 64-byte chunk of input.
+struct StructuralChunk {
+  StructuralBlock blocks[kBlocksPerChunk];
+};
+
+inline StructuralChunk LoadStructuralChunk(const char* p) {
+  StructuralChunk chunk;
+  for (size_t i = 0; i < kBlocksPerChunk; i++) {
+    chunk.blocks[i] =
+        LoadUnaligned<StructuralBlock>(p + i * StructuralBlock::size());
+  }
+  return chunk;
+}
+
+// Returns the 64-bit mask of the bytes of chunk for which classify, which maps
+// a StructuralBlock to a mask, is true.
+template <typename Classify>
+uint64 ChunkMask(const StructuralChunk& chunk, const Classify& classify) {
+  uint64 mask = 0;
+  for (size_t i = 0; i < kBlocksPerChunk; i++) {
+    mask |= to_bitmask(classify(chunk.blocks[i]))
+            << (i * StructuralBlock::size());
+  }
+  return mask;
+}
+
+// Returns r where bit i of r is the XOR of bits [0, i] of bits, i.e. bit i is
+// set iff an odd number of bits at or below i are set. When bits marks quotes,
+// r marks the quoted regions including the opening quotes.
+inline uint64 PrefixXor(uint64 bits) {
+#ifdef DIMSUM_HAS_NATIVE_CLMUL
+  // The low half of the carry-less product with all ones.
+  return x86::clmul<0, 0>(Simd128<uint64>(bits), Simd128<uint64>(~0ull))[0];
+#else
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+#endif
+}
+
+// Returns the mask of characters escaped by an odd-length run of backslashes.
+// *carry is 1 iff the previous chunk ended with an odd-length run, and is
+// updated for the next chunk.
+inline uint64 EscapedMask(uint64 backslash, uint64* carry) {
+  constexpr uint64 kEvenBits = 0x5555555555555555ull;
+  constexpr uint64 kOddBits = ~kEvenBits;
+  uint64 starts = backslash & ~(backslash << 1);
+  // A run continuing from the previous chunk has its parity flipped.
+  uint64 even_start_mask = kEvenBits ^ *carry;
+  uint64 even_starts = starts & even_start_mask;
+  uint64 odd_starts = starts & ~even_start_mask;
+  // Adding the start of a run to the run carries past its end.
+  uint64 even_carries = backslash + even_starts;
+  uint64 odd_carries;
+  bool ends_odd = __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+  odd_carries |= *carry;
+  *carry = ends_odd;
+  uint64 even_carry_ends = even_carries & ~backslash;
+  uint64 odd_carry_ends = odd_carries & ~backslash;
+  return (even_carry_ends & kOddBits) | (odd_carry_ends & kEvenBits);
+}
+
+// Returns the quoted regions of a chunk given its unescaped quotes, including
+// opening quotes and excluding closing ones. *in_quotes is all ones iff the
+// previous chunk ended inside quotes, and is updated for the next chunk.
+inline uint64 QuotedMask(uint64 quotes, uint64* in_quotes) {
+  uint64 quoted = PrefixXor(quotes) ^ *in_quotes;
+  *in_quotes = static_cast<uint64>(static_cast<int64>(quoted) >> 63);
+  return quoted;
+}
+
+// Appends base + i for each set bit i of bits to out and returns the new end.
+// Indices are written in groups of 8 regardless of the number of bits, so up to
+// 7 entries past the new end are overwritten.
+inline uint32* AppendBitIndices(uint64 bits, uint32 base, uint32* out) {
+  if (bits == 0) return out;
+  int count = __builtin_popcountll(bits);
+  // Bit 63 keeps CountTrailingZeros defined once all bits are consumed; the
+  // extra entries are garbage past the new end.
+  constexpr uint64 kGuard = uint64{1} << 63;
+  for (int i = 0; i < 8; i++) {
+    out[i] = base + CountTrailingZeros(bits | kGuard);
+    bits &= bits - 1;
+  }
+  if (count > 8) {
+    for (int i = 8; i < 16; i++) {
+      out[i] = base + CountTrailingZeros(bits | kGuard);
+      bits &= bits - 1;
+    }
+    for (int i = 16; i < count; i++) {
+      out[i] = base + CountTrailingZeros(bits);
+      bits &= bits - 1;
+    }
+  }
+  return out + count;
+}
+
+// Calls index(chunk, base) on the consecutive 64-byte chunks of
+// [data, data + size). The last chunk is padded with spaces.
+template <typename Index>
+void ScanChunks(const char* data, size_t size, Index&& index) {
+  size_t i = 0;
+  for (; i + kStructuralChunk <= size; i += kStructuralChunk) {
+    index(LoadStructuralChunk(data + i), static_cast<uint32>(i));
+  }
+  if (i < size) {
+    char buffer[kStructuralChunk];
+    memset(buffer, ' ', sizeof(buffer));
+    memcpy(buffer, data + i, size - i);
+    index(LoadStructuralChunk(buffer), static_cast<uint32>(i));
+  }
+}
+
+// JSON character classes.
+struct JsonTables {
+  // Compared with the input, matches ' ', '\t', '\n' and '\r'.
+  StructuralBlock whitespace;
+  // Compared with the input | 0x20, matches '{', '}', '[', ']', ':' and ','.
+  StructuralBlock op;
+};
+
+inline const JsonTables& GetJsonTables() {
+  static const JsonTables tables = [] {
+    // Indexed by low nibble. Entries that are not classified chars have a
+    // different low nibble than their index, so they never match.
+    static const uint8 kWhitespace[16] = {' ', 100, 100, 100, 17,  100,
+                                          113, 2,   100, '\t', '\n', 112,
+                                          100, '\r', 100, 100};
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+    static const uint8 kOp[16] = {0,   0,   0,   0,   0,   0,   0,   0,
+                                  0,   0,   ':', '{', ',', '}', 0,   0};
+    JsonTables t;
+    t.whitespace = BroadcastNibbleTable(kWhitespace);
+    t.op = BroadcastNibbleTable(kOp);
+    return t;
+  }();
+  return tables;
+}
+
+}  // namespace detail
+
+// Returns the number of entries the indices array of json_structural_index and
+// csv_structural_index must have room for, for an input of size bytes.
+inline size_t structural_index_capacity(size_t size) { return size + 8; }
+
+// Finds the structural characters of the JSON text [data, data + size) and
+// writes their offsets to indices, in increasing order. These are '{', '}',
+// '[', ']', ':' and ',' outside of strings, the opening quote of each string
+// and the first character of each number, true, false and null.
+//
+// indices must have room for structural_index_capacity(size) entries, and size
+// must be less than 4 GiB. Returns the number of offsets written, or -1 if a
+// string is not terminated or contains an unescaped control character. The
+// text is otherwise not validated.
+inline ptrdiff_t json_structural_index(const char* data, size_t size,
+                                       uint32* indices) {
+  const detail::JsonTables& tables = detail::GetJsonTables();
+  using Block = detail::StructuralBlock;
+  const Block quote(uint8{'"'}), backslash(uint8{'\\'});
+  const Block low_bits(0x0f), lower(0x20);
+  const Block max_control(0x1f), zero(0);
+  uint64 escape_carry = 0;
+  uint64 in_string = 0;
+  // The start of the input counts as following whitespace.
+  uint64 scalar_carry = 1;
+  uint64 control_in_string = 0;
+  uint32* out = indices;
+  detail::ScanChunks(data, size, [&](const detail::StructuralChunk& chunk,
+                                     uint32 base) {
+    uint64 quotes =
+        detail::ChunkMask(chunk, [&](Block b) { return b == quote; });
+    uint64 backslashes =
+        detail::ChunkMask(chunk, [&](Block b) { return b == backslash; });
+    uint64 ops = detail::ChunkMask(chunk, [&](Block b) {
+      return (b | lower) == lookup(tables.op, b & low_bits);
+    });
+    uint64 whitespace = detail::ChunkMask(chunk, [&](Block b) {
+      return b == lookup(tables.whitespace, b & low_bits);
+    });
+    uint64 control = detail::ChunkMask(
+        chunk, [&](Block b) { return sub_saturated(b, max_control) == zero; });
+
+    if (backslashes != 0 || escape_carry != 0) {
+      quotes &= ~detail::EscapedMask(backslashes, &escape_carry);
+    }
+    uint64 strings = detail::QuotedMask(quotes, &in_string);
+    control_in_string |= control & strings;
+
+    // Scalars start after a structural character or whitespace, outside of
+    // strings.
+    uint64 structurals = (ops & ~strings) | quotes;
+    uint64 scalar_pred = structurals | whitespace;
+    uint64 scalar_starts =
+        (scalar_pred << 1 | scalar_carry) & ~whitespace & ~strings;
+    scalar_carry = scalar_pred >> 63;
+    structurals |= scalar_starts;
+    // Drop closing quotes.
+    structurals &= ~(quotes & ~strings);
+    out = detail::AppendBitIndices(structurals, base, out);
+  });
+  if (in_string != 0 || control_in_string != 0) return -1;
+  return out - indices;
+}
+
+// Finds the field separators and line breaks ('\n') of the CSV text
+// [data, data + size) that are not inside quoted fields and writes their
+// offsets to indices, in increasing order. Quotes inside quoted fields are
+// escaped by doubling them, as in RFC 4180.
+//
+// indices must have room for structural_index_capacity(size) entries, and size
+// must be less than 4 GiB. Returns the number of offsets written, or -1 if a
+// quoted field is not terminated.
+inline ptrdiff_t csv_structural_index(const char* data, size_t size,
+                                      char separator, uint32* indices) {
+  using Block = detail::StructuralBlock;
+  const Block quote(uint8{'"'}), newline(uint8{'\n'});
+  const Block sep(static_cast<uint8>(separator));
+  uint64 in_quotes = 0;
+  uint32* out = indices;
+  detail::ScanChunks(data, size, [&](const detail::StructuralChunk& chunk,
+                                     uint32 base) {
+    uint64 quotes =
+        detail::ChunkMask(chunk, [&](Block b) { return b == quote; });
+    uint64 delimiters = detail::ChunkMask(
+        chunk, [&](Block b) { return (b == sep) | (b == newline); });
+    uint64 quoted = detail::QuotedMask(quotes, &in_quotes);
+    out = detail::AppendBitIndices(delimiters & ~quoted, base, out);
+  });
+  if (in_quotes != 0) return -1;
+  return out - indices;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_STRUCTURAL_H_
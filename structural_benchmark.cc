@@ -0,0 +1,169 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "structural.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kCorpusSize = 1 << 20;
+
+// Synthetic stand-ins for the usual JSON corpora, about kCorpusSize bytes each:
+// kTwitter is string heavy with escapes and non-ASCII text like twitter.json,
+// kCanada is number heavy like canada.json, and kCsv is a quoted CSV table.
+enum Corpus { kTwitter, kCanada, kCsv };
+
+std::string RandomWord(std::mt19937* rng) {
+  static const char* const kWords[] = {
+      "dimsum", "simd",  "caf\xc3\xa9", "\xe6\x97\xa5\xe6\x9c\xac",
+      "quote\\\"d", "path\\\\to", "line\\nbreak", "https://t.co/x"};
+  return kWords[(*rng)() % 8];
+}
+
+std::string MakeCorpus(Corpus corpus) {
+  std::mt19937 rng(0);
+  std::string text;
+  if (corpus == kTwitter) text = "[";
+  while (text.size() < kCorpusSize) {
+    switch (corpus) {
+      case kTwitter: {
+        text += "{\"id\": " + std::to_string(rng()) + ", \"text\": \"";
+        for (int i = rng() % 20; i >= 0; i--) text += RandomWord(&rng) + " ";
+        text += "\", \"user\": {\"name\": \"" + RandomWord(&rng) +
+                "\", \"verified\": " + (rng() % 2 ? "true" : "false") +
+                ", \"followers\": " + std::to_string(rng() % 100000) +
+                "}, \"geo\": null},\n";
+        break;
+      }
+      case kCanada: {
+        text += "[[";
+        for (int i = 0; i < 20; i++) {
+          text += "[" + std::to_string(-60 - (rng() % 1000000) * 1e-5) + "," +
+                  std::to_string(40 + (rng() % 1000000) * 1e-5) + "],";
+        }
+        text.back() = ']';
+        text += "],\n";
+        break;
+      }
+      case kCsv: {
+        text += std::to_string(rng()) + ",\"" + RandomWord(&rng) + ", " +
+                RandomWord(&rng) + "\"\"\"," + std::to_string(rng() % 1000) +
+                "\n";
+        break;
+      }
+    }
+  }
+  if (corpus == kTwitter) text += "{}]";
+  return text;
+}
+
+// A byte at a time JSON structural indexer.
+ptrdiff_t ScalarJsonIndex(const char* data, size_t size, uint32* indices) {
+  uint32* out = indices;
+  bool in_string = false;
+  bool escaped = false;
+  bool scalar_pred = true;
+  for (size_t i = 0; i < size; i++) {
+    char c = data[i];
+    if (in_string) {
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        in_string = false;
+        scalar_pred = true;
+      }
+      continue;
+    }
+    switch (c) {
+      case '{': case '}': case '[': case ']': case ':': case ',':
+        *out++ = i;
+        scalar_pred = true;
+        break;
+      case '"':
+        *out++ = i;
+        in_string = true;
+        break;
+      case ' ': case '\t': case '\n': case '\r':
+        scalar_pred = true;
+        break;
+      default:
+        if (scalar_pred) *out++ = i;
+        scalar_pred = false;
+    }
+  }
+  return in_string ? -1 : out - indices;
+}
+
+ptrdiff_t ScalarCsvIndex(const char* data, size_t size, char separator,
+                         uint32* indices) {
+  uint32* out = indices;
+  bool in_quotes = false;
+  for (size_t i = 0; i < size; i++) {
+    char c = data[i];
+    if (c == '"') {
+      in_quotes = !in_quotes;
+    } else if (!in_quotes && (c == separator || c == '\n')) {
+      *out++ = i;
+    }
+  }
+  return in_quotes ? -1 : out - indices;
+}
+
+template <typename Index>
+void RunBenchmark(benchmark::State& state, const Index& index) {
+  std::string text = MakeCorpus(static_cast<Corpus>(state.range(0)));
+  std::vector<uint32> indices(structural_index_capacity(text.size()));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index(text, indices.data()));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_ScalarJsonIndex(benchmark::State& state) {
+  RunBenchmark(state, [](const std::string& text, uint32* indices) {
+    return ScalarJsonIndex(text.data(), text.size(), indices);
+  });
+}
+BENCHMARK(BM_ScalarJsonIndex)->Arg(kTwitter)->Arg(kCanada);
+
+void BM_JsonStructuralIndex(benchmark::State& state) {
+  RunBenchmark(state, [](const std::string& text, uint32* indices) {
+    return json_structural_index(text.data(), text.size(), indices);
+  });
+}
+BENCHMARK(BM_JsonStructuralIndex)->Arg(kTwitter)->Arg(kCanada);
+
+void BM_ScalarCsvIndex(benchmark::State& state) {
+  RunBenchmark(state, [](const std::string& text, uint32* indices) {
+    return ScalarCsvIndex(text.data(), text.size(), ',', indices);
+  });
+}
+BENCHMARK(BM_ScalarCsvIndex)->Arg(kCsv);
+
+void BM_CsvStructuralIndex(benchmark::State& state) {
+  RunBenchmark(state, [](const std::string& text, uint32* indices) {
+    return csv_structural_index(text.data(), text.size(), ',', indices);
+  });
+}
+BENCHMARK(BM_CsvStructuralIndex)->Arg(kCsv);
+
+}  // namespace
+}  // namespace dimsum
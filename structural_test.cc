@@ -0,0 +1,180 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "structural.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+std::vector<uint32> JsonIndex(const std::string& json) {
+  std::vector<uint32> indices(structural_index_capacity(json.size()));
+  ptrdiff_t n = json_structural_index(json.data(), json.size(), indices.data());
+  EXPECT_GE(n, 0) << json;
+  indices.resize(n < 0 ? 0 : n);
+  return indices;
+}
+
+std::vector<uint32> CsvIndex(const std::string& csv, char separator) {
+  std::vector<uint32> indices(structural_index_capacity(csv.size()));
+  ptrdiff_t n =
+      csv_structural_index(csv.data(), csv.size(), separator, indices.data());
+  EXPECT_GE(n, 0) << csv;
+  indices.resize(n < 0 ? 0 : n);
+  return indices;
+}
+
+// Returns the characters at indices.
+std::string At(const std::string& s, const std::vector<uint32>& indices) {
+  std::string chars;
+  for (uint32 i : indices) chars += s[i];
+  return chars;
+}
+
+// A byte at a time version of json_structural_index, without validation.
+std::vector<uint32> ReferenceJsonIndex(const std::string& json) {
+  auto is_whitespace = [](char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  };
+  auto is_op = [](char c) {
+    return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' ||
+           c == ',';
+  };
+  std::vector<uint32> indices;
+  bool in_string = false;
+  int backslashes = 0;
+  bool scalar_pred = true;
+  for (size_t i = 0; i < json.size(); i++) {
+    char c = json[i];
+    bool quote = c == '"' && backslashes % 2 == 0;
+    backslashes = c == '\\' ? backslashes + 1 : 0;
+    bool opening = quote && !in_string;
+    bool closing = quote && in_string;
+    if (quote) in_string = !in_string;
+    bool op = is_op(c) && !in_string && !closing;
+    bool scalar_start = scalar_pred && !is_whitespace(c) && !in_string &&
+                        !closing;
+    if (op || opening || scalar_start) indices.push_back(i);
+    scalar_pred = op || quote || is_whitespace(c);
+  }
+  return indices;
+}
+
+TEST(StructuralTest, PrefixXor) {
+  EXPECT_EQ(0u, detail::PrefixXor(0));
+  EXPECT_EQ(~uint64{0}, detail::PrefixXor(1));
+  EXPECT_EQ(0x0ffull << 4, detail::PrefixXor(1ull << 4 | 1ull << 12));
+  EXPECT_EQ(uint64{1} << 63, detail::PrefixXor(uint64{1} << 63));
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 1000; i++) {
+    uint64 bits = rng();
+    uint64 expected = 0, parity = 0;
+    for (int j = 0; j < 64; j++) {
+      parity ^= bits >> j & 1;
+      expected |= parity << j;
+    }
+    EXPECT_EQ(expected, detail::PrefixXor(bits));
+  }
+}
+
+TEST(StructuralTest, Json) {
+  const std::string json =
+      R"({"a": [1, -2.5e3, true, false, null], "b\"c": {"d": "{,}"}})";
+  std::vector<uint32> indices = JsonIndex(json);
+  EXPECT_EQ(R"({":[1,-,t,f,n],":{":"}})", At(json, indices));
+  EXPECT_EQ(ReferenceJsonIndex(json), indices);
+
+  const std::string spaced = "\t[\r\n1 ,\n\"a b\" ]\n";
+  EXPECT_EQ("[1,\"]", At(spaced, JsonIndex(spaced)));
+  EXPECT_EQ("1", At("123", JsonIndex("123")));
+  EXPECT_EQ("\"", At(" \"x\" ", JsonIndex(" \"x\" ")));
+  EXPECT_TRUE(JsonIndex("").empty());
+}
+
+TEST(StructuralTest, JsonEscapes) {
+  // Runs of backslashes before quotes, with odd and even lengths, across
+  // chunk boundaries.
+  for (int padding = 0; padding < 70; padding++) {
+    for (int run = 0; run < 6; run++) {
+      std::string json = std::string(padding, ' ') + "[\"" +
+                         std::string(run, '\\') + (run % 2 ? "\"" : "") +
+                         "\", 1]";
+      SCOPED_TRACE(json);
+      std::vector<uint32> indices = JsonIndex(json);
+      EXPECT_EQ("[\",1]", At(json, indices));
+      EXPECT_EQ(ReferenceJsonIndex(json), indices);
+    }
+  }
+}
+
+TEST(StructuralTest, JsonRejectsInvalidStrings) {
+  for (const std::string& json : std::vector<std::string>{
+           "\"", "[\"abc]", "[\"a\\\"]", "\"a\nb\"",
+           std::string("\"\0\"", 3),
+           std::string(100, ' ') + "\"\x1f\""}) {
+    std::vector<uint32> indices(structural_index_capacity(json.size()));
+    EXPECT_EQ(-1, json_structural_index(json.data(), json.size(),
+                                        indices.data()))
+        << json;
+  }
+}
+
+TEST(StructuralTest, JsonMatchesReferenceOnRandomInput) {
+  const char kChars[] = "{}[]:,\"\\ x1";
+  std::mt19937 rng(0);
+  for (int i = 0; i < 2000; i++) {
+    std::string json(rng() % 300, ' ');
+    for (char& c : json) c = kChars[rng() % (sizeof(kChars) - 1)];
+    std::vector<uint32> indices(structural_index_capacity(json.size() + 2));
+    if (json_structural_index(json.data(), json.size(), indices.data()) < 0) {
+      // Terminate the last string, even if the space is escaped.
+      json += " \"";
+    }
+    ptrdiff_t n =
+        json_structural_index(json.data(), json.size(), indices.data());
+    ASSERT_GE(n, 0) << json;
+    indices.resize(n);
+    EXPECT_EQ(ReferenceJsonIndex(json), indices) << json;
+  }
+}
+
+TEST(StructuralTest, Csv) {
+  const std::string csv =
+      "name,quote\n"
+      "a,\"x, \"\"y\"\"\nz\"\n"
+      "b,\n";
+  EXPECT_EQ(",\n,\n,\n", At(csv, CsvIndex(csv, ',')));
+  EXPECT_EQ("\n\n\n", At(csv, CsvIndex(csv, '\t')));
+
+  std::string long_csv;
+  for (int i = 0; i < 100; i++) long_csv += "1;\"2;\n\";3\n";
+  std::vector<uint32> indices = CsvIndex(long_csv, ';');
+  ASSERT_EQ(300u, indices.size());
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    EXPECT_EQ(i / 3 * 10 + 1, indices[i]);
+    EXPECT_EQ(i / 3 * 10 + 7, indices[i + 1]);
+    EXPECT_EQ(i / 3 * 10 + 9, indices[i + 2]);
+  }
+
+  uint32 small[16];
+  EXPECT_EQ(-1, csv_structural_index("a,\"b", 4, ',', small));
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -1,10 +1,23 @@
 #!/bin/bash -xe
 
-for ARCH in "--copt=-msse4.1" "--copt=-mavx2" "--copt=-DDIMSUM_USE_SIMULATED"; do
+# -mpclmul enables the clmul paths of x86::clmul, crc32c and structural.h.
+for ARCH in "--copt=-msse4.1" "--copt=-mavx2 --copt=-mpclmul" "--copt=-DDIMSUM_USE_SIMULATED"; do
   for COMPILATION_MODE in "--compilation_mode=fastbuild" "--compilation_mode=opt" "--copt=-fsanitize=address --linkopt=-fsanitize=address"; do
-    CC=clang bazel test "$ARCH" $COMPILATION_MODE ...
+    CC=clang bazel test $ARCH $COMPILATION_MODE ...
 
     # __sanitizer_annotate_contiguous_container in simd does not compile on gcc. Need to fix it in libcxx.
-    #CC=gcc bazel test "$ARCH" $COMPILATION_MODE --copt='-Wno-return-type' --copt='-Wno-sign-compare' ...
+    #CC=gcc bazel test $ARCH $COMPILATION_MODE --copt='-Wno-return-type' --copt='-Wno-sign-compare' ...
   done
+
+  # Results per target, e.g. dimsum_benchmark_msse4.1.json, for comparison
+  # across targets and runs.
+  NAME="${ARCH%% *}"
+  CC=clang bazel run $ARCH --compilation_mode=opt :dimsum_benchmark -- \
+    --benchmark_min_time=0.01 \
+    --benchmark_out="$PWD/dimsum_benchmark_${NAME#--copt=-}.json" \
+    --benchmark_out_format=json
 done
+
+# Fails when an operation generates more code than its budget, e.g. falls
+# back to scalar code. The budgets were measured with GCC.
+python3 utils/codegen_budget.py --cxx=g++
@@ -0,0 +1,413 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_UTF8_H_
+#define DIMSUM_UTF8_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// UTF-8 validation and UTF-8 <=> UTF-16/UTF-32 transcoding.
+//
+// Validation follows the lookup algorithm of Keiser and Lemire, "Validating
+// UTF-8 In Less Than One Instruction Per Byte" (also used by simdjson): every
+// pair of adjacent bytes is classified by three 16-entry tables indexed by
+// nibbles, whose AND is non-zero iff the pair is an error. The remaining
+// errors (missing 3rd/4th continuation bytes) are found by comparing the
+// input shifted by 2 and 3 bytes.
+//
+// Blocks of pure ASCII skip the classification. The transcoders validate
+// first, then convert ASCII blocks with vector widening/narrowing and the rest
+// with a scalar loop.
+
+namespace dimsum {
+namespace detail {
+
+using Utf8Block = NativeSimd<uint8>;
+
+template <size_t kShift, size_t... indices>
+Utf8Block PrevImpl(Utf8Block prev, Utf8Block input,
+                   dimsum::index_sequence<indices...>) {
+  return shuffle<(Utf8Block::size() - kShift + indices)...>(prev, input);
+}
+
+// Returns input shifted towards higher lanes by kShift bytes, with the last
+// kShift bytes of prev shifted in. That is one palignr with SSSE3. AVX2 aligns
+// within 128-bit lanes only, so vperm2i128 first brings the lanes that
+// straddle prev and input together.
+template <size_t kShift>
+Utf8Block Prev(Utf8Block prev, Utf8Block input) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__AVX2__)
+  // Bytes [16, 48) of prev:input.
+  __m256i middle = _mm256_permute2x128_si256(to_raw(prev), to_raw(input), 0x21);
+  return _mm256_alignr_epi8(to_raw(input), middle, 16 - kShift);
+#elif !defined(DIMSUM_USE_SIMULATED) && defined(__SSSE3__)
+  return _mm_alignr_epi8(to_raw(input), to_raw(prev), 16 - kShift);
+#else
+  return PrevImpl<kShift>(prev, input,
+                          dimsum::make_index_sequence<Utf8Block::size()>{});
+#endif
+}
+
+// Error classes of the lookup tables. Each names a pattern of
+// (byte 1, byte 2).
+constexpr uint8 kTooShort = 1 << 0;     // 11______ 0_______, 11______ 11______
+constexpr uint8 kTooLong = 1 << 1;      // 0_______ 10______
+constexpr uint8 kOverlong3 = 1 << 2;    // 11100000 100_____
+constexpr uint8 kTooLarge = 1 << 3;     // 11110100 1001____ and above
+constexpr uint8 kSurrogate = 1 << 4;    // 11101101 101_____
+constexpr uint8 kOverlong2 = 1 << 5;    // 1100000_ 10______
+constexpr uint8 kTooLarge1000 = 1 << 6; // 11110101 1000____ and above
+constexpr uint8 kOverlong4 = 1 << 6;    // 11110000 1000____
+constexpr uint8 kTwoConts = 1 << 7;     // 10______ 10______
+constexpr uint8 kCarry = kTooShort | kTooLong | kTwoConts;
+
+// The constant tables of Utf8Checker.
+struct Utf8Tables {
+  Utf8Tables()
+      : byte_1_high(BroadcastNibbleTable({
+            // 0_______: ASCII.
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            kTooLong, kTooLong,
+            // 10______: continuation.
+            kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+            // 1100____, 1101____: two-byte lead.
+            kTooShort | kOverlong2, kTooShort,
+            // 1110____: three-byte lead.
+            kTooShort | kOverlong3 | kSurrogate,
+            // 1111____: four-byte lead.
+            kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+        })),
+        byte_1_low(BroadcastNibbleTable({
+            // ____0000
+            kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+            // ____0001
+            kCarry | kOverlong2,
+            // ____001_
+            kCarry, kCarry,
+            // ____0100
+            kCarry | kTooLarge,
+            // ____0101, ____011_, ____1___
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+            // ____1101
+            kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+            kCarry | kTooLarge | kTooLarge1000,
+            kCarry | kTooLarge | kTooLarge1000,
+        })),
+        byte_2_high(BroadcastNibbleTable({
+            // 0_______: ASCII.
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            kTooShort, kTooShort,
+            // 1000____
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+                kOverlong4,
+            // 1001____
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+            // 101_____
+            kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+            kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+            // 11______
+            kTooShort, kTooShort, kTooShort, kTooShort,
+        })) {
+    // A lead byte in the last 3 bytes of a block needs continuation bytes
+    // from the next block.
+    uint8 bytes[Utf8Block::size()];
+    for (size_t i = 0; i < Utf8Block::size(); i++) bytes[i] = 0xff;
+    bytes[Utf8Block::size() - 3] = 0xf0 - 1;
+    bytes[Utf8Block::size() - 2] = 0xe0 - 1;
+    bytes[Utf8Block::size() - 1] = 0xc0 - 1;
+    max_value = Utf8Block(bytes, flags::element_aligned);
+  }
+
+  Utf8Block byte_1_high;
+  Utf8Block byte_1_low;
+  Utf8Block byte_2_high;
+  Utf8Block max_value;
+};
+
+inline const Utf8Tables& GetUtf8Tables() {
+  static const Utf8Tables tables;
+  return tables;
+}
+
+class Utf8Checker {
+ public:
+  Utf8Checker()
+      : tables_(GetUtf8Tables()),
+        error_(0),
+        prev_input_(0),
+        prev_incomplete_(0) {}
+
+  void Check(Utf8Block input) {
+    if (x86::movemask(input) == 0) {
+      // ASCII can't complete a sequence started in the previous block.
+      error_ |= prev_incomplete_;
+      prev_incomplete_ = 0;
+    } else {
+      error_ |= CheckMultibyte(input);
+      prev_incomplete_ = sub_saturated(input, tables_.max_value);
+    }
+    prev_input_ = input;
+  }
+
+  // Returns whether all blocks seen so far form valid UTF-8. Truncated
+  // sequences at the end count as errors.
+  bool Finish() {
+    error_ |= prev_incomplete_;
+    return x86::movemask(cmp_ne(error_, Utf8Block(0))) == 0;
+  }
+
+ private:
+  Utf8Block CheckMultibyte(Utf8Block input) const {
+    Utf8Block prev1 = Prev<1>(prev_input_, input);
+    Utf8Block special_cases =
+        lookup(tables_.byte_1_high, HighNibbles(prev1)) &
+        lookup(tables_.byte_1_low, prev1 & Utf8Block(0x0f)) &
+        lookup(tables_.byte_2_high, HighNibbles(input));
+    // Only bytes after 111_____ (resp. 1111____) by 2 (resp. 3) positions end
+    // up with the most significant bit set.
+    Utf8Block is_third_byte =
+        sub_saturated(Prev<2>(prev_input_, input), Utf8Block(0xe0 - 0x80));
+    Utf8Block is_fourth_byte =
+        sub_saturated(Prev<3>(prev_input_, input), Utf8Block(0xf0 - 0x80));
+    Utf8Block must_be_continuation =
+        (is_third_byte | is_fourth_byte) & Utf8Block(0x80);
+    return must_be_continuation ^ special_cases;
+  }
+
+  const Utf8Tables& tables_;
+  Utf8Block error_;
+  Utf8Block prev_input_;
+  Utf8Block prev_incomplete_;
+};
+
+inline bool IsAsciiBlock(Simd128<uint8> block) {
+  return x86::movemask(block) == 0;
+}
+
+// Decodes the code point at p from valid UTF-8 and advances p past it.
+inline uint32 DecodeUtf8(const uint8** p) {
+  const uint8* s = *p;
+  if (s[0] < 0x80) {
+    *p += 1;
+    return s[0];
+  }
+  if (s[0] < 0xe0) {
+    *p += 2;
+    return (s[0] & 0x1f) << 6 | (s[1] & 0x3f);
+  }
+  if (s[0] < 0xf0) {
+    *p += 3;
+    return (s[0] & 0x0f) << 12 | (s[1] & 0x3f) << 6 | (s[2] & 0x3f);
+  }
+  *p += 4;
+  return (s[0] & 0x07) << 18 | (s[1] & 0x3f) << 12 | (s[2] & 0x3f) << 6 |
+         (s[3] & 0x3f);
+}
+
+inline char16_t* EncodeUtf16(uint32 code_point, char16_t* out) {
+  if (code_point < 0x10000) {
+    *out++ = static_cast<char16_t>(code_point);
+  } else {
+    code_point -= 0x10000;
+    *out++ = static_cast<char16_t>(0xd800 + (code_point >> 10));
+    *out++ = static_cast<char16_t>(0xdc00 + (code_point & 0x3ff));
+  }
+  return out;
+}
+
+inline uint8* EncodeUtf8(uint32 code_point, uint8* out) {
+  if (code_point < 0x80) {
+    *out++ = code_point;
+  } else if (code_point < 0x800) {
+    *out++ = 0xc0 | code_point >> 6;
+    *out++ = 0x80 | (code_point & 0x3f);
+  } else if (code_point < 0x10000) {
+    *out++ = 0xe0 | code_point >> 12;
+    *out++ = 0x80 | (code_point >> 6 & 0x3f);
+    *out++ = 0x80 | (code_point & 0x3f);
+  } else {
+    *out++ = 0xf0 | code_point >> 18;
+    *out++ = 0x80 | (code_point >> 12 & 0x3f);
+    *out++ = 0x80 | (code_point >> 6 & 0x3f);
+    *out++ = 0x80 | (code_point & 0x3f);
+  }
+  return out;
+}
+
+// Stores the zero-extended bytes of block to out[0, 16).
+inline void StoreWidened(Simd128<uint8> block, char16_t* out) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE3__)
+  const __m128i zero = _mm_setzero_si128();
+  __m128i* dst = reinterpret_cast<__m128i*>(out);
+  _mm_storeu_si128(dst, _mm_unpacklo_epi8(to_raw(block), zero));
+  _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(to_raw(block), zero));
+#else
+  auto wide = static_simd_cast<uint16>(block);
+  memcpy(out, &wide, sizeof(wide));
+#endif
+}
+
+inline void StoreWidened(Simd128<uint8> block, char32_t* out) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE3__)
+  const __m128i zero = _mm_setzero_si128();
+  __m128i* dst = reinterpret_cast<__m128i*>(out);
+  __m128i lo = _mm_unpacklo_epi8(to_raw(block), zero);
+  __m128i hi = _mm_unpackhi_epi8(to_raw(block), zero);
+  _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+  _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+  _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+  _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+#else
+  auto wide = static_simd_cast<uint32>(block);
+  memcpy(out, &wide, sizeof(wide));
+#endif
+}
+
+// Stores the low bytes of units to out[0, 8).
+inline void StoreNarrowed(Simd128<uint16> units, uint8* out) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE3__)
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                   _mm_packus_epi16(to_raw(units), to_raw(units)));
+#else
+  auto narrow = static_simd_cast<uint8>(units);
+  memcpy(out, &narrow, sizeof(narrow));
+#endif
+}
+
+inline void EncodeUtf16Or32(uint32 code_point, char16_t** out) {
+  *out = EncodeUtf16(code_point, *out);
+}
+
+inline void EncodeUtf16Or32(uint32 code_point, char32_t** out) {
+  *(*out)++ = code_point;
+}
+
+// Converts valid UTF-8 to UTF-16 (Unit = char16_t) or UTF-32
+// (Unit = char32_t). ASCII is widened 16 bytes at a time.
+template <typename Unit>
+size_t ConvertValidUtf8(const char* data, size_t size, Unit* out) {
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  const uint8* end = p + size;
+  Unit* o = out;
+  while (end - p >= 16) {
+    auto block = LoadUnaligned<Simd128<uint8>>(p);
+    if (IsAsciiBlock(block)) {
+      StoreWidened(block, o);
+      p += 16;
+      o += 16;
+      continue;
+    }
+    for (const uint8* stop = p + 16; p < stop;) {
+      EncodeUtf16Or32(DecodeUtf8(&p), &o);
+    }
+  }
+  while (p < end) EncodeUtf16Or32(DecodeUtf8(&p), &o);
+  return o - out;
+}
+
+}  // namespace detail
+
+// Returns whether [data, data + size) is all ASCII.
+inline bool is_ascii(const char* data, size_t size) {
+  using detail::Utf8Block;
+  constexpr size_t kBlock = Utf8Block::size();
+  Utf8Block acc = 0;
+  size_t i = 0;
+  for (; i + kBlock <= size; i += kBlock) {
+    acc |= detail::LoadUnaligned<Utf8Block>(data + i);
+  }
+  bool ascii = x86::movemask(acc) == 0;
+  for (; i < size; i++) ascii &= static_cast<uint8>(data[i]) < 0x80;
+  return ascii;
+}
+
+// Returns whether [data, data + size) is valid UTF-8. Overlong encodings,
+// surrogates (U+D800 to U+DFFF), code points above U+10FFFF and truncated
+// sequences are rejected.
+inline bool validate_utf8(const char* data, size_t size) {
+  using detail::Utf8Block;
+  constexpr size_t kBlock = Utf8Block::size();
+  detail::Utf8Checker checker;
+  size_t i = 0;
+  for (; i + kBlock <= size; i += kBlock) {
+    checker.Check(detail::LoadUnaligned<Utf8Block>(data + i));
+  }
+  if (i < size) {
+    // Zero padding is ASCII, so it doesn't introduce errors.
+    uint8 tail[kBlock] = {};
+    memcpy(tail, data + i, size - i);
+    checker.Check(detail::LoadUnaligned<Utf8Block>(tail));
+  }
+  return checker.Finish();
+}
+
+// Converts UTF-8 to UTF-16. out must have room for size code units. Returns the
+// number of code units written, or -1 if the input is not valid UTF-8.
+inline ptrdiff_t utf8_to_utf16(const char* data, size_t size, char16_t* out) {
+  if (!validate_utf8(data, size)) return -1;
+  return detail::ConvertValidUtf8(data, size, out);
+}
+
+// Converts UTF-8 to UTF-32. out must have room for size code points. Returns
+// the number of code points written, or -1 if the input is not valid UTF-8.
+inline ptrdiff_t utf8_to_utf32(const char* data, size_t size, char32_t* out) {
+  if (!validate_utf8(data, size)) return -1;
+  return detail::ConvertValidUtf8(data, size, out);
+}
+
+// Converts UTF-16 to UTF-8. out must have room for 3 * size bytes. Returns the
+// number of bytes written, or -1 if the input has unpaired surrogates.
+inline ptrdiff_t utf16_to_utf8(const char16_t* data, size_t size, char* out) {
+  const char16_t* p = data;
+  const char16_t* end = data + size;
+  uint8* o = reinterpret_cast<uint8*>(out);
+  while (p < end) {
+    if (end - p >= 8) {
+      auto units = detail::LoadUnaligned<Simd128<uint16>>(p);
+      if (x86::movemask(cmp_eq(units & Simd128<uint16>(0xff80),
+                               Simd128<uint16>(0))) == 0xff) {
+        detail::StoreNarrowed(units, o);
+        p += 8;
+        o += 8;
+        continue;
+      }
+    }
+    uint32 code_point = *p++;
+    if (code_point >= 0xd800 && code_point < 0xe000) {
+      if (code_point >= 0xdc00 || p == end || *p < 0xdc00 || *p >= 0xe000) {
+        return -1;
+      }
+      code_point = 0x10000 + ((code_point - 0xd800) << 10) + (*p++ - 0xdc00);
+    }
+    o = detail::EncodeUtf8(code_point, o);
+  }
+  return o - reinterpret_cast<uint8*>(out);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_UTF8_H_
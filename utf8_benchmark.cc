@@ -0,0 +1,120 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "utf8.h"
+
+namespace dimsum {
+namespace {
+
+enum Corpus { kAscii, kLatin, kCjk, kEmoji };
+
+// About 64 KiB of text made of a repeated sample of each script.
+std::string MakeCorpus(int corpus) {
+  const char* kSamples[] = {
+      "The quick brown fox jumps over the lazy dog. ",
+      "D\xc3\xa9j\xc3\xa0 vu, \xc3\xa7" "a va tr\xc3\xa8s bien, "
+      "gro\xc3\x9f" "e Stra\xc3\x9f" "e. ",
+      "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7\xab\xa0"
+      "\xe3\x80\x82\xe4\xb8\xad\xe6\x96\x87\xe3\x80\x82",
+      "\xf0\x9f\x98\x80\xf0\x9f\x8e\x89\xf0\x9f\x9a\x80\xf0\x9f\x91\x8d ",
+  };
+  std::string text;
+  while (text.size() < (64 << 10)) text += kSamples[corpus];
+  return text;
+}
+
+// Branchy byte-at-a-time validator, as a baseline.
+bool ScalarValidate(const char* data, size_t size) {
+  const uint8* p = reinterpret_cast<const uint8*>(data);
+  const uint8* end = p + size;
+  while (p < end) {
+    uint8 c = *p;
+    if (c < 0x80) {
+      p++;
+      continue;
+    }
+    int n = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : 1;
+    if (c < 0xc2 || c > 0xf4 || end - p <= n) return false;
+    uint32 code_point = c & (0x3f >> n);
+    for (int i = 1; i <= n; i++) {
+      if ((p[i] & 0xc0) != 0x80) return false;
+      code_point = code_point << 6 | (p[i] & 0x3f);
+    }
+    static const uint32 kMin[] = {0, 0x80, 0x800, 0x10000};
+    if (code_point < kMin[n] || code_point > 0x10ffff ||
+        (code_point >= 0xd800 && code_point < 0xe000)) {
+      return false;
+    }
+    p += n + 1;
+  }
+  return true;
+}
+
+void BM_ScalarValidate(benchmark::State& state) {
+  std::string text = MakeCorpus(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ScalarValidate(text.data(), text.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ScalarValidate)->DenseRange(kAscii, kEmoji);
+
+void BM_ValidateUtf8(benchmark::State& state) {
+  std::string text = MakeCorpus(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(validate_utf8(text.data(), text.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ValidateUtf8)->DenseRange(kAscii, kEmoji);
+
+void BM_Utf8ToUtf16(benchmark::State& state) {
+  std::string text = MakeCorpus(state.range(0));
+  std::vector<char16_t> out(text.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utf8_to_utf16(text.data(), text.size(), &out[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Utf8ToUtf16)->DenseRange(kAscii, kEmoji);
+
+void BM_Utf8ToUtf32(benchmark::State& state) {
+  std::string text = MakeCorpus(state.range(0));
+  std::vector<char32_t> out(text.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utf8_to_utf32(text.data(), text.size(), &out[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Utf8ToUtf32)->DenseRange(kAscii, kEmoji);
+
+void BM_Utf16ToUtf8(benchmark::State& state) {
+  std::string text = MakeCorpus(state.range(0));
+  std::vector<char16_t> utf16(text.size());
+  utf16.resize(utf8_to_utf16(text.data(), text.size(), &utf16[0]));
+  std::vector<char> out(3 * utf16.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        utf16_to_utf8(utf16.data(), utf16.size(), &out[0]));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Utf16ToUtf8)->DenseRange(kAscii, kEmoji);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,212 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utf8.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Straightforward scalar validator, following the table in RFC 3629.
+bool ReferenceValidate(const std::string& s) {
+  const uint8* p = reinterpret_cast<const uint8*>(s.data());
+  const uint8* end = p + s.size();
+  while (p < end) {
+    uint8 c = *p++;
+    int n;
+    uint8 lo = 0x80, hi = 0xbf;
+    if (c < 0x80) {
+      continue;
+    } else if (c >= 0xc2 && c <= 0xdf) {
+      n = 1;
+    } else if (c >= 0xe0 && c <= 0xef) {
+      n = 2;
+      if (c == 0xe0) lo = 0xa0;
+      if (c == 0xed) hi = 0x9f;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+      n = 3;
+      if (c == 0xf0) lo = 0x90;
+      if (c == 0xf4) hi = 0x8f;
+    } else {
+      return false;
+    }
+    if (end - p < n) return false;
+    if (*p < lo || *p > hi) return false;
+    for (int i = 1; i < n; i++) {
+      if (p[i] < 0x80 || p[i] > 0xbf) return false;
+    }
+    p += n;
+  }
+  return true;
+}
+
+bool Validate(const std::string& s) {
+  return validate_utf8(s.data(), s.size());
+}
+
+TEST(Utf8Test, IsAscii) {
+  for (size_t size = 0; size < 100; size++) {
+    std::string s(size, 'a');
+    EXPECT_TRUE(is_ascii(s.data(), s.size()));
+    for (size_t i = 0; i < size; i++) {
+      s[i] = '\x80';
+      EXPECT_FALSE(is_ascii(s.data(), s.size()));
+      s[i] = 'a';
+    }
+  }
+}
+
+TEST(Utf8Test, ValidSequences) {
+  const char* kValid[] = {
+      "",
+      "hello",
+      "\xc2\x80",          // U+0080
+      "\xdf\xbf",          // U+07FF
+      "\xe0\xa0\x80",      // U+0800
+      "\xed\x9f\xbf",      // U+D7FF
+      "\xee\x80\x80",      // U+E000
+      "\xef\xbf\xbf",      // U+FFFF
+      "\xf0\x90\x80\x80",  // U+10000
+      "\xf4\x8f\xbf\xbf",  // U+10FFFF
+      "Gr\xc3\xb6\xc3\x9f" "e",
+      "\xe4\xb8\xad\xe6\x96\x87",
+      "\xf0\x9f\x98\x80 \xf0\x9f\x8e\x89",
+  };
+  for (const char* valid : kValid) {
+    EXPECT_TRUE(Validate(valid)) << valid;
+  }
+}
+
+TEST(Utf8Test, InvalidSequences) {
+  const char* kInvalid[] = {
+      "\x80",              // Stray continuation.
+      "\xbf",              // Stray continuation.
+      "\xc0\x80",          // Overlong U+0000.
+      "\xc1\xbf",          // Overlong U+007F.
+      "\xe0\x9f\xbf",      // Overlong U+07FF.
+      "\xf0\x8f\xbf\xbf",  // Overlong U+FFFF.
+      "\xed\xa0\x80",      // U+D800.
+      "\xed\xbf\xbf",      // U+DFFF.
+      "\xf4\x90\x80\x80",  // U+110000.
+      "\xf5\x80\x80\x80",  // Invalid lead byte.
+      "\xff",              // Invalid lead byte.
+      "\xc2",              // Truncated.
+      "\xe0\xa0",          // Truncated.
+      "\xf0\x90\x80",      // Truncated.
+      "\xc2\x41",          // Missing continuation.
+      "\xe0\xa0\x41",      // Missing continuation.
+      "\xf0\x90\x80\x41",  // Missing continuation.
+      "\xc2\x80\x80",      // Too long.
+      "\xf0\x90\x80\x80\x80",
+  };
+  for (const char* invalid : kInvalid) {
+    ASSERT_FALSE(ReferenceValidate(invalid)) << invalid;
+    EXPECT_FALSE(Validate(invalid)) << invalid;
+    // Move the sequence across block boundaries.
+    for (size_t offset = 0; offset < 70; offset++) {
+      std::string s = std::string(offset, 'a') + invalid;
+      EXPECT_FALSE(Validate(s)) << offset << " " << invalid;
+      EXPECT_FALSE(Validate(s + std::string(40, 'b'))) << offset;
+      EXPECT_FALSE(Validate(s + "\xc3\xb6" + std::string(40, 'b'))) << offset;
+    }
+  }
+}
+
+TEST(Utf8Test, MatchesReferenceOnRandomInput) {
+  std::mt19937 rng(0);
+  const std::string kPieces[] = {
+      "a", "\x7f", "\xc3\xb6", "\xe4\xb8\xad", "\xf0\x9f\x98\x80",
+      "\xed\x9f\xbf", "\xf4\x8f\xbf\xbf",
+  };
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    std::string s;
+    int pieces = rng() % 40;
+    for (int i = 0; i < pieces; i++) s += kPieces[rng() % 7];
+    ASSERT_TRUE(Validate(s));
+    if (!s.empty()) s[rng() % s.size()] = rng();
+    EXPECT_EQ(ReferenceValidate(s), Validate(s));
+  }
+}
+
+TEST(Utf8Test, Utf8ToUtf16) {
+  const std::string ascii(100, 'x');
+  std::u16string out(200, 0);
+  EXPECT_EQ(100, utf8_to_utf16(ascii.data(), ascii.size(), &out[0]));
+  EXPECT_EQ(std::u16string(100, u'x'), out.substr(0, 100));
+
+  std::string mixed;
+  std::u16string expected;
+  for (int i = 0; i < 20; i++) {
+    mixed += "abcdefghijklmnopq\xc3\xb6\xe4\xb8\xad\xf0\x9f\x98\x80";
+    expected += u"abcdefghijklmnopqö中\U0001f600";
+  }
+  out.assign(mixed.size(), 0);
+  ptrdiff_t written = utf8_to_utf16(mixed.data(), mixed.size(), &out[0]);
+  EXPECT_EQ(expected, out.substr(0, written));
+
+  std::string invalid = mixed + "\xc0\x80";
+  out.assign(invalid.size(), 0);
+  EXPECT_EQ(-1, utf8_to_utf16(invalid.data(), invalid.size(), &out[0]));
+
+  // Empty input is valid, unlike invalid input.
+  EXPECT_EQ(0, utf8_to_utf16("", 0, &out[0]));
+}
+
+TEST(Utf8Test, Utf8ToUtf32) {
+  std::string mixed;
+  std::u32string expected;
+  for (int i = 0; i < 20; i++) {
+    mixed += "\xf0\x9f\x98\x80 abcdefghijklmnopqrstuvwxyz \xe4\xb8\xad";
+    expected += U"\U0001f600 abcdefghijklmnopqrstuvwxyz 中";
+  }
+  std::u32string out(mixed.size(), 0);
+  ptrdiff_t written = utf8_to_utf32(mixed.data(), mixed.size(), &out[0]);
+  EXPECT_EQ(expected, out.substr(0, written));
+
+  EXPECT_EQ(0, utf8_to_utf32("", 0, &out[0]));
+  EXPECT_EQ(-1, utf8_to_utf32("\xed\xa0\x80", 3, &out[0]));
+}
+
+TEST(Utf8Test, Utf16ToUtf8) {
+  std::u16string input;
+  std::string expected;
+  for (int i = 0; i < 20; i++) {
+    input += u"abcdefghijkö中\U0001f600";
+    expected += "abcdefghijk\xc3\xb6\xe4\xb8\xad\xf0\x9f\x98\x80";
+  }
+  std::string out(3 * input.size(), 0);
+  ptrdiff_t written = utf16_to_utf8(input.data(), input.size(), &out[0]);
+  EXPECT_EQ(expected, out.substr(0, written));
+
+  // Round trip.
+  std::u16string back(written, 0);
+  back.resize(utf8_to_utf16(out.data(), written, &back[0]));
+  EXPECT_EQ(input, back);
+
+  const char16_t kLoneHigh[] = u"abcdefghij\xd800";
+  EXPECT_EQ(-1, utf16_to_utf8(kLoneHigh, 11, &out[0]));
+  const char16_t kLoneLow[] = u"a\xdc00";
+  EXPECT_EQ(-1, utf16_to_utf8(kLoneLow, 2, &out[0]));
+  const char16_t kHighThenAscii[] = u"\xd800" u"abcdefghij";
+  EXPECT_EQ(-1, utf16_to_utf8(kHighThenAscii, 11, &out[0]));
+  EXPECT_EQ(0, utf16_to_utf8(kLoneLow, 0, &out[0]));
+}
+
+}  // namespace
+}  // namespace dimsum
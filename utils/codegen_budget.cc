@@ -0,0 +1,239 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// One function per public operation, element type and width, compiled by
+// utils/codegen_budget.py for each target and checked against the
+// instruction budgets in utils/codegen_budget.txt. Functions are named
+// <op>_<type>_<bits>, where bits is the width of the result (for
+// mul_widened) or of the arguments (for everything else). Converting loads
+// and stores are named <op>_<type>_<memory type>_<bits>, and conversions
+// between element types simd_cast_<type>_<result type>_<bits>, where bits is
+// the width of the wider of the two.
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+using namespace dimsum;
+
+#define FOR_ALL_TYPES(M, N)                                             \
+  M(int8, N) M(uint8, N) M(int16, N) M(uint16, N) M(int32, N)           \
+  M(uint32, N) M(int64, N) M(uint64, N) M(float, N) M(double, N)
+
+#define FOR_INTEGER_TYPES(M, N)                                         \
+  M(int8, N) M(uint8, N) M(int16, N) M(uint16, N) M(int32, N)           \
+  M(uint32, N) M(int64, N) M(uint64, N)
+
+#define FOR_SIGNED_TYPES(M, N) \
+  M(int8, N) M(int16, N) M(int32, N) M(int64, N) M(float, N) M(double, N)
+
+#define FOR_SATURATED_TYPES(M, N) \
+  M(int8, N) M(uint8, N) M(int16, N) M(uint16, N)
+
+#define FOR_FLOAT_TYPES(M, N) M(float, N) M(double, N)
+
+#define FOR_WIDTHS(FOR_TYPES, M) FOR_TYPES(M, 128) FOR_TYPES(M, 256)
+
+#define UNARY(op, expr, T, N)                                      \
+  auto op##_##T##_##N(Simd##N<T> a)->decltype(expr) { return expr; }
+
+#define BINARY(op, expr, T, N)                                     \
+  auto op##_##T##_##N(Simd##N<T> a, Simd##N<T> b)->decltype(expr) { \
+    return expr;                                                   \
+  }
+
+extern "C" {
+
+#define ADD(T, N) BINARY(add, a + b, T, N)
+#define SUB(T, N) BINARY(sub, a - b, T, N)
+#define MUL(T, N) BINARY(mul, a * b, T, N)
+#define MIN(T, N) BINARY(min, min(a, b), T, N)
+#define MAX(T, N) BINARY(max, max(a, b), T, N)
+#define CMP_EQ(T, N) BINARY(cmp_eq, cmp_eq(a, b), T, N)
+#define CMP_NE(T, N) BINARY(cmp_ne, cmp_ne(a, b), T, N)
+#define CMP_LT(T, N) BINARY(cmp_lt, cmp_lt(a, b), T, N)
+#define CMP_LE(T, N) BINARY(cmp_le, cmp_le(a, b), T, N)
+#define CMP_GT(T, N) BINARY(cmp_gt, cmp_gt(a, b), T, N)
+#define CMP_GE(T, N) BINARY(cmp_ge, cmp_ge(a, b), T, N)
+#define HMIN(T, N) UNARY(hmin, hmin(a), T, N)
+#define HMAX(T, N) UNARY(hmax, hmax(a), T, N)
+#define MOVEMASK(T, N) UNARY(movemask, x86::movemask(a), T, N)
+#define BIT_CAST(T, N) UNARY(bit_cast, bit_cast<detail::ToUnsigned<T>>(a), T, N)
+#define BIT_CAST_BYTES(T, N) UNARY(bit_cast_bytes, bit_cast<uint8>(a), T, N)
+#define ZIP(T, N) BINARY(zip, zip(a, b), T, N)
+#define LOAD(T, N)                               \
+  Simd##N<T> load_##T##_##N(const T* p) {        \
+    return Simd##N<T>(p, flags::element_aligned); \
+  }
+#define STORE(T, N)                             \
+  void store_##T##_##N(Simd##N<T> a, T* p) {    \
+    a.copy_to(p, flags::element_aligned);       \
+  }
+
+FOR_WIDTHS(FOR_ALL_TYPES, ADD)
+FOR_WIDTHS(FOR_ALL_TYPES, SUB)
+FOR_WIDTHS(FOR_ALL_TYPES, MUL)
+FOR_WIDTHS(FOR_ALL_TYPES, MIN)
+FOR_WIDTHS(FOR_ALL_TYPES, MAX)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_EQ)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_NE)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_LT)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_LE)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_GT)
+FOR_WIDTHS(FOR_ALL_TYPES, CMP_GE)
+FOR_WIDTHS(FOR_ALL_TYPES, HMIN)
+FOR_WIDTHS(FOR_ALL_TYPES, HMAX)
+FOR_WIDTHS(FOR_ALL_TYPES, MOVEMASK)
+FOR_WIDTHS(FOR_ALL_TYPES, BIT_CAST)
+FOR_WIDTHS(FOR_ALL_TYPES, BIT_CAST_BYTES)
+FOR_WIDTHS(FOR_ALL_TYPES, ZIP)
+FOR_WIDTHS(FOR_ALL_TYPES, LOAD)
+FOR_WIDTHS(FOR_ALL_TYPES, STORE)
+
+#define BIT_AND(T, N) BINARY(bit_and, a & b, T, N)
+#define BIT_OR(T, N) BINARY(bit_or, a | b, T, N)
+#define BIT_XOR(T, N) BINARY(bit_xor, a ^ b, T, N)
+#define BIT_NOT(T, N) UNARY(bit_not, ~a, T, N)
+#define SHL_IMM(T, N) UNARY(shl_imm, a << 3, T, N)
+#define SHR_IMM(T, N) UNARY(shr_imm, a >> 3, T, N)
+#define SHL(T, N)                                             \
+  Simd##N<T> shl_##T##_##N(Simd##N<T> a, int count) {         \
+    return a << count;                                        \
+  }
+#define SHR(T, N)                                             \
+  Simd##N<T> shr_##T##_##N(Simd##N<T> a, int count) {         \
+    return a >> count;                                        \
+  }
+#define SHL_SIMD(T, N) BINARY(shl_simd, a << b, T, N)
+#define SHR_SIMD(T, N) BINARY(shr_simd, a >> b, T, N)
+#define REDUCE_ADD(T, N) \
+  T reduce_add_##T##_##N(Simd##N<T> a) { return reduce_add(a)[0]; }
+
+FOR_WIDTHS(FOR_INTEGER_TYPES, BIT_AND)
+FOR_WIDTHS(FOR_INTEGER_TYPES, BIT_OR)
+FOR_WIDTHS(FOR_INTEGER_TYPES, BIT_XOR)
+FOR_WIDTHS(FOR_INTEGER_TYPES, BIT_NOT)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHL_IMM)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHR_IMM)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHL)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHR)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHL_SIMD)
+FOR_WIDTHS(FOR_INTEGER_TYPES, SHR_SIMD)
+FOR_WIDTHS(FOR_INTEGER_TYPES, REDUCE_ADD)
+
+#define NEGATE(T, N) UNARY(negate, -a, T, N)
+#define ABS(T, N) UNARY(abs, abs(a), T, N)
+
+FOR_WIDTHS(FOR_SIGNED_TYPES, NEGATE)
+FOR_WIDTHS(FOR_SIGNED_TYPES, ABS)
+
+#define ADD_SATURATED(T, N) BINARY(add_saturated, add_saturated(a, b), T, N)
+#define SUB_SATURATED(T, N) BINARY(sub_saturated, sub_saturated(a, b), T, N)
+
+FOR_WIDTHS(FOR_SATURATED_TYPES, ADD_SATURATED)
+FOR_WIDTHS(FOR_SATURATED_TYPES, SUB_SATURATED)
+
+#define DIV(T, N) BINARY(div, a / b, T, N)
+#define SQRT(T, N) UNARY(sqrt, sqrt(a), T, N)
+#define ROUND(T, N) UNARY(round, round(a), T, N)
+#define FMA(T, N)                                                      \
+  Simd##N<T> fma_##T##_##N(Simd##N<T> a, Simd##N<T> b, Simd##N<T> c) { \
+    return fma(a, b, c);                                               \
+  }
+
+FOR_WIDTHS(FOR_FLOAT_TYPES, DIV)
+FOR_WIDTHS(FOR_FLOAT_TYPES, SQRT)
+FOR_WIDTHS(FOR_FLOAT_TYPES, ROUND)
+FOR_WIDTHS(FOR_FLOAT_TYPES, FMA)
+
+#define FLOAT_OPS(T, N)                                                   \
+  UNARY(reciprocal_estimate, reciprocal_estimate(a), T, N)               \
+  UNARY(reciprocal_sqrt_estimate, reciprocal_sqrt_estimate(a), T, N)     \
+  UNARY(round_to_integer, round_to_integer<int32>(a), T, N)              \
+  UNARY(static_simd_cast, static_simd_cast<int32>(a), T, N)
+#define INT32_OPS(T, N) \
+  UNARY(static_simd_cast, static_simd_cast<float>(a), T, N)
+#define LOOKUP(T, N) BINARY(lookup, lookup(a, b), T, N)
+#define CLMUL(T, N) BINARY(clmul, (x86::clmul<0, 1>(a, b)), T, N)
+#define MUL_SUM(T, N)                                                      \
+  Simd##N<int32> mul_sum_##T##_##N(Simd##N<T> a, Simd##N<T> b,             \
+                                   Simd##N<int32> acc) {                   \
+    return mul_sum<int32>(a, b, acc);                                      \
+  }
+#define MUL_WIDENED(T, N)                                               \
+  auto mul_widened_##T##_##N(NativeSimd<T, N / 16 / sizeof(T)> a,       \
+                             NativeSimd<T, N / 16 / sizeof(T)> b)       \
+      ->decltype(mul_widened(a, b)) {                                   \
+    return mul_widened(a, b);                                           \
+  }
+#define FOR_NARROW_INTEGER_TYPES(M, N) \
+  M(int8, N) M(uint8, N) M(int16, N) M(uint16, N) M(int32, N) M(uint32, N)
+
+FLOAT_OPS(float, 128) FLOAT_OPS(float, 256)
+INT32_OPS(int32, 128) INT32_OPS(int32, 256)
+LOOKUP(uint8, 128) LOOKUP(uint8, 256)
+CLMUL(uint64, 128) CLMUL(uint64, 256)
+MUL_SUM(int16, 128) MUL_SUM(int16, 256)
+FOR_WIDTHS(FOR_NARROW_INTEGER_TYPES, MUL_WIDENED)
+
+#define LOAD_CONVERTED(T, Src, N)                                   \
+  Simd##N<T> load_converted_##T##_##Src##_##N(const Src* p) {       \
+    return load_converted<Simd##N<T>>(p);                           \
+  }
+#define STORE_CONVERTED(T, Dest, N)                                 \
+  void store_converted_##T##_##Dest##_##N(Simd##N<T> a, Dest* p) {  \
+    store_converted(a, p);                                          \
+  }
+#define STORE_SATURATED(T, Dest, N)                                 \
+  void store_saturated_##T##_##Dest##_##N(Simd##N<T> a, Dest* p) {  \
+    store_saturated(a, p);                                          \
+  }
+#define CONVERSIONS(N)                                                    \
+  LOAD_CONVERTED(float, int8, N) LOAD_CONVERTED(float, uint8, N)          \
+  LOAD_CONVERTED(float, int16, N) LOAD_CONVERTED(float, uint16, N)        \
+  LOAD_CONVERTED(float, int32, N) LOAD_CONVERTED(int32, int8, N)          \
+  LOAD_CONVERTED(int32, uint8, N) LOAD_CONVERTED(int32, int16, N)         \
+  LOAD_CONVERTED(int32, uint16, N) LOAD_CONVERTED(int16, int8, N)         \
+  LOAD_CONVERTED(int16, uint8, N) LOAD_CONVERTED(uint16, uint8, N)        \
+  STORE_CONVERTED(float, int32, N) STORE_CONVERTED(float, int16, N)       \
+  STORE_CONVERTED(float, uint16, N) STORE_CONVERTED(float, int8, N)       \
+  STORE_CONVERTED(float, uint8, N) STORE_SATURATED(int32, int16, N)       \
+  STORE_SATURATED(int32, uint16, N) STORE_SATURATED(int32, int8, N)       \
+  STORE_SATURATED(int32, uint8, N) STORE_SATURATED(int16, int8, N)        \
+  STORE_SATURATED(int16, uint8, N) STORE_SATURATED(float, int16, N)       \
+  STORE_SATURATED(float, uint16, N) STORE_SATURATED(float, int8, N)       \
+  STORE_SATURATED(float, uint8, N)
+
+CONVERSIONS(128) CONVERSIONS(256)
+
+#define SIMD_CAST(T, Dest, N)                                              \
+  auto simd_cast_##T##_##Dest##_##N(                                       \
+      NativeSimd<T, N / 8 / (sizeof(T) > sizeof(Dest) ? sizeof(T)          \
+                                                       : sizeof(Dest))> a) \
+      ->decltype(static_simd_cast<Dest>(a)) {                              \
+    return static_simd_cast<Dest>(a);                                      \
+  }
+#define SIMD_CASTS(N)                                                    \
+  SIMD_CAST(int8, int16, N) SIMD_CAST(uint8, uint16, N)                  \
+  SIMD_CAST(int16, int32, N) SIMD_CAST(uint16, uint32, N)                \
+  SIMD_CAST(int32, int64, N) SIMD_CAST(uint32, uint64, N)                \
+  SIMD_CAST(int16, int8, N) SIMD_CAST(uint16, uint8, N)                  \
+  SIMD_CAST(int32, int16, N) SIMD_CAST(uint32, uint16, N)                \
+  SIMD_CAST(int64, int32, N) SIMD_CAST(uint64, uint32, N)                \
+  SIMD_CAST(int32, float, N) SIMD_CAST(uint32, float, N)                 \
+  SIMD_CAST(float, int32, N) SIMD_CAST(int64, double, N)                 \
+  SIMD_CAST(double, int64, N)
+
+SIMD_CASTS(128) SIMD_CASTS(256)
+
+}  // extern "C"
@@ -0,0 +1,316 @@
+#!/usr/bin/env python3
+# Copyright 2017 Google Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Checks the generated code of dimsum operations against budgets.
+
+Compiles utils/codegen_budget.cc to assembly for each target, and fails if a
+function has more instructions than its budget in utils/codegen_budget.txt,
+or calls a function or loops without the budget allowing it. Unlike the exact
+FileCheck assertions of clang_integration_test.cc, budgets leave headroom for
+compiler differences, and catch what matters: an operation falling back to
+scalar code, a loop or a libm call.
+
+A function is counted together with the template helpers it calls that were
+not inlined, since what the compiler inlines depends on the rest of the file.
+Only calls to functions defined elsewhere, e.g. in libm, count as calls.
+
+Usage:
+  utils/codegen_budget.py [--cxx=g++] [--target=avx2]... [--update]
+
+Budgets depend on the compiler, so check them with the one they were measured
+with, named in utils/codegen_budget.txt. Targets whose architecture differs
+from the host are compiled with --target=<triple> when the compiler is clang,
+and with <triple>-g++ otherwise; they are skipped when no such compiler is
+found, or when it fails, e.g. without a sysroot. --update rewrites the
+budgets of the compiled targets from the measured code, with headroom, keeping
+the others. Budgets marked +tight get no headroom, and pin code that must
+not grow at all, e.g. a specialization that replaces a longer generic one.
+
+The aarch64 column stays "-" until --update --target=aarch64 is run where an
+aarch64 cross compiler exists, e.g. aarch64-linux-gnu-g++.
+"""
+
+import argparse
+import os
+import platform
+import re
+import shutil
+import subprocess
+import sys
+
+UTILS_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.dirname(UTILS_DIR)
+SOURCE = os.path.join(UTILS_DIR, 'codegen_budget.cc')
+BUDGETS = os.path.join(UTILS_DIR, 'codegen_budget.txt')
+
+# (name, architecture, flags), in the column order of the budget table.
+TARGETS = [
+    ('sse4.2', 'x86_64', ['-msse4.2']),
+    ('avx2', 'x86_64', ['-mavx2', '-mfma', '-mpclmul', '-mvpclmulqdq']),
+    ('avx512', 'x86_64',
+     ['-mavx512f', '-mavx512vl', '-mavx512bw', '-mavx512dq', '-mfma',
+      '-mpclmul', '-mvpclmulqdq']),
+    ('aarch64', 'aarch64', ['-DDIMSUM_USE_ARM']),
+]
+
+COMMON_FLAGS = [
+    '-x', 'c++', '-std=c++11', '-O2', '-S', '-o', '-',
+    '-fno-asynchronous-unwind-tables', '-fno-exceptions', '-w', '-Wno-psabi',
+    # The simd header relies on these being included transitively, which is
+    # not the case with libstdc++.
+    '-include', 'cstdint', '-include', 'string',
+    '-I', ROOT_DIR,
+]
+
+CALL_MNEMONICS = {
+    'x86_64': ('call',),
+    'aarch64': ('bl', 'blr'),
+}
+JUMP_MNEMONICS = {
+    'x86_64': ('jmp',),
+    'aarch64': ('b', 'br'),
+}
+# Mnemonics of conditional branches.
+BRANCH_PATTERN = {
+    'x86_64': re.compile(r'^j[a-z]+$'),
+    'aarch64': re.compile(r'^(b\.[a-z]+|cbn?z|tbn?z)$'),
+}
+
+
+class Budget(object):
+  """The allowed instruction count, calls and loops of a function."""
+
+  def __init__(self, instructions, calls=False, loops=False, tight=False):
+    self.instructions = instructions
+    self.calls = calls
+    self.loops = loops
+    self.tight = tight
+
+  @staticmethod
+  def parse(cell):
+    if cell == '-':
+      return None
+    parts = cell.split('+')
+    flags = set(parts[1:])
+    if not flags <= {'call', 'loop', 'tight'}:
+      raise ValueError('unknown budget flag in %r' % cell)
+    return Budget(int(parts[0]), 'call' in flags, 'loop' in flags,
+                  'tight' in flags)
+
+  def __str__(self):
+    if self is None:
+      return '-'
+    return str(self.instructions) + ('+call' if self.calls else '') + (
+        '+loop' if self.loops else '') + ('+tight' if self.tight else '')
+
+
+class Code(object):
+  """What the compiler generated for a function."""
+
+  def __init__(self):
+    self.instructions = 0
+    self.lines = []
+    self.calls = []
+    self.loops = []
+
+
+def find_compiler(cxx, arch):
+  """Returns the compiler command for arch, or None."""
+  if platform.machine() == arch:
+    return [cxx]
+  if 'clang' in os.path.basename(cxx):
+    return [cxx, '--target=%s-linux-gnu' % arch]
+  cross = '%s-linux-gnu-g++' % arch
+  return [cross] if shutil.which(cross) else None
+
+
+def compile_assembly(cxx, target, arch, flags):
+  """Returns the assembly of SOURCE for target, or None after printing why it
+  was skipped. Cross compilation is skipped when it fails, e.g. without a
+  sysroot, while host compilation errors are raised."""
+  compiler = find_compiler(cxx, arch)
+  if compiler is None:
+    print('%s: skipped, no compiler for %s' % (target, arch))
+    return None
+  command = compiler + COMMON_FLAGS + flags + [SOURCE]
+  if platform.machine() == arch:
+    return subprocess.check_output(command, universal_newlines=True)
+  try:
+    return subprocess.check_output(command, universal_newlines=True)
+  except (OSError, subprocess.CalledProcessError):
+    print('%s: skipped, %s failed for %s' % (target, ' '.join(compiler), arch))
+    return None
+
+
+def strip_comment(line):
+  for marker in ('#', '//'):
+    index = line.find(marker)
+    if index >= 0:
+      line = line[:index]
+  return line.strip()
+
+
+def parse_assembly(assembly, arch):
+  """Returns a dict from each function defined in assembly to its Code."""
+  functions = {}
+  code = None
+  labels = set()
+  for raw_line in assembly.splitlines():
+    line = strip_comment(raw_line)
+    if not line:
+      continue
+    if line.endswith(':'):
+      label = line[:-1]
+      if not label.startswith('.'):
+        code = functions[label] = Code()
+        labels = set()
+      elif code is not None:
+        labels.add(label)
+      continue
+    if code is None:
+      continue
+    if line.startswith('.size') or line.startswith('.cfi_endproc'):
+      code = None
+      continue
+    if line.startswith('.'):
+      continue
+    fields = line.split(None, 1)
+    mnemonic = fields[0]
+    operand = fields[1].split(',')[-1].strip() if len(fields) > 1 else ''
+    code.instructions += 1
+    code.lines.append(line)
+    if mnemonic in CALL_MNEMONICS[arch]:
+      code.calls.append(operand)
+    elif mnemonic in JUMP_MNEMONICS[arch] or BRANCH_PATTERN[arch].match(
+        mnemonic):
+      if operand in labels:
+        code.loops.append(operand)
+      elif mnemonic in JUMP_MNEMONICS[arch] and not operand.startswith('.L'):
+        # A tail call.
+        code.calls.append(operand)
+  return functions
+
+
+def total_code(functions, name):
+  """Returns the Code of name together with the functions of the same
+  assembly it calls, directly or not, so that counts don't depend on what the
+  compiler inlines. Only calls to other functions are kept."""
+  total = Code()
+  pending = [name]
+  seen = set(pending)
+  while pending:
+    code = functions[pending.pop()]
+    total.instructions += code.instructions
+    total.loops.extend(code.loops)
+    for callee in code.calls:
+      callee = callee.split('@')[0]
+      if callee not in functions:
+        total.calls.append(callee)
+      elif callee not in seen:
+        seen.add(callee)
+        pending.append(callee)
+  return total
+
+
+def read_budgets():
+  """Returns the header comments, and a list of (function, cells)."""
+  header = []
+  rows = []
+  with open(BUDGETS) as f:
+    for line in f:
+      if line.startswith('#') or not line.strip():
+        if not rows and not line.startswith('# function'):
+          header.append(line)
+        continue
+      fields = line.split()
+      if len(fields) != 1 + len(TARGETS):
+        raise ValueError('malformed budget line: %r' % line)
+      rows.append((fields[0], fields[1:]))
+  return header, rows
+
+
+def write_budgets(header, rows):
+  titles = ['# function'] + [name for name, _, _ in TARGETS]
+  table = [titles] + [[name] + cells for name, cells in rows]
+  # Wide enough for most cells, so that changing one rarely moves the others.
+  widths = [max([14] + [len(row[i]) + 2 for row in table])
+            for i in range(len(titles))]
+  with open(BUDGETS, 'w') as f:
+    f.writelines(header)
+    for row in table:
+      f.write(''.join(cell.ljust(width)
+                      for cell, width in zip(row, widths)).rstrip() + '\n')
+
+
+def with_headroom(code, tight=False):
+  instructions = code.instructions
+  if not tight:
+    instructions += max(1, code.instructions // 4)
+  return str(Budget(instructions, bool(code.calls), bool(code.loops), tight))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--cxx', default=os.environ.get('CXX', 'g++'))
+  parser.add_argument('--target', action='append',
+                      choices=[name for name, _, _ in TARGETS])
+  parser.add_argument('--update', action='store_true')
+  args = parser.parse_args()
+
+  header, rows = read_budgets()
+  names = set(name for name, _ in rows)
+  failures = []
+  for column, (target, arch, flags) in enumerate(TARGETS):
+    if args.target and target not in args.target:
+      continue
+    assembly = compile_assembly(args.cxx, target, arch, flags)
+    if assembly is None:
+      continue
+    functions = parse_assembly(assembly, arch)
+    for name in sorted(set(functions) - names):
+      if not name.startswith('_') and '.' not in name:
+        failures.append('%s: %s has no budget' % (target, name))
+    for name, cells in rows:
+      if name not in functions:
+        failures.append('%s: %s is not defined' % (target, name))
+        continue
+      code = total_code(functions, name)
+      budget = Budget.parse(cells[column])
+      if args.update:
+        cells[column] = with_headroom(code, budget is not None and budget.tight)
+        continue
+      if budget is None:
+        continue
+      problems = []
+      if code.instructions > budget.instructions:
+        problems.append('%d instructions' % code.instructions)
+      if code.calls and not budget.calls:
+        problems.append('calls ' + ', '.join(code.calls))
+      if code.loops and not budget.loops:
+        problems.append('loops')
+      if problems:
+        failures.append('%s: %s over budget %s: %s' %
+                        (target, name, cells[column], '; '.join(problems)))
+    print('%s: checked %d functions' % (target, len(rows)))
+
+  if args.update:
+    write_budgets(header, rows)
+  for failure in failures:
+    print(failure)
+  return 1 if failures else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
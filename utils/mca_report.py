@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# Copyright 2017 Google Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Writes the llvm-mca throughput and latency of dimsum operations.
+
+Compiles the functions of utils/codegen_budget.cc to assembly for each target
+like utils/codegen_budget.py, and runs llvm-mca on the code of each function
+for the CPUs of the target. utils/mca_report.md gets one row per function,
+and one column per target and CPU with:
+
+  reciprocal throughput / latency
+
+in cycles. The reciprocal throughput is llvm-mca's "Block RThroughput", the
+cycles per call when calls are independent. The latency is the cycles from
+the first instruction starting to the last one finishing, with all arguments
+ready. Functions that call or loop are not modeled, and show "call" or
+"loop"; functions without code show "0 / 0".
+
+Usage:
+  utils/mca_report.py [--cxx=g++] [--mca=llvm-mca] [--target=avx2]...
+
+The columns of targets that are not compiled, e.g. without a cross compiler,
+are kept from the existing report.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import codegen_budget
+
+REPORT = os.path.join(codegen_budget.UTILS_DIR, 'mca_report.md')
+
+# The CPUs modeled for each target of codegen_budget.TARGETS.
+CPUS = {
+    'sse4.2': ['skylake', 'icelake-server', 'znver3'],
+    'avx2': ['skylake', 'icelake-server', 'znver3'],
+    'avx512': ['icelake-server'],
+    'aarch64': ['neoverse-n1'],
+}
+
+TRIPLES = {
+    'x86_64': 'x86_64-linux-gnu',
+    'aarch64': 'aarch64-linux-gnu',
+}
+COMMENTS = {
+    'x86_64': '#',
+    'aarch64': '//',
+}
+
+# Instructions returning from a function, which are left out of its code.
+RETURNS = {
+    'x86_64': ('ret',),
+    'aarch64': ('ret',),
+}
+
+
+def columns():
+  return [(target, cpu)
+          for target, _, _ in codegen_budget.TARGETS
+          for cpu in CPUS[target]]
+
+
+def column_title(column):
+  return '%s %s' % column
+
+
+def regions(functions, arch):
+  """Returns the assembly of the modeled functions, one llvm-mca region each,
+  and the cells of the others."""
+  comment = COMMENTS[arch]
+  lines = []
+  cells = {}
+  for name in sorted(functions):
+    code = functions[name]
+    if code.calls:
+      cells[name] = 'call'
+      continue
+    if code.loops:
+      cells[name] = 'loop'
+      continue
+    body = [line for line in code.lines
+            if line.split()[0] not in RETURNS[arch]]
+    if not body:
+      cells[name] = '0 / 0'
+      continue
+    lines.append('%s LLVM-MCA-BEGIN %s' % (comment, name))
+    lines.extend(body)
+    lines.append('%s LLVM-MCA-END' % comment)
+  return '\n'.join(lines) + '\n', cells
+
+
+def latency(total_cycles, timeline):
+  """Returns the cycles from the first instruction starting to the last one
+  finishing, from the rows of a timeline view of one iteration."""
+  start = total_cycles
+  end = 0
+  for row in timeline:
+    cycles = row[:total_cycles]
+    executing = [i for i, c in enumerate(cycles) if c in 'eE']
+    if executing:
+      start = min(start, executing[0])
+    if 'E' in cycles:
+      end = max(end, cycles.rindex('E'))
+  return max(0, end - start)
+
+
+def parse_mca(output):
+  """Returns a dict from each region of the llvm-mca output to its cell."""
+  cells = {}
+  for section in re.split(r'^\[\d+\] Code Region - ', output,
+                          flags=re.MULTILINE)[1:]:
+    name = section.split('\n', 1)[0].strip()
+    total_cycles = int(re.search(r'^Total Cycles:\s+(\d+)', section,
+                                 re.MULTILINE).group(1))
+    rthroughput = float(re.search(r'^Block RThroughput:\s+([\d.]+)', section,
+                                  re.MULTILINE).group(1))
+    # Rows are '[0,<index>]', padded to the width of 'Index     '.
+    timeline = [line[len('Index     '):]
+                for line in section.splitlines()
+                if re.match(r'^\[0,\d+\]', line)]
+    cells[name] = '%g / %d' % (rthroughput, latency(total_cycles, timeline))
+  return cells
+
+
+def read_report():
+  """Returns a dict from each column title to a dict from function to cell."""
+  report = {}
+  if not os.path.exists(REPORT):
+    return report
+  titles = None
+  with open(REPORT) as f:
+    for line in f:
+      if not line.startswith('|'):
+        continue
+      fields = [field.strip() for field in line.strip().strip('|').split('|')]
+      if titles is None:
+        titles = fields
+        report = dict((title, {}) for title in titles[1:])
+      elif not fields[0].startswith('-'):
+        for title, cell in zip(titles[1:], fields[1:]):
+          report[title][fields[0]] = cell
+  return report
+
+
+def write_report(report, names):
+  titles = [column_title(column) for column in columns()]
+  with open(REPORT, 'w') as f:
+    f.write('# llvm-mca report\n\n'
+            'Reciprocal throughput / latency in cycles of each function of\n'
+            '[codegen_budget.cc](codegen_budget.cc), generated by\n'
+            '[mca_report.py](mca_report.py), which describes the columns.\n'
+            'Cells are "-" for targets that were not compiled.\n\n')
+    f.write('| function | ' + ' | '.join(titles) + ' |\n')
+    f.write('|---' * (len(titles) + 1) + '|\n')
+    for name in sorted(names):
+      cells = [report.get(title, {}).get(name, '-') for title in titles]
+      f.write('| %s | %s |\n' % (name, ' | '.join(cells)))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--cxx', default=os.environ.get('CXX', 'g++'))
+  parser.add_argument('--mca', default='llvm-mca')
+  parser.add_argument('--target', action='append', choices=list(CPUS))
+  args = parser.parse_args()
+
+  _, rows = codegen_budget.read_budgets()
+  names = set(name for name, _ in rows)
+  report = read_report()
+  for target, arch, flags in codegen_budget.TARGETS:
+    if args.target and target not in args.target:
+      continue
+    assembly = codegen_budget.compile_assembly(args.cxx, target, arch, flags)
+    if assembly is None:
+      continue
+    functions = codegen_budget.parse_assembly(assembly, arch)
+    functions = dict((name, functions[name]) for name in names)
+    source, unmodeled = regions(functions, arch)
+    for cpu in CPUS[target]:
+      output = subprocess.check_output(
+          [args.mca, '-mtriple=' + TRIPLES[arch], '-mcpu=' + cpu,
+           '-iterations=1', '-timeline', '-timeline-max-cycles=0',
+           '-dispatch-stats=false', '-instruction-info=false',
+           '-resource-pressure=false'],
+          input=source, universal_newlines=True)
+      cells = parse_mca(output)
+      cells.update(unmodeled)
+      report[column_title((target, cpu))] = cells
+      print('%s %s: modeled %d functions' % (target, cpu, len(cells)))
+
+  write_report(report, names)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
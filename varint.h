@@ -0,0 +1,404 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_VARINT_H_
+#define DIMSUM_VARINT_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Variable-length encodings of uint32 values: Stream VByte, and LEB128
+// varints.
+//
+// Stream VByte (Lemire et al., "Stream VByte: Faster Byte-Oriented Integer
+// Compression") stores each value in 1 to 4 little-endian bytes. The lengths
+// of a group of 4 values are packed into a control byte; all control bytes
+// come first, followed by all data bytes. A group is decoded with a single
+// lookup() of the next 16 data bytes, by a pattern selected by its control
+// byte; with AVX2, two groups are decoded by one lookup(). The delta variants
+// store the differences between consecutive values, and decode them with a
+// prefix sum.
+//
+// LEB128 varints store 7 bits per byte, least significant first, with the
+// high bit set on all but the last byte. They are decoded in the style of
+// masked VByte (Plaisance et al., "Vectorized VByte Decoding"): the
+// continuation bits of 64 bytes at a time are gathered into a uint64 with
+// movemask. If the next 16 bits are clear, 16 one-byte values are widened at
+// once. Otherwise the next 8 bits index a table with the number of values of
+// at most 4 bytes that end in those 8 bytes (up to 4), their total length,
+// and a lookup() pattern that moves each to a uint32 lane, where the 7-bit
+// groups are joined with shifts.
+//
+// Encoding is scalar.
+
+namespace dimsum {
+namespace detail {
+
+using VByteBlock = Simd128<uint8>;
+using VByteValues = Simd128<uint32>;
+
+struct VByteTables {
+  VByteTables() {
+    for (int control = 0; control < 256; control++) {
+      uint8 indices[16];
+      int offset = 0;
+      for (int lane = 0; lane < 4; lane++) {
+        const int length = (control >> (2 * lane) & 3) + 1;
+        for (int byte = 0; byte < 4; byte++) {
+          indices[4 * lane + byte] = byte < length ? offset + byte : 0x80;
+        }
+        offset += length;
+      }
+      stream_shuffle[control] = VByteBlock(indices, flags::element_aligned);
+      stream_length[control] = offset;
+    }
+    for (int mask = 0; mask < 256; mask++) {
+      uint8 indices[16];
+      for (int i = 0; i < 16; i++) indices[i] = 0x80;
+      int count = 0, begin = 0;
+      for (int end = 0; end < 8 && count < 4; end++) {
+        if (mask & 1 << end) continue;
+        // A value ends at byte end.
+        if (end - begin >= 4) break;
+        for (int byte = begin; byte <= end; byte++) {
+          indices[4 * count + byte - begin] = byte;
+        }
+        count++;
+        begin = end + 1;
+      }
+      varint_shuffle[mask] = VByteBlock(indices, flags::element_aligned);
+      varint_count[mask] = count;
+      varint_length[mask] = begin;
+    }
+    for (int k = 0; k < 4; k++) {
+      uint8 indices[16];
+      for (int i = 0; i < 16; i++) {
+        indices[i] = i % 4 == 0 ? 4 * k + i / 4 : 0x80;
+      }
+      widen[k] = VByteBlock(indices, flags::element_aligned);
+    }
+  }
+
+  // Moves the data bytes of a Stream VByte group with the given control byte
+  // to their uint32 lanes.
+  VByteBlock stream_shuffle[256];
+  // The number of data bytes of a group.
+  uint8 stream_length[256];
+  // Indexed by the continuation bits of the next 8 bytes: moves the bytes of
+  // the first varint_count values to their uint32 lanes. The values take
+  // varint_length bytes.
+  VByteBlock varint_shuffle[256];
+  uint8 varint_count[256];
+  uint8 varint_length[256];
+  // widen[k] moves bytes [4k, 4k + 4) to the low bytes of the uint32 lanes.
+  VByteBlock widen[4];
+};
+
+inline const VByteTables& GetVByteTables() {
+  static const VByteTables tables;
+  return tables;
+}
+
+// Returns {0, values[0], values[1], values[2]}: a pslldq byte shift on x86, in
+// the prefix sum of each delta group.
+inline VByteValues ShiftVByteLanes(VByteValues values) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_1__)
+  return _mm_slli_si128(to_raw(values), 4);
+#else
+  return shuffle<0, 4, 5, 6>(VByteValues(0), values);
+#endif
+}
+
+inline VByteValues ShiftVByteLanesBy2(VByteValues values) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_1__)
+  return _mm_slli_si128(to_raw(values), 8);
+#else
+  return shuffle<0, 1, 4, 5>(VByteValues(0), values);
+#endif
+}
+
+// Returns {values[3], values[3], values[3], values[3]}.
+inline VByteValues BroadcastLastVByteLane(VByteValues values) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__SSE4_1__)
+  return _mm_shuffle_epi32(to_raw(values), 0xff);
+#else
+  return shuffle<3, 3, 3, 3>(values);
+#endif
+}
+
+// Returns {lo, hi}.
+inline Simd256<uint8> ConcatVByteBlocks(VByteBlock lo, VByteBlock hi) {
+#if !defined(DIMSUM_USE_SIMULATED) && defined(__AVX2__)
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(to_raw(lo)),
+                                 to_raw(hi), 1);
+#else
+  return concat(lo, hi);
+#endif
+}
+
+// Returns prev + the inclusive prefix sums of deltas, where prev has the
+// previous value in all lanes.
+inline VByteValues PrefixSumVByte(VByteValues deltas, VByteValues prev) {
+  deltas += ShiftVByteLanes(deltas);
+  deltas += ShiftVByteLanesBy2(deltas);
+  return deltas + prev;
+}
+
+inline size_t StreamVByteLength(uint32 value) {
+  if (value < (1u << 8)) return 1;
+  if (value < (1u << 16)) return 2;
+  return value < (1u << 24) ? 3 : 4;
+}
+
+// Decodes two groups at a time, one in each 16-byte segment of a lookup(),
+// while [data, end) has 32 bytes. Returns the number of values decoded and
+// advances data. Only instantiated where lookup() of 32 bytes is native.
+template <typename Block = Simd256<uint8>>
+size_t StreamVByteDecodePairs(const uint8* controls, const char*& data,
+                              const char* end, size_t n, uint32* out,
+                              std::true_type /* native 32 bytes */) {
+  const VByteTables& tables = GetVByteTables();
+  size_t i = 0;
+  for (; i + 8 <= n && end - data >= 32; i += 8) {
+    const uint8 control0 = controls[i / 4];
+    const uint8 control1 = controls[i / 4 + 1];
+    const char* data1 = data + tables.stream_length[control0];
+    Block block = ConcatVByteBlocks(LoadUnaligned<VByteBlock>(data),
+                                    LoadUnaligned<VByteBlock>(data1));
+    Block indices = ConcatVByteBlocks(tables.stream_shuffle[control0],
+                                      tables.stream_shuffle[control1]);
+    StoreUnaligned(bit_cast<uint32>(lookup(block, indices)), out + i);
+    data = data1 + tables.stream_length[control1];
+  }
+  return i;
+}
+
+inline size_t StreamVByteDecodePairs(const uint8*, const char*&, const char*,
+                                     size_t, uint32*,
+                                     std::false_type /* native 32 bytes */) {
+  return 0;
+}
+
+// Decodes Stream VByte groups. With kDelta, the values are the prefix sums of
+// the decoded ones. Returns a pointer past the data bytes, or nullptr if
+// [begin, end) is too short.
+template <bool kDelta>
+const char* StreamVByteDecode(const char* begin, const char* end, size_t n,
+                              uint32* out) {
+  const size_t num_controls = (n + 3) / 4;
+  if (static_cast<size_t>(end - begin) < num_controls) return nullptr;
+  const uint8* controls = reinterpret_cast<const uint8*>(begin);
+  const char* data = begin + num_controls;
+  const VByteTables& tables = GetVByteTables();
+  VByteValues prev(0);
+  size_t i = 0;
+  // The prefix sum of the delta variant would cross the 16-byte segments.
+  if (!kDelta) {
+    i = StreamVByteDecodePairs(
+        controls, data, end, n, out,
+        std::integral_constant<bool, NativeSimd<uint8>::size() >= 32>());
+  }
+  // A group reads 16 data bytes, of which it uses at most 16.
+  for (; i + 4 <= n && end - data >= 16; i += 4) {
+    const uint8 control = controls[i / 4];
+    VByteValues values = bit_cast<uint32>(lookup(
+        LoadUnaligned<VByteBlock>(data), tables.stream_shuffle[control]));
+    if (kDelta) {
+      values = PrefixSumVByte(values, prev);
+      prev = BroadcastLastVByteLane(values);
+    }
+    StoreUnaligned(values, out + i);
+    data += tables.stream_length[control];
+  }
+  uint32 last = kDelta ? prev[0] : 0;
+  for (; i < n; i++) {
+    const int length = (controls[i / 4] >> (2 * (i % 4)) & 3) + 1;
+    if (end - data < length) return nullptr;
+    uint32 value = 0;
+    memcpy(&value, data, length);
+    data += length;
+    if (kDelta) value = last += value;
+    out[i] = value;
+  }
+  return data;
+}
+
+// Decodes one varint of at most 5 bytes. Returns a pointer past it, or nullptr
+// if it is truncated or does not fit in uint32.
+inline const char* VarintDecodeSlow(const char* begin, const char* end,
+                                    uint32* value) {
+  uint32 result = 0;
+  for (int shift = 0; shift < 35 && begin < end; shift += 7) {
+    const uint8 byte = *begin++;
+    if (shift == 28 && byte > 0x0f) return nullptr;
+    result |= static_cast<uint32>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return begin;
+    }
+  }
+  return nullptr;
+}
+
+// Same as VarintDecodeSlow, when at least 8 bytes can be read at p and mask
+// has the continuation bits of the bytes at p. Branch-free but for validation.
+inline const char* VarintDecodeMasked(const char* p, uint64 mask,
+                                      uint32* value) {
+  const int length = __builtin_ctzll(~mask) + 1;
+  if (length > 5) return nullptr;
+  uint64 x;
+  memcpy(&x, p, sizeof(x));
+  x &= ~0ull >> (64 - 8 * length);
+  const uint64 result = (x & 0x7f) | (x >> 1 & 0x3f80) | (x >> 2 & 0x1fc000) |
+                        (x >> 3 & 0xfe00000) | (x >> 4 & 0x7f0000000ull);
+  if (result >> 32 != 0) return nullptr;
+  *value = static_cast<uint32>(result);
+  return p + length;
+}
+
+}  // namespace detail
+
+// Returns the largest number of bytes streamvbyte_encode() writes for n
+// values.
+inline size_t streamvbyte_max_encoded_size(size_t n) {
+  return (n + 3) / 4 + 4 * n;
+}
+
+// Encodes in[0, n) to out, which must have room for
+// streamvbyte_max_encoded_size(n) bytes. Returns the number of bytes written.
+inline size_t streamvbyte_encode(const uint32* in, size_t n, char* out) {
+  const size_t num_controls = (n + 3) / 4;
+  memset(out, 0, num_controls);
+  char* data = out + num_controls;
+  for (size_t i = 0; i < n; i++) {
+    const size_t length = detail::StreamVByteLength(in[i]);
+    out[i / 4] |= (length - 1) << (2 * (i % 4));
+    memcpy(data, &in[i], length);
+    data += length;
+  }
+  return data - out;
+}
+
+// Same as streamvbyte_encode, but encodes the differences in[i] - in[i - 1]
+// (modulo 2^32), with in[-1] = 0. Sorted inputs have small differences.
+inline size_t streamvbyte_encode_delta(const uint32* in, size_t n, char* out) {
+  const size_t num_controls = (n + 3) / 4;
+  memset(out, 0, num_controls);
+  char* data = out + num_controls;
+  uint32 prev = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint32 delta = in[i] - prev;
+    prev = in[i];
+    const size_t length = detail::StreamVByteLength(delta);
+    out[i / 4] |= (length - 1) << (2 * (i % 4));
+    memcpy(data, &delta, length);
+    data += length;
+  }
+  return data - out;
+}
+
+// Decodes n values encoded by streamvbyte_encode from [begin, end) to out.
+// Returns a pointer past the encoded values, or nullptr if [begin, end) is
+// too short.
+inline const char* streamvbyte_decode(const char* begin, const char* end,
+                                      size_t n, uint32* out) {
+  return detail::StreamVByteDecode<false>(begin, end, n, out);
+}
+
+// Same as streamvbyte_decode, for streamvbyte_encode_delta.
+inline const char* streamvbyte_decode_delta(const char* begin, const char* end,
+                                            size_t n, uint32* out) {
+  return detail::StreamVByteDecode<true>(begin, end, n, out);
+}
+
+// Encodes in[0, n) as LEB128 varints to out, which must have room for 5 * n
+// bytes. Returns the number of bytes written.
+inline size_t varint_encode(const uint32* in, size_t n, char* out) {
+  char* p = out;
+  for (size_t i = 0; i < n; i++) {
+    uint32 value = in[i];
+    while (value >= 0x80) {
+      *p++ = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+  }
+  return p - out;
+}
+
+// Decodes n LEB128 varints from [begin, end) to out. Returns a pointer past
+// the last one, or nullptr if the input is truncated or has a value that does
+// not fit in uint32.
+inline const char* varint_decode(const char* begin, const char* end, size_t n,
+                                 uint32* out) {
+  using detail::VByteBlock;
+  using detail::VByteValues;
+  const detail::VByteTables& tables = detail::GetVByteTables();
+  uint32* const out_end = out + n;
+  // The continuation bits of 64 bytes are computed at once, so that only the
+  // table lookup of the length is on the dependency chain between steps.
+  while (end - begin >= 64 && out_end - out >= 16) {
+    uint64 mask = 0;
+    for (int k = 0; k < 4; k++) {
+      mask |= static_cast<uint64>(static_cast<uint16>(x86::movemask(
+                  detail::LoadUnaligned<VByteBlock>(begin + 16 * k))))
+              << 16 * k;
+    }
+    // A step uses at most 16 bits of the mask.
+    const char* const last = begin + 48;
+    while (begin <= last && out_end - out >= 16) {
+      const char* next;
+      if ((mask & 0xffff) == 0) {
+        VByteBlock block = detail::LoadUnaligned<VByteBlock>(begin);
+        for (int k = 0; k < 4; k++) {
+          detail::StoreUnaligned(
+              bit_cast<uint32>(lookup(block, tables.widen[k])), out + 4 * k);
+        }
+        out += 16;
+        next = begin + 16;
+      } else if (tables.varint_count[mask & 0xff] == 0) {
+        // A value of 5 bytes, or of 4 that doesn't end in the first 8 bytes.
+        next = detail::VarintDecodeMasked(begin, mask, out++);
+        if (next == nullptr) return nullptr;
+      } else {
+        const int first = mask & 0xff;
+        VByteValues x = bit_cast<uint32>(
+            lookup(detail::LoadUnaligned<VByteBlock>(begin),
+                   tables.varint_shuffle[first]));
+        x = (x & VByteValues(0x7f)) | (x >> 1 & VByteValues(0x7f << 7)) |
+            (x >> 2 & VByteValues(0x7f << 14)) |
+            (x >> 3 & VByteValues(0x7f << 21));
+        detail::StoreUnaligned(x, out);
+        out += tables.varint_count[first];
+        next = begin + tables.varint_length[first];
+      }
+      mask >>= next - begin;
+      begin = next;
+    }
+  }
+  while (out < out_end) {
+    begin = detail::VarintDecodeSlow(begin, end, out++);
+    if (begin == nullptr) return nullptr;
+  }
+  return begin;
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_VARINT_H_
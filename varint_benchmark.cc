@@ -0,0 +1,124 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "varint.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kNumValues = 1 << 16;
+
+// Values with up to range(0) significant bits.
+std::vector<uint32> RandomValues(const benchmark::State& state) {
+  std::mt19937 rng(0);
+  const int bits = state.range(0);
+  std::vector<uint32> values(kNumValues);
+  for (uint32& value : values) {
+    value = bits == 32 ? rng() : rng() & ((1u << bits) - 1);
+  }
+  return values;
+}
+
+// Sorted ids with an average gap of 2^range(0) / 2.
+std::vector<uint32> RandomIds(const benchmark::State& state) {
+  std::vector<uint32> ids = RandomValues(state);
+  uint32 id = 0;
+  for (uint32& value : ids) value = id += value;
+  return ids;
+}
+
+// Byte-at-a-time LEB128 decoding, the baseline.
+const char* ScalarVarintDecode(const char* p, size_t n, uint32* out) {
+  for (size_t i = 0; i < n; i++) {
+    uint32 value = 0;
+    for (int shift = 0;; shift += 7) {
+      const uint8 byte = *p++;
+      value |= static_cast<uint32>(byte & 0x7f) << shift;
+      if (byte < 0x80) break;
+    }
+    out[i] = value;
+  }
+  return p;
+}
+
+void BM_ScalarVarintDecode(benchmark::State& state) {
+  std::vector<uint32> values = RandomValues(state);
+  std::string encoded(5 * kNumValues, '\0');
+  encoded.resize(varint_encode(values.data(), kNumValues, &encoded[0]));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ScalarVarintDecode(encoded.data(), kNumValues, values.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_ScalarVarintDecode)->Arg(7)->Arg(14)->Arg(21)->Arg(32);
+
+void BM_VarintDecode(benchmark::State& state) {
+  std::vector<uint32> values = RandomValues(state);
+  std::string encoded(5 * kNumValues, '\0');
+  encoded.resize(varint_encode(values.data(), kNumValues, &encoded[0]));
+  const char* end = encoded.data() + encoded.size();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        varint_decode(encoded.data(), end, kNumValues, values.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_VarintDecode)->Arg(7)->Arg(14)->Arg(21)->Arg(32);
+
+void BM_StreamVByteEncode(benchmark::State& state) {
+  std::vector<uint32> values = RandomValues(state);
+  std::string encoded(streamvbyte_max_encoded_size(kNumValues), '\0');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        streamvbyte_encode(values.data(), kNumValues, &encoded[0]));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_StreamVByteEncode)->Arg(8)->Arg(32);
+
+void BM_StreamVByteDecode(benchmark::State& state) {
+  std::vector<uint32> values = RandomValues(state);
+  std::string encoded(streamvbyte_max_encoded_size(kNumValues), '\0');
+  encoded.resize(streamvbyte_encode(values.data(), kNumValues, &encoded[0]));
+  const char* end = encoded.data() + encoded.size();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        streamvbyte_decode(encoded.data(), end, kNumValues, values.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_StreamVByteDecode)->Arg(8)->Arg(16)->Arg(32);
+
+void BM_StreamVByteDecodeDelta(benchmark::State& state) {
+  std::vector<uint32> ids = RandomIds(state);
+  std::string encoded(streamvbyte_max_encoded_size(kNumValues), '\0');
+  encoded.resize(
+      streamvbyte_encode_delta(ids.data(), kNumValues, &encoded[0]));
+  const char* end = encoded.data() + encoded.size();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        streamvbyte_decode_delta(encoded.data(), end, kNumValues, ids.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+BENCHMARK(BM_StreamVByteDecodeDelta)->Arg(8)->Arg(16);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,159 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "varint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Values of 1 to 5 varint bytes, with the given mix of lengths: the value i
+// has about max_bits[i % max_bits.size()] significant bits.
+std::vector<uint32> RandomValues(size_t n, const std::vector<int>& max_bits,
+                                 std::mt19937* rng) {
+  std::vector<uint32> values(n);
+  for (size_t i = 0; i < n; i++) {
+    const int bits = max_bits[(*rng)() % max_bits.size()];
+    values[i] = bits == 32 ? (*rng)() : (*rng)() & ((1u << bits) - 1);
+  }
+  return values;
+}
+
+const std::vector<std::vector<int>>& BitMixes() {
+  static const std::vector<std::vector<int>> mixes = {
+      {7}, {8}, {14}, {16}, {7, 14}, {21, 28}, {32}, {1, 8, 16, 24, 32},
+      {7, 7, 7, 7, 7, 7, 7, 14}};
+  return mixes;
+}
+
+TEST(StreamVByteTest, Format) {
+  const uint32 values[5] = {1, 0x100, 0x10000, 0x1000000, 0xff};
+  char out[32];
+  const size_t size = streamvbyte_encode(values, 5, out);
+  ASSERT_EQ(2u + 1 + 2 + 3 + 4 + 1, size);
+  EXPECT_EQ(static_cast<char>(0xe4), out[0]);
+  EXPECT_EQ(0, out[1]);
+  EXPECT_EQ(std::string("\x01\x00\x01\x00\x00\x01\x00\x00\x00\x01\xff", 11),
+            std::string(out + 2, size - 2));
+}
+
+TEST(StreamVByteTest, RoundTrip) {
+  std::mt19937 rng(0);
+  for (const std::vector<int>& mix : BitMixes()) {
+    for (size_t n : {0, 1, 3, 4, 5, 17, 100, 1001}) {
+      std::vector<uint32> values = RandomValues(n, mix, &rng);
+      std::string encoded(streamvbyte_max_encoded_size(n), '\0');
+      const size_t size = streamvbyte_encode(values.data(), n, &encoded[0]);
+      encoded.resize(size);
+      // Exact size buffers, so that overreads are caught by sanitizers.
+      std::unique_ptr<char[]> in(new char[size]);
+      memcpy(in.get(), encoded.data(), size);
+      std::vector<uint32> decoded(n);
+      EXPECT_EQ(in.get() + size,
+                streamvbyte_decode(in.get(), in.get() + size, n,
+                                   decoded.data()));
+      EXPECT_EQ(values, decoded);
+      for (size_t truncated : {size_t{0}, size / 2, size - 1}) {
+        if (truncated < size) {
+          EXPECT_EQ(nullptr, streamvbyte_decode(in.get(), in.get() + truncated,
+                                                n, decoded.data()));
+        }
+      }
+    }
+  }
+}
+
+TEST(StreamVByteTest, DeltaRoundTrip) {
+  std::mt19937 rng(0);
+  for (size_t n : {0, 1, 4, 7, 100, 1001}) {
+    std::vector<uint32> values = RandomValues(n, {32}, &rng);
+    std::sort(values.begin(), values.end());
+    values.resize(n / 2);
+    // Also wrapping differences.
+    for (size_t i = 0; i < n - n / 2; i++) values.push_back(rng());
+    std::string encoded(streamvbyte_max_encoded_size(n), '\0');
+    const size_t size =
+        streamvbyte_encode_delta(values.data(), n, &encoded[0]);
+    std::vector<uint32> decoded(n);
+    EXPECT_EQ(encoded.data() + size,
+              streamvbyte_decode_delta(encoded.data(), encoded.data() + size,
+                                       n, decoded.data()));
+    EXPECT_EQ(values, decoded);
+  }
+  // Sorted inputs with small gaps take about one byte per value.
+  std::vector<uint32> ids(1000);
+  for (size_t i = 0; i < ids.size(); i++) ids[i] = 1000000 + 3 * i;
+  std::string encoded(streamvbyte_max_encoded_size(ids.size()), '\0');
+  EXPECT_EQ(250u + 3 + 999,
+            streamvbyte_encode_delta(ids.data(), ids.size(), &encoded[0]));
+}
+
+TEST(VarintTest, Format) {
+  const uint32 values[4] = {0, 0x7f, 300, 0xffffffff};
+  char out[20];
+  const size_t size = varint_encode(values, 4, out);
+  EXPECT_EQ(std::string("\x00\x7f\xac\x02\xff\xff\xff\xff\x0f", 9),
+            std::string(out, size));
+}
+
+TEST(VarintTest, RoundTrip) {
+  std::mt19937 rng(0);
+  for (const std::vector<int>& mix : BitMixes()) {
+    for (size_t n : {0, 1, 3, 4, 15, 16, 17, 100, 1001}) {
+      std::vector<uint32> values = RandomValues(n, mix, &rng);
+      std::string encoded(5 * n, '\0');
+      const size_t size = varint_encode(values.data(), n, &encoded[0]);
+      std::unique_ptr<char[]> in(new char[size]);
+      memcpy(in.get(), encoded.data(), size);
+      std::vector<uint32> decoded(n);
+      EXPECT_EQ(in.get() + size,
+                varint_decode(in.get(), in.get() + size, n, decoded.data()));
+      EXPECT_EQ(values, decoded);
+      if (size > 0) {
+        EXPECT_EQ(nullptr, varint_decode(in.get(), in.get() + size - 1, n,
+                                         decoded.data()));
+      }
+    }
+  }
+}
+
+TEST(VarintTest, Invalid) {
+  uint32 value;
+  // Too many bytes, or more than 32 bits.
+  std::string six_bytes("\x80\x80\x80\x80\x80\x00", 6);
+  EXPECT_EQ(nullptr, varint_decode(six_bytes.data(),
+                                   six_bytes.data() + six_bytes.size(), 1,
+                                   &value));
+  std::string too_large("\xff\xff\xff\xff\x10", 5);
+  EXPECT_EQ(nullptr, varint_decode(too_large.data(),
+                                   too_large.data() + too_large.size(), 1,
+                                   &value));
+  // The same, in the middle of a long input.
+  std::string input(40, '\x01');
+  input.replace(5, 5, too_large);
+  std::vector<uint32> values(36);
+  EXPECT_EQ(nullptr, varint_decode(input.data(), input.data() + input.size(),
+                                   values.size(), values.data()));
+}
+
+}  // namespace
+}  // namespace dimsum